@@ -3625,6 +3625,176 @@ int ret = 0;
 	return ret;
 }
 
+struct test49_exec {
+	int calls, jobs;
+};
+
+/* An executor which runs the jobs of a batch backwards, so that any
+   dependence on jobs being run in order will show up. */
+static int test49_exec (void * ctx, bNjob job, void * parm, int qty) {
+struct test49_exec * e = (struct test49_exec *) ctx;
+int i;
+	e->calls++;
+	for (i = qty - 1; i >= 0; i--) {
+		job (parm, i);
+		e->jobs++;
+	}
+	return 0;
+}
+
+static int test49_fail (void * ctx, bNjob job, void * parm, int qty) {
+	ctx = ctx;
+	job = job;
+	parm = parm;
+	qty = qty;
+	return -1;
+}
+
+static void test49_job (void * parm, int idx) {
+	((int *) parm)[idx] += idx + 1;
+}
+
+static int test49 (void) {
+struct test49_exec e = { 0, 0 };
+int v[100];
+int ret = 0;
+int i;
+
+	printf ("TEST: bexecute, bsetexecutor, bexecconcurrency.\n");
+
+	ret += BSTR_ERR != bexecute (NULL, v, 1);
+	ret += BSTR_ERR != bexecute (test49_job, v, -1);
+	ret += BSTR_OK != bexecute (test49_job, v, 0);
+	ret += BSTR_ERR != bsetexecutor (test49_exec, &e, 0);
+	ret += BSTR_ERR != bsetexecutor (test49_exec, &e, -1);
+	ret += BSTR_ERR != bsetthreads (-1);
+
+	for (i = 0; i < 100; i++) v[i] = 0;
+	ret += BSTR_OK != bexecute (test49_job, v, 100);
+	for (i = 0; i < 100; i++) ret += v[i] != i + 1;
+
+	ret += BSTR_OK != bsetexecutor (test49_exec, &e, 4);
+	ret += 4 != bexecconcurrency ();
+	ret += BSTR_OK != bexecute (test49_job, v, 100);
+	for (i = 0; i < 100; i++) ret += v[i] != 2 * (i + 1);
+	ret += 1 != e.calls || 100 != e.jobs;
+
+	/* A single job is not worth handing to the executor */
+	ret += BSTR_OK != bexecute (test49_job, v, 1);
+	ret += 1 != e.calls || 3 != v[0];
+
+	/* A failing executor leaves the jobs to be run by the caller */
+	ret += BSTR_OK != bsetexecutor (test49_fail, NULL, 2);
+	ret += BSTR_OK != bexecute (test49_job, v, 100);
+	for (i = 1; i < 100; i++) ret += v[i] != 3 * (i + 1);
+
+	ret += BSTR_OK != bsetexecutor (NULL, NULL, 0);
+	ret += 1 > bexecconcurrency ();
+	ret += BSTR_OK != bexecshutdown ();
+
+	printf ("\t# failures: %d\n", ret);
+	return ret;
+}
+
+static int test50 (void) {
+struct test49_exec e = { 0, 0 };
+struct tagbstring aa = bsStatic ("aa");
+struct tagbstring c = bsStatic ("c");
+static const char * cases[][2] = {
+	{ "aa", "b" }, { "ab", "ba" }, { "a", "xyz" }, { "aba", "" },
+	{ "bab", "abab" }, { "aaaa", "AAAA" }, { "b", "bb" }, { "Ab", "c" }
+};
+bstring src, b0, b1, f, r;
+unsigned int seed = 1;
+int ret = 0;
+int i, k;
+
+	printf ("TEST: bfindreplace, bfindreplacecaseless on large strings.\n");
+
+	/* Random a/b text with a long run of a's in the middle, so that
+	   matches straddle chunk boundaries at every possible phase */
+	src = bfromcstralloc (320000, "");
+	for (i = 0; i < 300000; i++) {
+		seed = seed * 1103515245u + 12345u;
+		bconchar (src, (char) ((((seed >> 16) & 7) < 5) ? 'a' : 'b'));
+	}
+	binsertch (src, 100000, 100003, 'a');
+
+	for (k = 0; k < (int) (sizeof (cases) / sizeof (cases[0])); k++) {
+		f = bfromcstr (cases[k][0]);
+		r = bfromcstr (cases[k][1]);
+		for (i = 0; i < 4; i++) {
+			b0 = bstrcpy (src);
+			b1 = bstrcpy (src);
+			ret += BSTR_OK != bsetexecutor (NULL, NULL, 0);
+			if (i & 2) ret += BSTR_OK != bfindreplacecaseless (b0, f, r, i * 3);
+			else ret += BSTR_OK != bfindreplace (b0, f, r, i * 3);
+			ret += BSTR_OK != bsetexecutor (test49_exec, &e, 3);
+			if (i & 2) ret += BSTR_OK != bfindreplacecaseless (b1, f, r, i * 3);
+			else ret += BSTR_OK != bfindreplace (b1, f, r, i * 3);
+			ret += 1 != biseq (b0, b1);
+			ret += b1->mlen <= b1->slen || '\0' != b1->data[b1->slen];
+			bdestroy (b0);
+			bdestroy (b1);
+		}
+		bdestroy (f);
+		bdestroy (r);
+	}
+	ret += 0 == e.calls;
+
+	/* Short strings are not worth splitting */
+	e.calls = 0;
+	b0 = bfromcstr ("abaabaaab");
+	ret += BSTR_OK != bfindreplace (b0, &aa, &c, 0);
+	ret += 1 != biseqcstr (b0, "abcbcab") || 0 != e.calls;
+	bdestroy (b0);
+
+	ret += BSTR_OK != bsetexecutor (NULL, NULL, 0);
+	bdestroy (src);
+
+	printf ("\t# failures: %d\n", ret);
+	return ret;
+}
+
+static int test51 (void) {
+struct tagbstring line = bsStatic ("a\tbb\t\tdddd\te");
+struct tagbstring empty = bsStatic ("");
+struct tagbstring t, v[4];
+static const int k[4] = { 1, 2, 3, 7 };
+static const int bad[2] = { 2, 2 };
+struct bstrList * sl;
+int i, j, ret = 0;
+
+	printf ("TEST: bfield, bfields.\n");
+
+	sl = bsplit (&line, '\t');
+	for (i = 0; i < sl->qty; i++) {
+		j = bfield (&t, &line, '\t', i);
+		ret += j < 0 || t.data != line.data + j || t.mlen != -1;
+		ret += 1 != biseq (&t, sl->entry[i]);
+	}
+	ret += BSTR_ERR != bfield (&t, &line, '\t', sl->qty);
+	ret += 0 != t.slen;
+	bstrListDestroy (sl);
+
+	ret += 0 != bfield (&t, &empty, ',', 0) || 0 != t.slen;
+	ret += BSTR_ERR != bfield (&t, &empty, ',', 1);
+	ret += BSTR_ERR != bfield (&t, NULL, ',', 0);
+	ret += BSTR_ERR != bfield (&t, &line, '\t', -1);
+
+	ret += 3 != bfields (v, &line, '\t', k, 4);
+	ret += 1 != biseqcstr (&v[0], "bb");
+	ret += 1 != biseqcstr (&v[1], "");
+	ret += 1 != biseqcstr (&v[2], "dddd");
+	ret += 0 != v[3].slen;
+	ret += 2 != bfields (v, &line, '\t', k, 2);
+	ret += 0 != bfields (v, &line, '\t', k, 0);
+	ret += BSTR_ERR != bfields (v, &line, '\t', bad, 2);
+
+	printf ("\t# failures: %d\n", ret);
+	return ret;
+}
+
 int main (int argc, char * argv[]) {
 int ret = 0;
 
@@ -3682,6 +3852,9 @@ int ret = 0;
 	ret += test46 ();
 	ret += test47 ();
 	ret += test48 ();
+	ret += test49 ();
+	ret += test50 ();
+	ret += test51 ();
 
 	printf ("# test failures: %d\n", ret);
 
@@ -19,6 +19,7 @@
 #endif
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
@@ -757,6 +758,101 @@ unsigned int c0, c1, c2;
 	return out;
 }
 
+/*
+ *  yEnc.  The kernels below add (or subtract) 42 from a machine word of
+ *  bytes at a time, without carries between the bytes, and use word wide
+ *  compares to find the few bytes that need to be escaped.  Words with none
+ *  are moved in a single store.  See: http://www.yenc.org/whatis.htm and
+ *  http://www.yenc.org/yenc-draft.1.3.txt
+ */
+#define BY_WORD          unsigned long
+#define BY_WSZ           ((int) sizeof (BY_WORD))
+#define BY_ONES          (((BY_WORD) ~(BY_WORD) 0) / 0xFF)
+#define BY_HIGH          (BY_ONES << 7)
+#define BY_HASZERO(x)    (((x) - BY_ONES) & ~(x) & BY_HIGH)
+#define BY_HASBYTE(x,c)  BY_HASZERO ((x) ^ (BY_ONES * (c)))
+#define BY_ADD42(x)      ((((x) & ~BY_HIGH) + BY_ONES * 42) ^ ((x) & BY_HIGH))
+#define BY_SUB42(x)      ((((x) | BY_HIGH) - BY_ONES * 42) ^ (~(x) & BY_HIGH))
+
+/* Encode len bytes of d into o, which must have room for bYEncMax (len,
+   lineLen) bytes, returning the number of bytes written.  With a lineLen
+   greater than 0, lines are broken with CRLF once they reach lineLen
+   characters, and a TAB or space in the first or last column, or a '.' in
+   the first column, is escaped as well. */
+static int bYEnc (unsigned char * o, const unsigned char * d, int len, int lineLen) {
+int i, j, col, L, e;
+BY_WORD w;
+unsigned char c;
+
+	L = (lineLen > 0) ? lineLen : INT_MAX;
+	e = (lineLen > 0) ? len - 1 : len;
+	for (col = 0, i = j = 0; i < len; i++) {
+		/* Whole words which land strictly inside a line */
+		while (i + BY_WSZ <= e && col > 0 && col <= L - BY_WSZ - 1) {
+			memcpy (&w, d + i, sizeof (w));
+			w = BY_ADD42 (w);
+			if (BY_HASZERO (w) | BY_HASBYTE (w, '=') | BY_HASBYTE (w, '\r') |
+			    BY_HASBYTE (w, '\n')) break;
+			memcpy (o + j, &w, sizeof (w));
+			i += BY_WSZ;
+			j += BY_WSZ;
+			col += BY_WSZ;
+		}
+		if (i >= len) break;
+
+		if (col >= L) {
+			o[j++] = (unsigned char) '\r';
+			o[j++] = (unsigned char) '\n';
+			col = 0;
+		}
+		c = (unsigned char) (d[i] + 42);
+		if (c == '=' || c == '\0' || c == '\r' || c == '\n' ||
+		    (lineLen > 0 && (((c == '\t' || c == ' ') &&
+		                      (col == 0 || col == L - 1 || i == len - 1)) ||
+		                     (c == '.' && col == 0)))) {
+			o[j++] = (unsigned char) '=';
+			c = (unsigned char) (c + 64);
+			col++;
+		}
+		o[j++] = c;
+		col++;
+	}
+	return j;
+}
+
+/* The worst case size of the yEnc encoding of len bytes, or -1 if it would
+   not fit in an int. */
+static int bYEncMax (int len, int lineLen) {
+size_t n = 2 * (size_t) len;
+
+	/* Every line but the last holds at least lineLen bytes */
+	if (lineLen > 0) n += 2 * (n / (size_t) lineLen);
+	if (n >= (size_t) INT_MAX) return -1;
+	return (int) n;
+}
+
+/*  bstring bYEncodeLines (const_bstring src, int lineLen)
+ *
+ *  Performs a YEncode of a block of data, breaking the output with CRLF
+ *  into lines of lineLen characters (lineLen + 1 if the line ends with an
+ *  escape.)  As the yEnc draft suggests, a TAB or space at the start or end
+ *  of a line and a '.' at the start of a line are escaped.  No final CRLF,
+ *  header or tail info is appended.  If lineLen is 0 the output is not
+ *  broken into lines, and is the same as that of bYEncode.
+ */
+bstring bYEncodeLines (const_bstring src, int lineLen) {
+bstring out;
+int n;
+
+	if (src == NULL || src->slen < 0 || src->data == NULL || lineLen < 0)
+		return NULL;
+	if (0 > (n = bYEncMax (src->slen, lineLen))) return NULL;
+	if (NULL == (out = bfromcstralloc (n + 1, ""))) return NULL;
+	out->slen = bYEnc (out->data, src->data, src->slen, lineLen);
+	out->data[out->slen] = (unsigned char) '\0';
+	return out;
+}
+
 /*  bstring bYEncode (const_bstring src)
  *
  *  Performs a YEncode of a block of data.  No header or tail info is 
@@ -764,27 +860,55 @@ unsigned int c0, c1, c2;
  *  http://www.yenc.org/yenc-draft.1.3.txt
  */
 bstring bYEncode (const_bstring src) {
-int i;
-bstring out;
+	return bYEncodeLines (src, 0);
+}
+
+/* Check that the yEnc data d neither ends in a dangling '=' nor contains a
+   NUL which is not escaped.  Since a byte other than '=' always ends a
+   symbol, a '=' escapes what follows it exactly if the run of '='s which
+   it ends has odd length. */
+static int bYDecCheck (const unsigned char * d, int len) {
+const unsigned char * p, * q;
+int k;
+
+	for (k = 0; k < len && d[len - 1 - k] == '='; k++) {}
+	if (k & 1) return -1;
+	for (p = d; NULL != (q = (const unsigned char *) memchr (p, '\0', (size_t) (len - (p - d)))); p = q + 1) {
+		for (k = 0; q - k > d && q[-1 - k] == '='; k++) {}
+		if (0 == (k & 1)) return -1;
+	}
+	return 0;
+}
+
+/* Decode len bytes of d, which has passed bYDecCheck, into o, returning the
+   number of bytes written.  Output never runs ahead of input, so o may be
+   the same as d. */
+static int bYDec (unsigned char * o, const unsigned char * d, int len) {
+int i, j;
+BY_WORD w;
 unsigned char c;
 
-	if (src == NULL || src->slen < 0 || src->data == NULL) return NULL;
-	if ((out = bfromcstr ("")) == NULL) return NULL;
-	for (i=0; i < src->slen; i++) {
-		c = (unsigned char)(src->data[i] + 42);
-		if (c == '=' || c == '\0' || c == '\r' || c == '\n') {
-			if (0 > bconchar (out, (char) '=')) {
-				bdestroy (out);
-				return NULL;
-			}
-			c += (unsigned char) 64;
+	for (i = j = 0; i < len; i++) {
+		while (i + BY_WSZ <= len) {
+			memcpy (&w, d + i, sizeof (w));
+			if (BY_HASZERO (w) | BY_HASBYTE (w, '=') | BY_HASBYTE (w, '\r') |
+			    BY_HASBYTE (w, '\n')) break;
+			w = BY_SUB42 (w);
+			memcpy (o + j, &w, sizeof (w));
+			i += BY_WSZ;
+			j += BY_WSZ;
 		}
-		if (0 > bconchar (out, c)) {
-			bdestroy (out);
-			return NULL;
+		if (i >= len) break;
+
+		if ('=' == (c = d[i])) { /* The = escape mode */
+			i++;
+			c = (unsigned char) (d[i] - 64);
+		} else if (c == '\r' || c == '\n') {
+			continue; /* Extraneous CR/LFs are to be ignored. */
 		}
+		o[j++] = (unsigned char) (c - 42);
 	}
-	return out;
+	return j;
 }
 
 /*  bstring bYDecode (const_bstring src)
@@ -792,57 +916,33 @@ unsigned char c;
  *  Performs a YDecode of a block of data.  See: 
  *  http://www.yenc.org/whatis.htm and http://www.yenc.org/yenc-draft.1.3.txt
  */
-#define MAX_OB_LEN (64)
-
 bstring bYDecode (const_bstring src) {
-int i;
 bstring out;
-unsigned char c;
-unsigned char octetbuff[MAX_OB_LEN];
-int obl;
 
 	if (src == NULL || src->slen < 0 || src->data == NULL) return NULL;
-	if ((out = bfromcstr ("")) == NULL) return NULL;
-
-	obl = 0;
-
-	for (i=0; i < src->slen; i++) {
-		if ('=' == (c = src->data[i])) { /* The = escape mode */
-			i++;
-			if (i >= src->slen) {
-				bdestroy (out);
-				return NULL;
-			}
-			c = (unsigned char) (src->data[i] - 64);
-		} else {
-			if ('\0' == c) {
-				bdestroy (out);
-				return NULL;
-			}
-
-			/* Extraneous CR/LFs are to be ignored. */
-			if (c == '\r' || c == '\n') continue;
-		}
-
-		octetbuff[obl] = (unsigned char) ((int) c - 42);
-		obl++;
-
-		if (obl >= MAX_OB_LEN) {
-			if (0 > bcatblk (out, octetbuff, obl)) {
-				bdestroy (out);
-				return NULL;
-			}
-			obl = 0;
-		}
-	}
-
-	if (0 > bcatblk (out, octetbuff, obl)) {
-		bdestroy (out);
-		out = NULL;
-	}
+	if (0 > bYDecCheck (src->data, src->slen)) return NULL;
+	if (NULL == (out = bfromcstralloc (src->slen + 1, ""))) return NULL;
+	out->slen = bYDec (out->data, src->data, src->slen);
+	out->data[out->slen] = (unsigned char) '\0';
 	return out;
 }
 
+/*  int bYDecodeInPlace (bstring b)
+ *
+ *  Performs a YDecode of the contents of b, replacing them with the
+ *  decoded data.  If b is not valid yEnc data (it contains an unescaped
+ *  NUL or ends with an incomplete escape) BSTR_ERR is returned and b is
+ *  left unchanged.
+ */
+int bYDecodeInPlace (bstring b) {
+	if (b == NULL || b->slen < 0 || b->mlen <= 0 || b->mlen < b->slen ||
+	    b->data == NULL) return BSTR_ERR;
+	if (0 > bYDecCheck (b->data, b->slen)) return BSTR_ERR;
+	b->slen = bYDec (b->data, b->data, b->slen);
+	b->data[b->slen] = (unsigned char) '\0';
+	return BSTR_OK;
+}
+
 /*  int bSGMLEncode (bstring b)
  *
  *  Change the string into a version that is quotable in SGML (HTML, XML).
@@ -1013,6 +1113,7 @@ struct bwriteStream {
     bNwrite writeFn; /* fwrite work-a-like fnptr for core stream */
     int isEOF;       /* track stream's EOF state                 */
     int minBuffSz;
+    unsigned long * crc; /* CRC-32C of data written out          */
 };
 
 /*  struct bwriteStream * bwsOpen (bNwrite writeFn, void * parm)
@@ -1035,6 +1136,7 @@ struct bwriteStream * ws;
 			ws->writeFn = writeFn;
 			ws->isEOF = 0;
 			ws->minBuffSz = BWS_BUFF_SZ;
+			ws->crc = NULL;
 		}
 	}
 	return ws;
@@ -1046,6 +1148,7 @@ struct bwriteStream * ws;
 			ws->isEOF = 1; \
 			return BSTR_ERR; \
 		} \
+		if (ws->crc) *ws->crc = bcrc32cblk (*ws->crc, (b)->data, (b)->slen); \
 	} \
 }
 
@@ -1159,3 +1262,3490 @@ void * parm;
 	free (ws);
 	return parm;
 }
+
+#define BSTRCOL_MIN_QTY (8)
+
+/*  struct bstrColumn * bstrColumnCreate (void)
+ *
+ *  Create an empty columnar string container.  The entries of a struct
+ *  bstrColumn are stored back to back in the single bstring blob, and entry
+ *  i occupies the byte range offsets[i] to offsets[i+1]-1 of blob->data.
+ *  The offsets array always has qty+1 valid elements, with offsets[0] == 0.
+ *  This is the same layout as the Arrow binary/utf8 (32 bit offset)
+ *  columnar format, so the offsets and blob->data buffers can be handed
+ *  directly to code that consumes that format.
+ */
+struct bstrColumn * bstrColumnCreate (void) {
+struct bstrColumn * c;
+
+	c = (struct bstrColumn *) malloc (sizeof (struct bstrColumn));
+	if (NULL == c) return NULL;
+	c->offsets = (int *) malloc ((BSTRCOL_MIN_QTY + 1) * sizeof (int));
+	if (NULL == c->offsets || NULL == (c->blob = bfromcstralloc (64, ""))) {
+		free (c->offsets);
+		free (c);
+		return NULL;
+	}
+	c->offsets[0] = 0;
+	c->qty = 0;
+	c->mlen = BSTRCOL_MIN_QTY;
+	return c;
+}
+
+/*  int bstrColumnDestroy (struct bstrColumn * c)
+ *
+ *  Destroy a struct bstrColumn and the blob and offsets buffers it owns.
+ */
+int bstrColumnDestroy (struct bstrColumn * c) {
+	if (NULL == c || c->qty < 0 || NULL == c->offsets) return BSTR_ERR;
+	bdestroy (c->blob);
+	free (c->offsets);
+	c->qty = c->mlen = -1;
+	c->offsets = NULL;
+	c->blob = NULL;
+	free (c);
+	return BSTR_OK;
+}
+
+/*  int bstrColumnAlloc (struct bstrColumn * c, int qty, int blen)
+ *
+ *  Ensure that there is memory for at least qty entries holding a total of
+ *  blen bytes of string data in the column.
+ */
+int bstrColumnAlloc (struct bstrColumn * c, int qty, int blen) {
+int * o;
+int m;
+
+	if (NULL == c || NULL == c->offsets || c->qty < 0 || c->mlen < c->qty ||
+	    qty < 0 || blen < 0) return BSTR_ERR;
+	if (qty > c->mlen) {
+		for (m = c->mlen; m < qty; m += m) {
+			if (m > INT_MAX / 2) {
+				m = qty;
+				break;
+			}
+		}
+		if ((size_t) m + 1 > ((size_t) -1) / sizeof (int)) return BSTR_ERR;
+		o = (int *) realloc (c->offsets, ((size_t) m + 1) * sizeof (int));
+		if (NULL == o) return BSTR_ERR;
+		c->offsets = o;
+		c->mlen = m;
+	}
+	if (blen >= INT_MAX) return BSTR_ERR;
+	return balloc (c->blob, blen + 1);
+}
+
+/*  int bstrColumnAppendBlk (struct bstrColumn * c, const void * blk, int len)
+ *
+ *  Append the len bytes at blk as a new entry at the end of the column.
+ */
+int bstrColumnAppendBlk (struct bstrColumn * c, const void * blk, int len) {
+const unsigned char * s = (const unsigned char *) blk;
+ptrdiff_t pd;
+int e;
+
+	if (NULL == c || NULL == c->offsets || c->qty < 0 || len < 0 ||
+	    (NULL == blk && len > 0)) return BSTR_ERR;
+	e = c->offsets[c->qty];
+	if (len > INT_MAX - 1 - e || c->qty >= INT_MAX - 1) return BSTR_ERR;
+
+	/* Appending a part of the column to itself must survive a realloc */
+	pd = s - c->blob->data;
+	if (BSTR_OK != bstrColumnAlloc (c, c->qty + 1, e + len)) return BSTR_ERR;
+	if (len > 0 && pd >= 0 && pd < (ptrdiff_t) e) s = c->blob->data + pd;
+
+	if (len > 0) memmove (c->blob->data + e, s, (size_t) len);
+	c->blob->slen = e + len;
+	c->blob->data[c->blob->slen] = (unsigned char) '\0';
+	c->qty++;
+	c->offsets[c->qty] = e + len;
+	return BSTR_OK;
+}
+
+/*  int bstrColumnAppend (struct bstrColumn * c, const_bstring b)
+ *
+ *  Append a copy of the contents of b as a new entry at the end of the
+ *  column.
+ */
+int bstrColumnAppend (struct bstrColumn * c, const_bstring b) {
+	if (NULL == b || NULL == b->data || b->slen < 0) return BSTR_ERR;
+	return bstrColumnAppendBlk (c, b->data, b->slen);
+}
+
+/*  int bstrColumnEntry (struct tagbstring * t, const struct bstrColumn * c,
+ *                       int i)
+ *
+ *  Fill in t as a write protected reference to entry i of the column.  No
+ *  memory is allocated or copied, and the reference is only valid until the
+ *  column is next modified or destroyed.  Note that the referenced data is
+ *  not '\0' terminated.
+ */
+int bstrColumnEntry (struct tagbstring * t, const struct bstrColumn * c, int i) {
+	if (NULL == t || NULL == c || NULL == c->offsets ||
+	    (unsigned) i >= (unsigned) c->qty) return BSTR_ERR;
+	t->data = c->blob->data + c->offsets[i];
+	t->slen = c->offsets[i+1] - c->offsets[i];
+	t->mlen = -1;
+	return BSTR_OK;
+}
+
+/*  struct bstrColumn * bstrColumnFromList (const struct bstrList * sl)
+ *
+ *  Create a struct bstrColumn which contains a copy of each of the entries
+ *  of sl in the same order.  Both the offsets and blob are sized exactly
+ *  before any data is copied.
+ */
+struct bstrColumn * bstrColumnFromList (const struct bstrList * sl) {
+struct bstrColumn * c;
+int i, l;
+
+	if (NULL == sl || sl->qty < 0) return NULL;
+	for (l = i = 0; i < sl->qty; i++) {
+		if (NULL == sl->entry[i] || sl->entry[i]->slen < 0 ||
+		    sl->entry[i]->slen > INT_MAX - 1 - l) return NULL;
+		l += sl->entry[i]->slen;
+	}
+	if (NULL == (c = bstrColumnCreate ())) return NULL;
+	if (BSTR_OK != bstrColumnAlloc (c, sl->qty, l)) {
+		bstrColumnDestroy (c);
+		return NULL;
+	}
+	for (l = i = 0; i < sl->qty; i++) {
+		if (sl->entry[i]->slen > 0)
+			memcpy (c->blob->data + l, sl->entry[i]->data, sl->entry[i]->slen);
+		l += sl->entry[i]->slen;
+		c->offsets[i+1] = l;
+	}
+	c->qty = sl->qty;
+	c->blob->slen = l;
+	c->blob->data[l] = (unsigned char) '\0';
+	return c;
+}
+
+/*  struct bstrList * bstrColumnToList (const struct bstrColumn * c)
+ *
+ *  Create a struct bstrList which contains a copy of each of the entries
+ *  of the column c in the same order.
+ */
+struct bstrList * bstrColumnToList (const struct bstrColumn * c) {
+struct bstrList * sl;
+int i;
+
+	if (NULL == c || NULL == c->offsets || c->qty < 0) return NULL;
+	if (NULL == (sl = bstrListCreate ())) return NULL;
+	if (c->qty > 0 && BSTR_OK != bstrListAlloc (sl, c->qty)) {
+		bstrListDestroy (sl);
+		return NULL;
+	}
+	for (i = 0; i < c->qty; i++) {
+		sl->entry[i] = blk2bstr (c->blob->data + c->offsets[i],
+		                         c->offsets[i+1] - c->offsets[i]);
+		if (NULL == sl->entry[i]) {
+			bstrListDestroy (sl);
+			return NULL;
+		}
+		sl->qty++;
+	}
+	return sl;
+}
+
+/*  int bstrColumnSelectInstr (const struct bstrColumn * c,
+ *                             const_bstring find, int * sel)
+ *
+ *  Write the indexes of all the entries of c which contain the substring
+ *  find into the array sel in increasing order, and return the number of
+ *  such entries.  sel must have room for c->qty indexes.  Rather than
+ *  searching each entry separately, the whole blob is searched at once and
+ *  matches are mapped back to entries through the offsets, so entries
+ *  containing no candidate match are skipped over without being visited.
+ */
+int bstrColumnSelectInstr (const struct bstrColumn * c, const_bstring find, int * sel) {
+struct tagbstring t;
+int i, p, n;
+
+	if (NULL == c || NULL == c->offsets || c->qty < 0 || NULL == sel ||
+	    NULL == find || NULL == find->data || find->slen < 0) return BSTR_ERR;
+
+	if (0 == find->slen) {
+		for (i = 0; i < c->qty; i++) sel[i] = i;
+		return c->qty;
+	}
+
+	blk2tbstr (t, c->blob->data, c->offsets[c->qty]);
+	for (n = i = p = 0; i < c->qty && 0 <= (p = binstr (&t, p, find));) {
+		/* Locate the entry that contains the start of the match */
+		while (c->offsets[i+1] <= p) i++;
+		if (p + find->slen <= c->offsets[i+1]) {
+			sel[n] = i;
+			n++;
+			p = c->offsets[i+1];
+			i++;
+		} else {
+			p++; /* Match straddles the end of entry i */
+		}
+		if (p >= t.slen) break;
+	}
+	return n;
+}
+
+/*  int bstrColumnSelectEqCaseless (const struct bstrColumn * c,
+ *                                  const_bstring b, int * sel)
+ *
+ *  Write the indexes of all the entries of c which are equal to b without
+ *  differentiating between case into the array sel in increasing order,
+ *  and return the number of such entries.  sel must have room for c->qty
+ *  indexes.  Entries of the wrong length are rejected from the offsets alone
+ *  without touching the blob.
+ */
+int bstrColumnSelectEqCaseless (const struct bstrColumn * c, const_bstring b, int * sel) {
+struct tagbstring t;
+int i, n;
+
+	if (NULL == c || NULL == c->offsets || c->qty < 0 || NULL == sel ||
+	    NULL == b || NULL == b->data || b->slen < 0) return BSTR_ERR;
+
+	for (n = i = 0; i < c->qty; i++) {
+		if (c->offsets[i+1] - c->offsets[i] != b->slen) continue;
+		blk2tbstr (t, c->blob->data + c->offsets[i], b->slen);
+		if (1 == biseqcaselessblk (&t, b->data, b->slen)) {
+			sel[n] = i;
+			n++;
+		}
+	}
+	return n;
+}
+
+/*
+ *  Serialized struct bstrList format.  All integers are 32 bit little
+ *  endian, so the format is independent of the host platform:
+ *
+ *      "bSL\032"                            magic
+ *      version                              (BSL_SERIAL_VERSION)
+ *      qty                                  number of entries
+ *      blen                                 length of the blob
+ *      offsets[0] .. offsets[qty]           offsets of each entry in blob
+ *      blob                                 the entries
+ *
+ *  Each entry in the blob is followed by a '\0', so entry i has the length
+ *  offsets[i+1] - offsets[i] - 1, and references to entries can be used as
+ *  ordinary '\0' terminated strings.  offsets[0] is 0 and offsets[qty] is
+ *  blen.
+ */
+
+#define BSL_SERIAL_VERSION (1)
+#define BSL_SERIAL_HDRLEN (16)
+#define BSL_SERIAL_BUFFQTY (64)
+
+static const unsigned char bslMagic[4] = { 'b', 'S', 'L', '\032' };
+
+static void bslPutInt (unsigned char * p, unsigned long v) {
+	p[0] = (unsigned char) (v & 0xFF);
+	p[1] = (unsigned char) ((v >>  8) & 0xFF);
+	p[2] = (unsigned char) ((v >> 16) & 0xFF);
+	p[3] = (unsigned char) ((v >> 24) & 0xFF);
+}
+
+static unsigned long bslGetInt (const unsigned char * p) {
+	return  ((unsigned long) p[0])        | (((unsigned long) p[1]) <<  8) |
+	       (((unsigned long) p[2]) << 16) | (((unsigned long) p[3]) << 24);
+}
+
+/*  int bwsWriteBstrList (struct bwriteStream * ws, const struct bstrList * sl)
+ *
+ *  Write the struct bstrList sl to the bwriteStream in a versioned binary
+ *  format which can be read back without ambiguity (unlike bjoin followed
+ *  by bsplit) with bstrListRefSerial.  The header and the offsets table are
+ *  computed in one pass over the lengths of the entries, and then the entry
+ *  data is streamed out directly from the list, so no copy of the whole
+ *  list is ever made.
+ */
+int bwsWriteBstrList (struct bwriteStream * ws, const struct bstrList * sl) {
+static const unsigned char nul[1] = { '\0' };
+unsigned char buf[4 * BSL_SERIAL_BUFFQTY];
+unsigned long o;
+int i, j;
+
+	if (NULL == ws || NULL == sl || sl->qty < 0 || sl->qty > INT_MAX / 4 - 8)
+		return BSTR_ERR;
+	for (o = 0, i = 0; i < sl->qty; i++) {
+		if (NULL == sl->entry[i] || NULL == sl->entry[i]->data ||
+		    sl->entry[i]->slen < 0) return BSTR_ERR;
+		o += (unsigned long) sl->entry[i]->slen + 1;
+		if (o > (unsigned long) INT_MAX) return BSTR_ERR;
+	}
+
+	memcpy (buf, bslMagic, 4);
+	bslPutInt (buf +  4, BSL_SERIAL_VERSION);
+	bslPutInt (buf +  8, (unsigned long) sl->qty);
+	bslPutInt (buf + 12, o);
+	if (0 > bwsWriteBlk (ws, buf, BSL_SERIAL_HDRLEN)) return BSTR_ERR;
+
+	for (o = 0, j = 0, i = 0; i <= sl->qty; i++) {
+		bslPutInt (buf + 4 * j, o);
+		if (i < sl->qty) o += (unsigned long) sl->entry[i]->slen + 1;
+		if (++j >= BSL_SERIAL_BUFFQTY || i == sl->qty) {
+			if (0 > bwsWriteBlk (ws, buf, 4 * j)) return BSTR_ERR;
+			j = 0;
+		}
+	}
+
+	for (i = 0; i < sl->qty; i++) {
+		if (0 > bwsWriteBstr (ws, sl->entry[i]) ||
+		    0 > bwsWriteBlk (ws, (void *) nul, 1)) return BSTR_ERR;
+	}
+	return BSTR_OK;
+}
+
+/*  struct bstrList * bstrListRefSerial (const void * blk, int len)
+ *
+ *  Create a struct bstrList whose entries are write protected references
+ *  into the serialized list (as written by bwsWriteBstrList) found in the
+ *  len bytes at blk.  The format is fully validated first, and NULL is
+ *  returned if blk does not contain a well formed serialized list.
+ *
+ *  The headers of the entries are allocated together with the ->entry
+ *  array, so there is no per-entry allocation and none of the entry data is
+ *  copied.  This makes it suitable for loading very large lists directly
+ *  from a memory mapped file (with mmap() or MapViewOfFile(), for example),
+ *  in which case blk must remain mapped for as long as the list is used.
+ *  The result may be destroyed with bstrListDestroy (which leaves blk
+ *  untouched), but the list must not be grown with bstrListAlloc and its
+ *  entries must not be replaced or destroyed individually.
+ */
+struct bstrList * bstrListRefSerial (const void * blk, int len) {
+const unsigned char * p = (const unsigned char *) blk;
+const unsigned char * data;
+struct bstrList * sl;
+struct tagbstring * hdr;
+unsigned long qty, blen, o, no;
+size_t sz;
+int i;
+
+	if (NULL == p || len < BSL_SERIAL_HDRLEN + 4 || 0 != memcmp (p, bslMagic, 4) ||
+	    BSL_SERIAL_VERSION != bslGetInt (p + 4)) return NULL;
+	qty  = bslGetInt (p + 8);
+	blen = bslGetInt (p + 12);
+	if (qty > (unsigned long) (len - BSL_SERIAL_HDRLEN) / 4 - 1 ||
+	    blen != (unsigned long) len - BSL_SERIAL_HDRLEN - 4 * (qty + 1))
+		return NULL;
+	data = p + BSL_SERIAL_HDRLEN + 4 * (qty + 1);
+
+	/* Validate the offsets and entry terminators up front */
+	p += BSL_SERIAL_HDRLEN;
+	if (0 != bslGetInt (p)) return NULL;
+	for (o = 0, i = 1; i <= (int) qty; i++) {
+		no = bslGetInt (p + 4 * i);
+		if (no <= o || no > blen || '\0' != data[no - 1]) return NULL;
+		o = no;
+	}
+	if (o != blen) return NULL;
+
+	if (NULL == (sl = (struct bstrList *) malloc (sizeof (struct bstrList))))
+		return NULL;
+	sz = (qty > 0 ? qty : 1) * (sizeof (bstring) + sizeof (struct tagbstring));
+	if (NULL == (sl->entry = (bstring *) malloc (sz))) {
+		free (sl);
+		return NULL;
+	}
+	hdr = (struct tagbstring *) (sl->entry + (qty > 0 ? qty : 1));
+	for (i = 0; i < (int) qty; i++) {
+		o = bslGetInt (p + 4 * i);
+		hdr[i].data = (unsigned char *) (data + o);
+		hdr[i].slen = (int) (bslGetInt (p + 4 * (i + 1)) - o - 1);
+		hdr[i].mlen = -1;
+		sl->entry[i] = &hdr[i];
+	}
+	sl->qty = (int) qty;
+	sl->mlen = (int) (qty > 0 ? qty : 1);
+	return sl;
+}
+
+/*
+ *  Bulk transformations of the entries of a struct bstrList.  The whole
+ *  list is validated once up front, any per character lookups are
+ *  precomputed once into a table, and then each entry is processed with a
+ *  tight loop.  Runs of 7-bit ASCII are handled a machine word at a time
+ *  whenever the current locale agrees with ASCII for those characters.
+ *  Large lists are split into ranges of entries which are processed in
+ *  parallel via bexecute.
+ */
+
+#define BSL_WORD unsigned long
+#define BSL_WSZ  ((int) sizeof (BSL_WORD))
+#define BSL_ONES (((BSL_WORD) ~(BSL_WORD) 0) / 0xFF)
+#define BSL_HIGH (BSL_ONES * 0x80)
+
+struct bslCaseTable {
+	unsigned char map[UCHAR_MAX + 1];
+	int lower, swar;
+};
+
+static void bslBuildCaseTable (struct bslCaseTable * t, int lower) {
+int c;
+	t->lower = lower;
+	t->swar = 1;
+	for (c = 0; c <= UCHAR_MAX; c++) {
+		t->map[c] = (unsigned char) (lower ? tolower (c) : toupper (c));
+		if (c < 0x80 && (int) t->map[c] != (lower ?
+		    ((c >= 'A' && c <= 'Z') ? c + 0x20 : c) :
+		    ((c >= 'a' && c <= 'z') ? c - 0x20 : c))) t->swar = 0;
+	}
+}
+
+static void bslCaseBlk (const struct bslCaseTable * t, unsigned char * d, int len) {
+int i = 0;
+
+	if (t->swar) {
+		/* Byte lanes of the word hold values below 0x80, so adding 0x80-'A'
+		   (or 0x80-'Z'-1) cannot carry into the next lane, and the high bit
+		   of each lane then flags whether the character is >= 'A' (> 'Z'). */
+		BSL_WORD lo = BSL_ONES * (unsigned char) (0x80 - (t->lower ? 'A' : 'a'));
+		BSL_WORD hi = BSL_ONES * (unsigned char) (0x80 - (t->lower ? 'Z' : 'z') - 1);
+		for (; i + BSL_WSZ <= len; i += BSL_WSZ) {
+			BSL_WORD w, m;
+			memcpy (&w, d + i, sizeof (w));
+			if (w & BSL_HIGH) {
+				int j;
+				for (j = i; j < i + BSL_WSZ; j++) d[j] = t->map[d[j]];
+				continue;
+			}
+			m = (w + lo) & ~(w + hi) & BSL_HIGH;
+			if (m) {
+				w ^= m >> 2;
+				memcpy (d + i, &w, sizeof (w));
+			}
+		}
+	}
+	for (; i < len; i++) d[i] = t->map[d[i]];
+}
+
+static int bslValidate (const struct bstrList * sl) {
+int i;
+	if (NULL == sl || sl->qty < 0 || (sl->qty > 0 && NULL == sl->entry))
+		return BSTR_ERR;
+	for (i = 0; i < sl->qty; i++) {
+		bstring b = sl->entry[i];
+		if (NULL == b || NULL == b->data || b->slen < 0 || b->mlen <= 0 ||
+		    b->mlen < b->slen) return BSTR_ERR;
+	}
+	return BSTR_OK;
+}
+
+#define BSL_PAR_MIN_QTY (512)
+#define BSL_PAR_MAX_CHUNKS (64)
+
+struct bslJob {
+	struct bstrList * sl;
+	const struct bslCaseTable * ct;
+	const unsigned char * ws;
+	const_bstring find, repl;
+	int (* range) (struct bslJob * j, int lo, int hi);
+	int chunks;
+	int ret[BSL_PAR_MAX_CHUNKS];
+};
+
+static int bslCaseRange (struct bslJob * j, int lo, int hi) {
+int i;
+	for (i = lo; i < hi; i++)
+		bslCaseBlk (j->ct, j->sl->entry[i]->data, j->sl->entry[i]->slen);
+	return BSTR_OK;
+}
+
+static int bslTrimRange (struct bslJob * j, int lo, int hi) {
+int i, s, e;
+	for (i = lo; i < hi; i++) {
+		bstring b = j->sl->entry[i];
+		for (e = b->slen; e > 0 && j->ws[b->data[e-1]]; e--) {}
+		for (s = 0; s < e && j->ws[b->data[s]]; s++) {}
+		if (s > 0 && e > s) memmove (b->data, b->data + s, (size_t) (e - s));
+		b->slen = e - s;
+		if (b->mlen > b->slen) b->data[b->slen] = (unsigned char) '\0';
+	}
+	return BSTR_OK;
+}
+
+static int bslFindReplaceRange (struct bslJob * j, int lo, int hi) {
+int i, ret = BSTR_OK;
+	for (i = lo; i < hi; i++) {
+		if (j->sl->entry[i]->slen < j->find->slen) continue;
+		if (0 > bfindreplace (j->sl->entry[i], j->find, j->repl, 0))
+			ret = BSTR_ERR;
+	}
+	return ret;
+}
+
+static void bslChunk (void * parm, int idx) {
+struct bslJob * j = (struct bslJob *) parm;
+int q = j->sl->qty / j->chunks, r = j->sl->qty % j->chunks;
+int lo = idx * q + (idx < r ? idx : r);
+	j->ret[idx] = j->range (j, lo, lo + q + (idx < r));
+}
+
+/* Run j->range over the whole list, split into chunks which are handed to
+   bexecute when the list is large enough for that to be worthwhile. */
+static int bslRun (struct bslJob * j) {
+int i, c;
+
+	j->chunks = 1;
+	if (1 < (c = bexecconcurrency ()) && j->sl->qty >= 2 * BSL_PAR_MIN_QTY) {
+		j->chunks = j->sl->qty / BSL_PAR_MIN_QTY;
+		if (c < BSL_PAR_MAX_CHUNKS / 4 && j->chunks > 4 * c) j->chunks = 4 * c;
+		if (j->chunks > BSL_PAR_MAX_CHUNKS) j->chunks = BSL_PAR_MAX_CHUNKS;
+	}
+	if (BSTR_OK != bexecute (bslChunk, j, j->chunks)) return BSTR_ERR;
+	for (i = 0; i < j->chunks; i++) if (BSTR_OK != j->ret[i]) return BSTR_ERR;
+	return BSTR_OK;
+}
+
+static int bstrListCase (struct bstrList * sl, int lower) {
+struct bslCaseTable ct;
+struct bslJob j;
+
+	if (BSTR_OK != bslValidate (sl)) return BSTR_ERR;
+	bslBuildCaseTable (&ct, lower);
+	j.sl = sl;
+	j.ct = &ct;
+	j.range = bslCaseRange;
+	return bslRun (&j);
+}
+
+/*  int bstrListToLower (struct bstrList * sl)
+ *
+ *  Convert the contents of every entry of sl to lower case.  The result is
+ *  the same as calling btolower on each entry, except that if any entry is
+ *  not writable, BSTR_ERR is returned before any entry is modified.
+ */
+int bstrListToLower (struct bstrList * sl) {
+	return bstrListCase (sl, 1);
+}
+
+/*  int bstrListToUpper (struct bstrList * sl)
+ *
+ *  Convert the contents of every entry of sl to upper case.  The result is
+ *  the same as calling btoupper on each entry, except that if any entry is
+ *  not writable, BSTR_ERR is returned before any entry is modified.
+ */
+int bstrListToUpper (struct bstrList * sl) {
+	return bstrListCase (sl, 0);
+}
+
+/*  int bstrListTrimws (struct bstrList * sl)
+ *
+ *  Delete whitespace contiguous from both ends of every entry of sl.  The
+ *  result is the same as calling btrimws on each entry, except that if any
+ *  entry is not writable, BSTR_ERR is returned before any entry is
+ *  modified.
+ */
+int bstrListTrimws (struct bstrList * sl) {
+unsigned char ws[UCHAR_MAX + 1];
+struct bslJob j;
+int c;
+
+	if (BSTR_OK != bslValidate (sl)) return BSTR_ERR;
+	for (c = 0; c <= UCHAR_MAX; c++) ws[c] = (unsigned char) (0 != isspace (c));
+	j.sl = sl;
+	j.ws = ws;
+	j.range = bslTrimRange;
+	return bslRun (&j);
+}
+
+/*  int bstrListFindReplace (struct bstrList * sl, const_bstring find,
+ *                           const_bstring repl)
+ *
+ *  Replace all occurrences of find with repl in every entry of sl.  The
+ *  result is the same as calling bfindreplace (entry, find, repl, 0) on
+ *  each entry.  If any entry is not writable, BSTR_ERR is returned before
+ *  any entry is modified; if memory runs out part way through, BSTR_ERR is
+ *  returned and the list is left partially transformed.
+ */
+int bstrListFindReplace (struct bstrList * sl, const_bstring find, const_bstring repl) {
+struct bslJob j;
+bstring auxf = (bstring) find, auxr = (bstring) repl;
+int i;
+
+	if (BSTR_OK != bslValidate (sl) || NULL == find || NULL == find->data ||
+	    find->slen <= 0 || NULL == repl || NULL == repl->data ||
+	    repl->slen < 0) return BSTR_ERR;
+
+	/* find or repl may point into an entry of the list itself */
+	for (i = 0; i < sl->qty; i++) {
+		ptrdiff_t pf = find->data - sl->entry[i]->data;
+		ptrdiff_t pr = repl->data - sl->entry[i]->data;
+		if (auxf == find && pf >= 0 && pf < (ptrdiff_t) sl->entry[i]->mlen)
+			auxf = bstrcpy (find);
+		if (auxr == repl && pr >= 0 && pr < (ptrdiff_t) sl->entry[i]->mlen)
+			auxr = bstrcpy (repl);
+	}
+	j.sl = sl;
+	j.find = auxf;
+	j.repl = auxr;
+	j.range = bslFindReplaceRange;
+	i = (NULL == auxf || NULL == auxr) ? BSTR_ERR : bslRun (&j);
+	if (auxf != find) bdestroy (auxf);
+	if (auxr != repl) bdestroy (auxr);
+	return i;
+}
+
+/*
+ *  Approximate matching with Myers' bit-vector algorithm, in the blocked
+ *  form given by Hyyro.  The pattern occupies one bit per character in a
+ *  vector of machine words, and each character of the text advances a
+ *  whole column of the edit distance matrix in a few word operations per
+ *  block, rather than one cell at a time.
+ */
+
+#define BMY_WORD unsigned long
+#define BMY_BITS ((int) (CHAR_BIT * sizeof (BMY_WORD)))
+#define BMY_TOP  (((BMY_WORD) 1) << (BMY_BITS - 1))
+
+struct bMyers {
+	int nb;                /* Blocks in the pattern */
+	unsigned short map[UCHAR_MAX + 1]; /* Character to row of peq, 0 if absent */
+	BMY_WORD * peq;        /* peq[r*nb + i]: positions of row r's char in block i */
+	BMY_WORD * pv, * mv;   /* Vertical +1/-1 deltas of the current column */
+	BMY_WORD last;         /* Bit of the last pattern row in its block */
+	BMY_WORD one[BMY_BITS + 3];
+};
+
+static int bMyersInit (struct bMyers * e, const unsigned char * p, int m, int rev) {
+int i, c, rows;
+
+	/* Only the characters which occur in the pattern get a row of peq, so
+	   that little has to be cleared for short patterns. */
+	memset (e->map, 0, sizeof (e->map));
+	for (rows = 1, i = 0; i < m; i++) {
+		if (0 == e->map[p[i]]) e->map[p[i]] = (unsigned short) rows++;
+	}
+
+	e->nb = (m + BMY_BITS - 1) / BMY_BITS;
+	if (e->nb == 1) {
+		e->peq = e->one;
+	} else {
+		if (e->nb > (INT_MAX / (int) sizeof (BMY_WORD)) / (rows + 2)) return BSTR_ERR;
+		e->peq = (BMY_WORD *) malloc ((size_t) e->nb * (rows + 2) * sizeof (BMY_WORD));
+		if (NULL == e->peq) return BSTR_ERR;
+	}
+	e->pv = e->peq + rows * e->nb;
+	e->mv = e->pv + e->nb;
+	memset (e->peq, 0, (size_t) e->nb * rows * sizeof (BMY_WORD));
+	for (i = 0; i < m; i++) {
+		c = e->map[p[rev ? m - 1 - i : i]];
+		e->peq[c * e->nb + i / BMY_BITS] |= ((BMY_WORD) 1) << (i % BMY_BITS);
+	}
+	for (i = 0; i < e->nb; i++) {
+		e->pv[i] = ~(BMY_WORD) 0;
+		e->mv[i] = 0;
+	}
+	e->last = ((BMY_WORD) 1) << ((m - 1) % BMY_BITS);
+	return BSTR_OK;
+}
+
+static void bMyersFree (struct bMyers * e) {
+	if (e->peq != e->one) free (e->peq);
+}
+
+/* Advance the column by the text character c, with hin the difference
+   between the top row's new and old values (+1 for edit distance, where the
+   top row counts the text consumed, 0 for searching, where a match may
+   start anywhere).  Returns the difference for the last row. */
+static int bMyersStep (struct bMyers * e, unsigned char c, int hin) {
+const BMY_WORD * peq = e->peq + e->map[c] * e->nb;
+BMY_WORD eq, pv, mv, xv, xh, ph, mh, hb;
+int i, hout;
+
+	for (i = 0; i < e->nb; i++) {
+		eq = peq[i];
+		pv = e->pv[i];
+		mv = e->mv[i];
+		xv = eq | mv;
+		if (hin < 0) eq |= 1;
+		xh = (((eq & pv) + pv) ^ pv) | eq;
+		ph = mv | ~(xh | pv);
+		mh = pv & xh;
+		hb = (i == e->nb - 1) ? e->last : BMY_TOP;
+		hout = (0 != (ph & hb)) - (0 != (mh & hb));
+		ph <<= 1;
+		mh <<= 1;
+		if (hin < 0) mh |= 1;
+		else if (hin > 0) ph |= 1;
+		e->pv[i] = mh | ~(xv | ph);
+		e->mv[i] = ph & xv;
+		hin = hout;
+	}
+	return hin;
+}
+
+/*  int bLevenshteinMax (const_bstring a, const_bstring b, int k)
+ *
+ *  Return the Levenshtein (edit) distance between a and b if it is at most
+ *  k, and k+1 otherwise, stopping as soon as the distance is known to be
+ *  larger than k.  A negative k places no bound on the distance.  BSTR_ERR
+ *  is returned if a or b is invalid or memory runs out.
+ */
+int bLevenshteinMax (const_bstring a, const_bstring b, int k) {
+struct bMyers e;
+const_bstring t;
+int i, d;
+
+	if (NULL == bdata (a) || NULL == bdata (b) || a->slen < 0 || b->slen < 0)
+		return BSTR_ERR;
+	if (a->slen > b->slen) {
+		t = a;
+		a = b;
+		b = t;
+	}
+	if (k >= 0 && b->slen - a->slen > k) return k + 1;
+	if (a->slen == 0) return b->slen;
+
+	if (BSTR_OK != bMyersInit (&e, a->data, a->slen, 0)) return BSTR_ERR;
+	d = a->slen;
+	if (k < 0) k = INT_MAX;
+	if (e.nb == 1) {
+		/* The common case of a pattern that fits in a word, with the
+		   column kept in registers */
+		BMY_WORD eq, pv = e.pv[0], mv = e.mv[0], xv, xh, ph, mh;
+		for (i = 0; i < b->slen; i++) {
+			eq = e.peq[e.map[b->data[i]]];
+			xv = eq | mv;
+			xh = (((eq & pv) + pv) ^ pv) | eq;
+			ph = mv | ~(xh | pv);
+			mh = pv & xh;
+			d += (0 != (ph & e.last)) - (0 != (mh & e.last));
+			ph = (ph << 1) | 1;
+			mh <<= 1;
+			pv = mh | ~(xv | ph);
+			mv = ph & xv;
+			/* Each remaining column can lower the distance by at most one */
+			if (d - (b->slen - 1 - i) > k) return k + 1;
+		}
+		return d;
+	}
+	for (i = 0; i < b->slen; i++) {
+		d += bMyersStep (&e, b->data[i], 1);
+		if (d - (b->slen - 1 - i) > k) {
+			d = k + 1;
+			break;
+		}
+	}
+	bMyersFree (&e);
+	return d;
+}
+
+/*  int bLevenshtein (const_bstring a, const_bstring b)
+ *
+ *  Return the Levenshtein (edit) distance between a and b, or BSTR_ERR.
+ */
+int bLevenshtein (const_bstring a, const_bstring b) {
+	return bLevenshteinMax (a, b, -1);
+}
+
+/*  int binstrfuzzy (const_bstring b1, int pos, const_bstring b2, int k)
+ *
+ *  Search for an approximate occurrence of b2 in b1, within k edits
+ *  (insertions, deletions or substitutions), starting from position pos.
+ *  The match which ends first is chosen, and the position of its start is
+ *  returned, that start being the one which gives the fewest edits (the
+ *  earliest, in the case of a tie).  BSTR_ERR is returned if there is no
+ *  match or a parameter is invalid.
+ */
+int binstrfuzzy (const_bstring b1, int pos, const_bstring b2, int k) {
+struct bMyers e;
+int i, j, m, d, bd, bi;
+
+	if (NULL == bdata (b1) || NULL == bdata (b2) || b1->slen < 0 ||
+	    b2->slen < 0 || pos < 0 || pos > b1->slen || k < 0) return BSTR_ERR;
+	m = b2->slen;
+	if (m <= k) return pos;
+
+	if (BSTR_OK != bMyersInit (&e, b2->data, m, 0)) return BSTR_ERR;
+	for (d = m, j = pos; j < b1->slen; j++) {
+		d += bMyersStep (&e, b1->data[j], 0);
+		if (d <= k) break;
+	}
+	bMyersFree (&e);
+	if (j >= b1->slen) return BSTR_ERR;
+
+	/* Find the start by matching the reversed pattern backwards from the
+	   end of the match; it can be no more than m+k characters long. */
+	if (BSTR_OK != bMyersInit (&e, b2->data, m, 1)) return BSTR_ERR;
+	for (bd = d = m, bi = i = 0; i < m + k && j - i >= pos; i++) {
+		d += bMyersStep (&e, b1->data[j - i], 1);
+		if (d <= bd) {
+			bd = d;
+			bi = i + 1;
+		}
+	}
+	bMyersFree (&e);
+	return j + 1 - bi;
+}
+
+/*
+ *  Differences with Myers' O(ND) algorithm in its linear space form: the
+ *  middle of an optimal edit path is found by running the greedy search
+ *  forwards from the start and backwards from the end at the same time, and
+ *  the two halves are solved recursively.  Both byte and line diffs run on
+ *  arrays of integers; lines are numbered by hashing them, with equal
+ *  hashes confirmed by comparing the lines, so that equal lines (and only
+ *  equal lines) get the same number.
+ */
+
+#define BDIFF_MIN_QTY (8)
+
+struct bDiffCtx {
+	const int * a, * b;
+	int * v1, * v2;
+	struct bDiff * d;
+	int err;
+};
+
+static void bDiffEmit (struct bDiffCtx * c, int apos, int alen, int bpos, int blen) {
+struct bDiffEdit * e;
+int m;
+
+	if (c->d->qty > 0) {
+		e = &c->d->edit[c->d->qty - 1];
+		if (e->apos + e->alen == apos && e->bpos + e->blen == bpos) {
+			e->alen += alen;
+			e->blen += blen;
+			return;
+		}
+	}
+	if (c->d->qty >= c->d->mlen) {
+		m = c->d->mlen;
+		if (m > INT_MAX / 2 || (size_t) m * 2 > ((size_t) -1) / sizeof (struct bDiffEdit) ||
+		    NULL == (e = (struct bDiffEdit *) realloc (c->d->edit, (size_t) m * 2 * sizeof (struct bDiffEdit)))) {
+			c->err = 1;
+			return;
+		}
+		c->d->edit = e;
+		c->d->mlen = m * 2;
+	}
+	e = &c->d->edit[c->d->qty++];
+	e->apos = apos;
+	e->alen = alen;
+	e->bpos = bpos;
+	e->blen = blen;
+}
+
+/* Find a point (*x, *y) on an optimal path from (0, 0) to (n, m) for the
+   sequences a and b, which have no common prefix or suffix.  Returns 0 if
+   there is no such point other than the ends. */
+static int bDiffBisect (struct bDiffCtx * c, const int * a, int n, const int * b, int m, int * x, int * y) {
+int maxd = (n + m + 1) / 2, off = maxd, vlen = 2 * maxd + 2, delta = n - m;
+int front = (delta & 1), k1s = 0, k1e = 0, k2s = 0, k2e = 0;
+int * v1 = c->v1, * v2 = c->v2;
+int d, k, ko, x1, y1, x2, y2;
+
+	for (k = 0; k < vlen; k++) v1[k] = v2[k] = -1;
+	v1[off + 1] = v2[off + 1] = 0;
+
+	for (d = 0; d < maxd; d++) {
+		for (k = -d + k1s; k <= d - k1e; k += 2) {
+			ko = off + k;
+			if (k == -d || (k != d && v1[ko - 1] < v1[ko + 1])) x1 = v1[ko + 1];
+			else x1 = v1[ko - 1] + 1;
+			y1 = x1 - k;
+			while (x1 < n && y1 < m && a[x1] == b[y1]) {
+				x1++;
+				y1++;
+			}
+			v1[ko] = x1;
+			if (x1 > n) {
+				k1e += 2;
+			} else if (y1 > m) {
+				k1s += 2;
+			} else if (front) {
+				ko = off + delta - k;
+				if (ko >= 0 && ko < vlen && v2[ko] != -1 && x1 >= n - v2[ko]) {
+					*x = x1;
+					*y = y1;
+					return 1;
+				}
+			}
+		}
+		for (k = -d + k2s; k <= d - k2e; k += 2) {
+			ko = off + k;
+			if (k == -d || (k != d && v2[ko - 1] < v2[ko + 1])) x2 = v2[ko + 1];
+			else x2 = v2[ko - 1] + 1;
+			y2 = x2 - k;
+			while (x2 < n && y2 < m && a[n - x2 - 1] == b[m - y2 - 1]) {
+				x2++;
+				y2++;
+			}
+			v2[ko] = x2;
+			if (x2 > n) {
+				k2e += 2;
+			} else if (y2 > m) {
+				k2s += 2;
+			} else if (!front) {
+				ko = off + delta - k;
+				if (ko >= 0 && ko < vlen && v1[ko] != -1) {
+					x1 = v1[ko];
+					if (x1 >= n - x2) {
+						*x = x1;
+						*y = x1 - (ko - off);
+						return 1;
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+static void bDiffCompare (struct bDiffCtx * c, int alo, int ahi, int blo, int bhi) {
+int x, y;
+
+	while (alo < ahi && blo < bhi && c->a[alo] == c->b[blo]) {
+		alo++;
+		blo++;
+	}
+	while (alo < ahi && blo < bhi && c->a[ahi - 1] == c->b[bhi - 1]) {
+		ahi--;
+		bhi--;
+	}
+	if (c->err || (alo == ahi && blo == bhi)) return;
+
+	if (alo == ahi || blo == bhi ||
+	    !bDiffBisect (c, c->a + alo, ahi - alo, c->b + blo, bhi - blo, &x, &y) ||
+	    (x == 0 && y == 0) || (x == ahi - alo && y == bhi - blo)) {
+		bDiffEmit (c, alo, ahi - alo, blo, bhi - blo);
+		return;
+	}
+	bDiffCompare (c, alo, alo + x, blo, blo + y);
+	bDiffCompare (c, alo + x, ahi, blo + y, bhi);
+}
+
+/* Diff the integer sequences a and b into a new struct bDiff */
+static struct bDiff * bDiffRun (const int * a, int n, const int * b, int m, int unit) {
+struct bDiffCtx c;
+struct bDiff * d;
+size_t vlen;
+
+	if (NULL == (d = (struct bDiff *) malloc (sizeof (struct bDiff)))) return NULL;
+	d->unit = unit;
+	d->qty = 0;
+	d->mlen = BDIFF_MIN_QTY;
+	d->data = NULL;
+	vlen = (size_t) n + m + 4;
+	d->edit = (struct bDiffEdit *) malloc (BDIFF_MIN_QTY * sizeof (struct bDiffEdit));
+	c.v1 = (vlen < ((size_t) -1) / (2 * sizeof (int))) ? (int *) malloc (2 * vlen * sizeof (int)) : NULL;
+	c.err = (NULL == d->edit || NULL == c.v1);
+	if (!c.err) {
+		c.v2 = c.v1 + vlen;
+		c.a = a;
+		c.b = b;
+		c.d = d;
+		bDiffCompare (&c, 0, n, 0, m);
+	}
+	free (c.v1);
+	if (c.err || NULL == (d->data = bstrListCreate ())) {
+		bDiffDestroy (d);
+		return NULL;
+	}
+	return d;
+}
+
+/*  struct bDiff * bDiffBytes (const_bstring a, const_bstring b)
+ *
+ *  Compute a shortest edit script, in bytes, which turns a into b.  Each
+ *  edit replaces the range edit[i].apos .. apos+alen-1 of a by the range
+ *  edit[i].bpos .. bpos+blen-1 of b, whose content is data->entry[i], so
+ *  the script can be applied to a with bDiffApply without b.  NULL is
+ *  returned on error.
+ */
+struct bDiff * bDiffBytes (const_bstring a, const_bstring b) {
+struct bDiff * d;
+int * s;
+int i;
+
+	if (NULL == bdata (a) || NULL == bdata (b) || a->slen < 0 || b->slen < 0 ||
+	    (size_t) a->slen + b->slen + 1 > ((size_t) -1) / sizeof (int)) return NULL;
+	if (NULL == (s = (int *) malloc (((size_t) a->slen + b->slen + 1) * sizeof (int))))
+		return NULL;
+	for (i = 0; i < a->slen; i++) s[i] = a->data[i];
+	for (i = 0; i < b->slen; i++) s[a->slen + i] = b->data[i];
+	d = bDiffRun (s, a->slen, s + a->slen, b->slen, BDIFF_BYTES);
+	free (s);
+	if (NULL == d) return NULL;
+
+	if (d->qty > 0 && BSTR_OK != bstrListAlloc (d->data, d->qty)) goto Fail;
+	for (i = 0; i < d->qty; i++) {
+		if (NULL == (d->data->entry[i] = bmidstr (b, d->edit[i].bpos, d->edit[i].blen))) goto Fail;
+		d->data->qty++;
+	}
+	return d;
+
+	Fail:;
+	bDiffDestroy (d);
+	return NULL;
+}
+
+static unsigned long bDiffHash (const_bstring b) {
+unsigned long h = 2166136261UL;
+int i;
+	for (i = 0; i < b->slen; i++) h = ((h ^ b->data[i]) * 16777619UL) & 0xFFFFFFFFUL;
+	return h;
+}
+
+/*  struct bDiff * bDiffLines (const struct bstrList * a,
+ *                             const struct bstrList * b)
+ *
+ *  Compute a shortest edit script which turns the list of lines (or any
+ *  other entries) a into b.  The edit positions and lengths count entries,
+ *  and data holds copies of the inserted entries, those of edit[i] following
+ *  those of the edits before it.  The script can be applied to a with
+ *  bDiffApplyList.  NULL is returned on error.
+ */
+struct bDiff * bDiffLines (const struct bstrList * a, const struct bstrList * b) {
+struct bDiff * d = NULL;
+unsigned long * hash;
+const_bstring * rep;
+int * id, * slot;
+int i, j, n, sz, ids;
+
+	if (NULL == a || NULL == b || a->qty < 0 || b->qty < 0 ||
+	    (NULL == a->entry && a->qty > 0) || (NULL == b->entry && b->qty > 0) ||
+	    a->qty > INT_MAX / 4 - b->qty) return NULL;
+	n = a->qty + b->qty;
+	for (i = 0; i < n; i++) {
+		if (NULL == bdata (i < a->qty ? a->entry[i] : b->entry[i - a->qty])) return NULL;
+	}
+
+	/* Number the distinct entries through an open addressed hash table */
+	for (sz = 16; sz < 2 * n; sz += sz) {}
+	id = (int *) malloc (((size_t) n + 1 + sz) * sizeof (int));
+	hash = (unsigned long *) malloc ((size_t) sz * sizeof (unsigned long));
+	rep = (const_bstring *) malloc ((size_t) sz * sizeof (const_bstring));
+	if (NULL == id || NULL == hash || NULL == rep) goto Done;
+	slot = id + n + 1;
+	for (i = 0; i < sz; i++) slot[i] = -1;
+	for (ids = i = 0; i < n; i++) {
+		const_bstring e = (i < a->qty) ? a->entry[i] : b->entry[i - a->qty];
+		unsigned long h = bDiffHash (e);
+		for (j = (int) (h & (sz - 1)); slot[j] >= 0; j = (j + 1) & (sz - 1)) {
+			if (hash[j] == h && 1 == biseq (rep[j], e)) break;
+		}
+		if (slot[j] < 0) {
+			slot[j] = ids++;
+			hash[j] = h;
+			rep[j] = e;
+		}
+		id[i] = slot[j];
+	}
+
+	if (NULL == (d = bDiffRun (id, a->qty, id + a->qty, b->qty, BDIFF_LINES))) goto Done;
+	for (n = i = 0; i < d->qty; i++) n += d->edit[i].blen;
+	if (n > 0 && BSTR_OK != bstrListAlloc (d->data, n)) goto Fail;
+	for (i = 0; i < d->qty; i++) {
+		for (j = 0; j < d->edit[i].blen; j++) {
+			bstring e = bstrcpy (b->entry[d->edit[i].bpos + j]);
+			if (NULL == e) goto Fail;
+			d->data->entry[d->data->qty++] = e;
+		}
+	}
+	goto Done;
+
+	Fail:;
+	bDiffDestroy (d);
+	d = NULL;
+
+	Done:;
+	free (id);
+	free (hash);
+	free (rep);
+	return d;
+}
+
+/* Check that the edits of d are in order and within a sequence of n
+   elements, and return the length of the result. */
+static int bDiffCheck (const struct bDiff * d, int n, int unit) {
+int i, p, r;
+
+	if (NULL == d || d->unit != unit || d->qty < 0 || NULL == d->data ||
+	    (d->qty > 0 && NULL == d->edit)) return BSTR_ERR;
+	for (r = n, p = i = 0; i < d->qty; i++) {
+		const struct bDiffEdit * e = &d->edit[i];
+		if (e->apos < p || e->alen < 0 || e->blen < 0 || e->apos > n - e->alen ||
+		    r - e->alen > INT_MAX - 1 - e->blen) return BSTR_ERR;
+		p = e->apos + e->alen;
+		r += e->blen - e->alen;
+	}
+	return r;
+}
+
+/*  int bDiffApply (bstring b, const struct bDiff * d)
+ *
+ *  Apply the byte edit script d (from bDiffBytes) to b, which should hold
+ *  the string that d was computed from.  The result is built in a single
+ *  pass.  BSTR_ERR is returned if d does not fit b or memory runs out.
+ */
+int bDiffApply (bstring b, const struct bDiff * d) {
+bstring t;
+int i, p, r;
+
+	if (NULL == b || b->slen < 0 || b->mlen <= 0 || b->mlen < b->slen ||
+	    0 > (r = bDiffCheck (d, b->slen, BDIFF_BYTES)) || d->data->qty != d->qty)
+		return BSTR_ERR;
+	if (NULL == (t = bfromcstralloc (r + 1, ""))) return BSTR_ERR;
+	for (p = i = 0; i < d->qty; i++) {
+		bcatblk (t, b->data + p, d->edit[i].apos - p);
+		bcatblk (t, d->data->entry[i]->data, d->data->entry[i]->slen);
+		p = d->edit[i].apos + d->edit[i].alen;
+	}
+	bcatblk (t, b->data + p, b->slen - p);
+	i = (t->slen == r) ? bassign (b, t) : BSTR_ERR;
+	bdestroy (t);
+	return i;
+}
+
+/*  int bDiffApplyList (struct bstrList * sl, const struct bDiff * d)
+ *
+ *  Apply the line edit script d (from bDiffLines) to the list sl, which
+ *  should hold the entries that d was computed from.  Deleted entries are
+ *  destroyed and inserted ones are copied from d.  BSTR_ERR is returned,
+ *  with sl unchanged, if d does not fit sl or memory runs out.
+ */
+int bDiffApplyList (struct bstrList * sl, const struct bDiff * d) {
+bstring * l;
+int i, j, k, n, p, q, r;
+
+	if (NULL == sl || sl->qty < 0 || sl->mlen < sl->qty ||
+	    0 > (r = bDiffCheck (d, sl->qty, BDIFF_LINES))) return BSTR_ERR;
+	for (n = i = 0; i < d->qty; i++) n += d->edit[i].blen;
+	if (n != d->data->qty) return BSTR_ERR;
+
+	/* l holds the result followed by copies of the inserted entries, which
+	   are made before sl is touched so that failure leaves it intact. */
+	if ((size_t) r + n + 1 > ((size_t) -1) / sizeof (bstring) ||
+	    NULL == (l = (bstring *) malloc (((size_t) r + n + 1) * sizeof (bstring))))
+		return BSTR_ERR;
+	for (k = 0; k < n; k++) {
+		if (NULL == (l[r + k] = bstrcpy (d->data->entry[k]))) break;
+	}
+	if (k < n || BSTR_OK != bstrListAlloc (sl, r > 0 ? r : 1)) {
+		while (k-- > 0) bdestroy (l[r + k]);
+		free (l);
+		return BSTR_ERR;
+	}
+
+	for (k = q = p = i = 0; i < d->qty; i++) {
+		while (p < d->edit[i].apos) l[q++] = sl->entry[p++];
+		for (j = 0; j < d->edit[i].alen; j++) bdestroy (sl->entry[p++]);
+		for (j = 0; j < d->edit[i].blen; j++) l[q++] = l[r + k++];
+	}
+	while (p < sl->qty) l[q++] = sl->entry[p++];
+	for (i = 0; i < r; i++) sl->entry[i] = l[i];
+	sl->qty = r;
+	free (l);
+	return BSTR_OK;
+}
+
+/*  int bDiffDestroy (struct bDiff * d)
+ *
+ *  Destroy an edit script returned by bDiffBytes or bDiffLines.
+ */
+int bDiffDestroy (struct bDiff * d) {
+	if (NULL == d) return BSTR_ERR;
+	free (d->edit);
+	if (NULL != d->data) bstrListDestroy (d->data);
+	free (d);
+	return BSTR_OK;
+}
+
+/*
+ *  SHA-256 (FIPS 180-4), used as the strong hash of content defined
+ *  chunks.  Words are kept in unsigned longs masked to 32 bits.
+ */
+
+#define BSHA_MASK       (0xFFFFFFFFUL)
+#define BSHA_ROR(x,n)   ((((x) >> (n)) | ((x) << (32 - (n)))) & BSHA_MASK)
+
+struct bSha256Ctx {
+	unsigned long h[8];
+	unsigned long lo, hi;   /* Message length in bytes */
+	unsigned char buf[64];
+	int n;
+};
+
+static const unsigned long bSha256K[64] = {
+	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+	0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+	0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL, 0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+	0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+	0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+	0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+	0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+	0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL, 0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+static void bSha256Init (struct bSha256Ctx * c) {
+	c->h[0] = 0x6a09e667UL; c->h[1] = 0xbb67ae85UL;
+	c->h[2] = 0x3c6ef372UL; c->h[3] = 0xa54ff53aUL;
+	c->h[4] = 0x510e527fUL; c->h[5] = 0x9b05688cUL;
+	c->h[6] = 0x1f83d9abUL; c->h[7] = 0x5be0cd19UL;
+	c->lo = c->hi = 0;
+	c->n = 0;
+}
+
+static void bSha256Block (struct bSha256Ctx * c, const unsigned char * p) {
+unsigned long w[64], s[8], t1, t2;
+int i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = ((unsigned long) p[4*i] << 24) | ((unsigned long) p[4*i+1] << 16) |
+		       ((unsigned long) p[4*i+2] << 8) | p[4*i+3];
+	}
+	for (; i < 64; i++) {
+		t1 = BSHA_ROR (w[i-2], 17) ^ BSHA_ROR (w[i-2], 19) ^ (w[i-2] >> 10);
+		t2 = BSHA_ROR (w[i-15], 7) ^ BSHA_ROR (w[i-15], 18) ^ (w[i-15] >> 3);
+		w[i] = (t1 + w[i-7] + t2 + w[i-16]) & BSHA_MASK;
+	}
+	for (i = 0; i < 8; i++) s[i] = c->h[i];
+	for (i = 0; i < 64; i++) {
+		t1 = s[7] + (BSHA_ROR (s[4], 6) ^ BSHA_ROR (s[4], 11) ^ BSHA_ROR (s[4], 25)) +
+		     ((s[4] & s[5]) ^ (~s[4] & s[6])) + bSha256K[i] + w[i];
+		t2 = (BSHA_ROR (s[0], 2) ^ BSHA_ROR (s[0], 13) ^ BSHA_ROR (s[0], 22)) +
+		     ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = (s[3] + t1) & BSHA_MASK;
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = (t1 + t2) & BSHA_MASK;
+	}
+	for (i = 0; i < 8; i++) c->h[i] = (c->h[i] + s[i]) & BSHA_MASK;
+}
+
+static void bSha256Update (struct bSha256Ctx * c, const unsigned char * p, int len) {
+int k;
+
+	c->lo = (c->lo + (unsigned long) len) & BSHA_MASK;
+	if (c->lo < (unsigned long) len) c->hi++;
+	if (c->n > 0) {
+		k = (64 - c->n < len) ? 64 - c->n : len;
+		memcpy (c->buf + c->n, p, (size_t) k);
+		c->n += k;
+		p += k;
+		len -= k;
+		if (c->n < 64) return;
+		bSha256Block (c, c->buf);
+		c->n = 0;
+	}
+	for (; len >= 64; p += 64, len -= 64) bSha256Block (c, p);
+	memcpy (c->buf, p, (size_t) len);
+	c->n = len;
+}
+
+static void bSha256Final (struct bSha256Ctx * c, unsigned char * digest) {
+unsigned long hb = (c->hi << 3) | (c->lo >> 29), lb = (c->lo << 3) & BSHA_MASK;
+int i;
+
+	c->buf[c->n++] = 0x80;
+	if (c->n > 56) {
+		memset (c->buf + c->n, 0, (size_t) (64 - c->n));
+		bSha256Block (c, c->buf);
+		c->n = 0;
+	}
+	memset (c->buf + c->n, 0, (size_t) (56 - c->n));
+	for (i = 0; i < 4; i++) {
+		c->buf[56 + i] = (unsigned char) (hb >> (24 - 8 * i));
+		c->buf[60 + i] = (unsigned char) (lb >> (24 - 8 * i));
+	}
+	bSha256Block (c, c->buf);
+	for (i = 0; i < 32; i++) digest[i] = (unsigned char) (c->h[i >> 2] >> (24 - 8 * (i & 3)));
+}
+
+/*  int bSha256 (const void * blk, int len, unsigned char * digest)
+ *
+ *  Write the 32 byte SHA-256 digest of the len bytes at blk to digest.
+ */
+int bSha256 (const void * blk, int len, unsigned char * digest) {
+struct bSha256Ctx c;
+
+	if ((NULL == blk && len > 0) || len < 0 || NULL == digest) return BSTR_ERR;
+	bSha256Init (&c);
+	if (len > 0) bSha256Update (&c, (const unsigned char *) blk, len);
+	bSha256Final (&c, digest);
+	return BSTR_OK;
+}
+
+/*
+ *  Content defined chunking with FastCDC: a Gear hash (shift left and add a
+ *  random value per byte) is rolled over the data, and a chunk ends where
+ *  the hash has zeros in every bit of a mask.  A stricter mask is used
+ *  before the average size and a looser one after it, which concentrates
+ *  chunk sizes around the average, and no boundaries are considered in the
+ *  first minSize bytes of a chunk.
+ */
+
+struct bCdcCtx {
+	unsigned long long gear[UCHAR_MAX + 1];
+	unsigned long long maskS, maskL;
+	int minSize, avgSize, maxSize;
+};
+
+static int bCdcCut (const struct bCdcCtx * c, const unsigned char * d, int n) {
+unsigned long long fp = 0;
+int i, normal;
+
+	if (n <= c->minSize) return n;
+	if (n > c->maxSize) n = c->maxSize;
+	normal = (n < c->avgSize) ? n : c->avgSize;
+	for (i = c->minSize; i < normal; i++) {
+		fp = (fp << 1) + c->gear[d[i]];
+		if (0 == (fp & c->maskS)) return i + 1;
+	}
+	for (; i < n; i++) {
+		fp = (fp << 1) + c->gear[d[i]];
+		if (0 == (fp & c->maskL)) return i + 1;
+	}
+	return n;
+}
+
+/* A mask of the given number of bits, taken from the top of the 64 bit
+   hash where it depends on the most recent bytes.  The hash is 64 bits on
+   every platform, so that the same data is always cut at the same places. */
+static unsigned long long bCdcMask (int bits) {
+	if (bits < 1) bits = 1;
+	return (~0ULL >> (64 - bits)) << (64 - bits);
+}
+
+#define BCDC_DEFAULT_AVG (8192)
+
+/* 32 bit output of a simple counter based mixer */
+static unsigned long bCdcRand (unsigned long * x) {
+unsigned long z;
+	*x = (*x + 0x9E3779B9UL) & BSHA_MASK;
+	z = ((*x ^ (*x >> 16)) * 0x85EBCA6BUL) & BSHA_MASK;
+	z = ((z ^ (z >> 13)) * 0xC2B2AE35UL) & BSHA_MASK;
+	return z ^ (z >> 16);
+}
+
+/*  int bsChunk (struct bStream * s, int minSize, int avgSize, int maxSize,
+ *               bNchunk cb, void * parm)
+ *
+ *  Split the content of the stream s into content defined chunks with the
+ *  FastCDC algorithm, calling cb (parm, data, len, digest) for each chunk in
+ *  order with its bytes and their SHA-256 digest.  Chunk lengths are at
+ *  least minSize (except for the last one) and at most maxSize, and
+ *  average about avgSize, which must be a power of 2; avgSize of 0 selects
+ *  8KB, with minSize and maxSize of 0 then giving avgSize/4 and avgSize*8.
+ *  At most 2*maxSize bytes of s are held in memory at a time.  Returns
+ *  the number of chunks, or BSTR_ERR on error; if cb returns a negative
+ *  value the chunking stops and that value is returned.
+ */
+int bsChunk (struct bStream * s, int minSize, int avgSize, int maxSize,
+             bNchunk cb, void * parm) {
+struct bCdcCtx * c;
+struct bSha256Ctx h;
+unsigned char digest[32];
+unsigned long x;
+bstring buf;
+int i, bits, p, cut, ret, eof;
+
+	if (0 == avgSize) avgSize = BCDC_DEFAULT_AVG;
+	if (0 == minSize) minSize = avgSize / 4;
+	if (0 == maxSize) maxSize = (avgSize > INT_MAX / 8) ? INT_MAX / 2 : avgSize * 8;
+	if (NULL == s || NULL == cb || avgSize < 64 || (avgSize & (avgSize - 1)) ||
+	    minSize < 0 || minSize > avgSize || maxSize < avgSize ||
+	    maxSize > INT_MAX / 2) return BSTR_ERR;
+	if (NULL == (c = (struct bCdcCtx *) malloc (sizeof (struct bCdcCtx)))) return BSTR_ERR;
+	if (NULL == (buf = bfromcstralloc (2 * maxSize, ""))) {
+		free (c);
+		return BSTR_ERR;
+	}
+
+	/* Fixed pseudo-random Gear values, so that equal content is cut at the
+	   same places in every run */
+	for (x = 0x2545F491UL, i = 0; i <= UCHAR_MAX; i++) {
+		c->gear[i] = (unsigned long long) bCdcRand (&x) << 32;
+		c->gear[i] |= bCdcRand (&x);
+	}
+	for (bits = 0; (1 << bits) < avgSize; bits++) {}
+	c->maskS = bCdcMask (bits + 2);
+	c->maskL = bCdcMask (bits - 2);
+	c->minSize = minSize;
+	c->avgSize = avgSize;
+	c->maxSize = maxSize;
+
+	for (ret = p = eof = 0;;) {
+		if (!eof && buf->slen - p < maxSize) {
+			if (p > 0) {
+				bdelete (buf, 0, p);
+				p = 0;
+			}
+			if (BSTR_ERR == bsreada (buf, s, maxSize)) eof = 1;
+			continue;
+		}
+		if (p >= buf->slen) break;
+		cut = bCdcCut (c, buf->data + p, buf->slen - p);
+		bSha256Init (&h);
+		bSha256Update (&h, buf->data + p, cut);
+		bSha256Final (&h, digest);
+		if (0 > (i = cb (parm, buf->data + p, cut, digest))) {
+			ret = i;
+			break;
+		}
+		p += cut;
+		ret++;
+	}
+
+	bdestroy (buf);
+	free (c);
+	return ret;
+}
+
+/*
+ *  Rabin-Karp rolling hash: the hash of the w bytes at s is the polynomial
+ *  s[0]*B^(w-1) + s[1]*B^(w-2) + ... + s[w-1] modulo 2^32, which can be
+ *  moved along by one byte in constant time.
+ */
+
+#define BRK_BASE  (0x01000193UL)
+#define BRK_LANES (4)
+
+/*  int bRollingHash (const_bstring b, int w, unsigned long * h, int qty)
+ *
+ *  Compute the Rabin-Karp hash of each window of w bytes in b, storing the
+ *  hash of the window starting at offset i in h[i], for as many windows as
+ *  fit in b, up to qty of them.  The hash of a pattern of length w, for a
+ *  Rabin-Karp search, is given by h[0] for that pattern.  Returns the number
+ *  of hashes stored, or BSTR_ERR.  The output is split into independent
+ *  ranges that are rolled together, so the multiply chains overlap.
+ */
+int bRollingHash (const_bstring b, int w, unsigned long * h, int qty) {
+unsigned long bw, v[BRK_LANES];
+int n, i, j, len, st[BRK_LANES];
+const unsigned char * d;
+
+	if (NULL == bdata (b) || b->slen < 0 || w <= 0 || qty < 0 ||
+	    (NULL == h && qty > 0)) return BSTR_ERR;
+	if (w > b->slen) return 0;
+	n = b->slen - w + 1;
+	if (n > qty) n = qty;
+	d = b->data;
+
+	for (bw = 1, i = 0; i < w; i++) bw = (bw * BRK_BASE) & BSHA_MASK;
+	len = (n + BRK_LANES - 1) / BRK_LANES;
+	for (j = 0; j < BRK_LANES; j++) {
+		st[j] = (j * len < n) ? j * len : n;
+		for (v[j] = 0, i = 0; i < w && st[j] < n; i++) {
+			v[j] = (v[j] * BRK_BASE + d[st[j] + i]) & BSHA_MASK;
+		}
+	}
+
+	/* All lanes but the last have exactly len windows */
+	for (i = 0; i < len; i++) {
+		for (j = 0; j < BRK_LANES; j++) {
+			int k = st[j] + i;
+			if (k >= n || (j < BRK_LANES - 1 && k >= st[j + 1])) continue;
+			h[k] = v[j];
+			if (k + 1 < n) v[j] = (v[j] * BRK_BASE - d[k] * bw + d[k + w]) & BSHA_MASK;
+		}
+	}
+	return n;
+}
+
+/*
+ *  CRC-32C (the Castagnoli polynomial of iSCSI, ext4 and SCTP) and a 64 bit
+ *  non-cryptographic hash.  Without the crc32 instructions of SSE 4.2 or
+ *  ARMv8, the CRC is computed by slicing-by-8, which consumes eight bytes per
+ *  step from eight 256 entry tables.  Table k maps a byte to the CRC (with
+ *  the reflected polynomial 0x82F63B78) of that byte followed by k zero
+ *  bytes; the tables are constant data, so that no first use
+ *  initialisation races between threads.
+ */
+#if defined (__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined (__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#else
+#if UINT_MAX >= 0xFFFFFFFFUL
+typedef unsigned int bCrcWord;
+#else
+typedef unsigned long bCrcWord;
+#endif
+static const bCrcWord bCrcTable[8][256] = {
+	{
+		0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C,
+		0x26A1E7E8, 0xD4CA64EB, 0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B,
+		0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24, 0x105EC76F, 0xE235446C,
+		0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+		0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC,
+		0xBC267848, 0x4E4DFB4B, 0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A,
+		0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35, 0xAA64D611, 0x580F5512,
+		0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+		0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD,
+		0x1642AE59, 0xE4292D5A, 0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A,
+		0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595, 0x417B1DBC, 0xB3109EBF,
+		0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+		0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F,
+		0xED03A29B, 0x1F682198, 0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927,
+		0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38, 0xDBFC821C, 0x2997011F,
+		0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+		0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E,
+		0x4767748A, 0xB50CF789, 0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859,
+		0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46, 0x7198540D, 0x83F3D70E,
+		0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+		0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE,
+		0xDDE0EB2A, 0x2F8B6829, 0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C,
+		0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93, 0x082F63B7, 0xFA44E0B4,
+		0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+		0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B,
+		0xB4091BFF, 0x466298FC, 0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C,
+		0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033, 0xA24BB5A6, 0x502036A5,
+		0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+		0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975,
+		0x0E330A81, 0xFC588982, 0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D,
+		0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622, 0x38CC2A06, 0xCAA7A905,
+		0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+		0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8,
+		0xE52CC12C, 0x1747422F, 0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF,
+		0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0, 0xD3D3E1AB, 0x21B862A8,
+		0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+		0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78,
+		0x7FAB5E8C, 0x8DC0DD8F, 0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE,
+		0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1, 0x69E9F0D5, 0x9B8273D6,
+		0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+		0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69,
+		0xD5CF889D, 0x27A40B9E, 0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E,
+		0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+	},
+	{
+		0x00000000, 0x13A29877, 0x274530EE, 0x34E7A899, 0x4E8A61DC, 0x5D28F9AB,
+		0x69CF5132, 0x7A6DC945, 0x9D14C3B8, 0x8EB65BCF, 0xBA51F356, 0xA9F36B21,
+		0xD39EA264, 0xC03C3A13, 0xF4DB928A, 0xE7790AFD, 0x3FC5F181, 0x2C6769F6,
+		0x1880C16F, 0x0B225918, 0x714F905D, 0x62ED082A, 0x560AA0B3, 0x45A838C4,
+		0xA2D13239, 0xB173AA4E, 0x859402D7, 0x96369AA0, 0xEC5B53E5, 0xFFF9CB92,
+		0xCB1E630B, 0xD8BCFB7C, 0x7F8BE302, 0x6C297B75, 0x58CED3EC, 0x4B6C4B9B,
+		0x310182DE, 0x22A31AA9, 0x1644B230, 0x05E62A47, 0xE29F20BA, 0xF13DB8CD,
+		0xC5DA1054, 0xD6788823, 0xAC154166, 0xBFB7D911, 0x8B507188, 0x98F2E9FF,
+		0x404E1283, 0x53EC8AF4, 0x670B226D, 0x74A9BA1A, 0x0EC4735F, 0x1D66EB28,
+		0x298143B1, 0x3A23DBC6, 0xDD5AD13B, 0xCEF8494C, 0xFA1FE1D5, 0xE9BD79A2,
+		0x93D0B0E7, 0x80722890, 0xB4958009, 0xA737187E, 0xFF17C604, 0xECB55E73,
+		0xD852F6EA, 0xCBF06E9D, 0xB19DA7D8, 0xA23F3FAF, 0x96D89736, 0x857A0F41,
+		0x620305BC, 0x71A19DCB, 0x45463552, 0x56E4AD25, 0x2C896460, 0x3F2BFC17,
+		0x0BCC548E, 0x186ECCF9, 0xC0D23785, 0xD370AFF2, 0xE797076B, 0xF4359F1C,
+		0x8E585659, 0x9DFACE2E, 0xA91D66B7, 0xBABFFEC0, 0x5DC6F43D, 0x4E646C4A,
+		0x7A83C4D3, 0x69215CA4, 0x134C95E1, 0x00EE0D96, 0x3409A50F, 0x27AB3D78,
+		0x809C2506, 0x933EBD71, 0xA7D915E8, 0xB47B8D9F, 0xCE1644DA, 0xDDB4DCAD,
+		0xE9537434, 0xFAF1EC43, 0x1D88E6BE, 0x0E2A7EC9, 0x3ACDD650, 0x296F4E27,
+		0x53028762, 0x40A01F15, 0x7447B78C, 0x67E52FFB, 0xBF59D487, 0xACFB4CF0,
+		0x981CE469, 0x8BBE7C1E, 0xF1D3B55B, 0xE2712D2C, 0xD69685B5, 0xC5341DC2,
+		0x224D173F, 0x31EF8F48, 0x050827D1, 0x16AABFA6, 0x6CC776E3, 0x7F65EE94,
+		0x4B82460D, 0x5820DE7A, 0xFBC3FAF9, 0xE861628E, 0xDC86CA17, 0xCF245260,
+		0xB5499B25, 0xA6EB0352, 0x920CABCB, 0x81AE33BC, 0x66D73941, 0x7575A136,
+		0x419209AF, 0x523091D8, 0x285D589D, 0x3BFFC0EA, 0x0F186873, 0x1CBAF004,
+		0xC4060B78, 0xD7A4930F, 0xE3433B96, 0xF0E1A3E1, 0x8A8C6AA4, 0x992EF2D3,
+		0xADC95A4A, 0xBE6BC23D, 0x5912C8C0, 0x4AB050B7, 0x7E57F82E, 0x6DF56059,
+		0x1798A91C, 0x043A316B, 0x30DD99F2, 0x237F0185, 0x844819FB, 0x97EA818C,
+		0xA30D2915, 0xB0AFB162, 0xCAC27827, 0xD960E050, 0xED8748C9, 0xFE25D0BE,
+		0x195CDA43, 0x0AFE4234, 0x3E19EAAD, 0x2DBB72DA, 0x57D6BB9F, 0x447423E8,
+		0x70938B71, 0x63311306, 0xBB8DE87A, 0xA82F700D, 0x9CC8D894, 0x8F6A40E3,
+		0xF50789A6, 0xE6A511D1, 0xD242B948, 0xC1E0213F, 0x26992BC2, 0x353BB3B5,
+		0x01DC1B2C, 0x127E835B, 0x68134A1E, 0x7BB1D269, 0x4F567AF0, 0x5CF4E287,
+		0x04D43CFD, 0x1776A48A, 0x23910C13, 0x30339464, 0x4A5E5D21, 0x59FCC556,
+		0x6D1B6DCF, 0x7EB9F5B8, 0x99C0FF45, 0x8A626732, 0xBE85CFAB, 0xAD2757DC,
+		0xD74A9E99, 0xC4E806EE, 0xF00FAE77, 0xE3AD3600, 0x3B11CD7C, 0x28B3550B,
+		0x1C54FD92, 0x0FF665E5, 0x759BACA0, 0x663934D7, 0x52DE9C4E, 0x417C0439,
+		0xA6050EC4, 0xB5A796B3, 0x81403E2A, 0x92E2A65D, 0xE88F6F18, 0xFB2DF76F,
+		0xCFCA5FF6, 0xDC68C781, 0x7B5FDFFF, 0x68FD4788, 0x5C1AEF11, 0x4FB87766,
+		0x35D5BE23, 0x26772654, 0x12908ECD, 0x013216BA, 0xE64B1C47, 0xF5E98430,
+		0xC10E2CA9, 0xD2ACB4DE, 0xA8C17D9B, 0xBB63E5EC, 0x8F844D75, 0x9C26D502,
+		0x449A2E7E, 0x5738B609, 0x63DF1E90, 0x707D86E7, 0x0A104FA2, 0x19B2D7D5,
+		0x2D557F4C, 0x3EF7E73B, 0xD98EEDC6, 0xCA2C75B1, 0xFECBDD28, 0xED69455F,
+		0x97048C1A, 0x84A6146D, 0xB041BCF4, 0xA3E32483
+	},
+	{
+		0x00000000, 0xA541927E, 0x4F6F520D, 0xEA2EC073, 0x9EDEA41A, 0x3B9F3664,
+		0xD1B1F617, 0x74F06469, 0x38513EC5, 0x9D10ACBB, 0x773E6CC8, 0xD27FFEB6,
+		0xA68F9ADF, 0x03CE08A1, 0xE9E0C8D2, 0x4CA15AAC, 0x70A27D8A, 0xD5E3EFF4,
+		0x3FCD2F87, 0x9A8CBDF9, 0xEE7CD990, 0x4B3D4BEE, 0xA1138B9D, 0x045219E3,
+		0x48F3434F, 0xEDB2D131, 0x079C1142, 0xA2DD833C, 0xD62DE755, 0x736C752B,
+		0x9942B558, 0x3C032726, 0xE144FB14, 0x4405696A, 0xAE2BA919, 0x0B6A3B67,
+		0x7F9A5F0E, 0xDADBCD70, 0x30F50D03, 0x95B49F7D, 0xD915C5D1, 0x7C5457AF,
+		0x967A97DC, 0x333B05A2, 0x47CB61CB, 0xE28AF3B5, 0x08A433C6, 0xADE5A1B8,
+		0x91E6869E, 0x34A714E0, 0xDE89D493, 0x7BC846ED, 0x0F382284, 0xAA79B0FA,
+		0x40577089, 0xE516E2F7, 0xA9B7B85B, 0x0CF62A25, 0xE6D8EA56, 0x43997828,
+		0x37691C41, 0x92288E3F, 0x78064E4C, 0xDD47DC32, 0xC76580D9, 0x622412A7,
+		0x880AD2D4, 0x2D4B40AA, 0x59BB24C3, 0xFCFAB6BD, 0x16D476CE, 0xB395E4B0,
+		0xFF34BE1C, 0x5A752C62, 0xB05BEC11, 0x151A7E6F, 0x61EA1A06, 0xC4AB8878,
+		0x2E85480B, 0x8BC4DA75, 0xB7C7FD53, 0x12866F2D, 0xF8A8AF5E, 0x5DE93D20,
+		0x29195949, 0x8C58CB37, 0x66760B44, 0xC337993A, 0x8F96C396, 0x2AD751E8,
+		0xC0F9919B, 0x65B803E5, 0x1148678C, 0xB409F5F2, 0x5E273581, 0xFB66A7FF,
+		0x26217BCD, 0x8360E9B3, 0x694E29C0, 0xCC0FBBBE, 0xB8FFDFD7, 0x1DBE4DA9,
+		0xF7908DDA, 0x52D11FA4, 0x1E704508, 0xBB31D776, 0x511F1705, 0xF45E857B,
+		0x80AEE112, 0x25EF736C, 0xCFC1B31F, 0x6A802161, 0x56830647, 0xF3C29439,
+		0x19EC544A, 0xBCADC634, 0xC85DA25D, 0x6D1C3023, 0x8732F050, 0x2273622E,
+		0x6ED23882, 0xCB93AAFC, 0x21BD6A8F, 0x84FCF8F1, 0xF00C9C98, 0x554D0EE6,
+		0xBF63CE95, 0x1A225CEB, 0x8B277743, 0x2E66E53D, 0xC448254E, 0x6109B730,
+		0x15F9D359, 0xB0B84127, 0x5A968154, 0xFFD7132A, 0xB3764986, 0x1637DBF8,
+		0xFC191B8B, 0x595889F5, 0x2DA8ED9C, 0x88E97FE2, 0x62C7BF91, 0xC7862DEF,
+		0xFB850AC9, 0x5EC498B7, 0xB4EA58C4, 0x11ABCABA, 0x655BAED3, 0xC01A3CAD,
+		0x2A34FCDE, 0x8F756EA0, 0xC3D4340C, 0x6695A672, 0x8CBB6601, 0x29FAF47F,
+		0x5D0A9016, 0xF84B0268, 0x1265C21B, 0xB7245065, 0x6A638C57, 0xCF221E29,
+		0x250CDE5A, 0x804D4C24, 0xF4BD284D, 0x51FCBA33, 0xBBD27A40, 0x1E93E83E,
+		0x5232B292, 0xF77320EC, 0x1D5DE09F, 0xB81C72E1, 0xCCEC1688, 0x69AD84F6,
+		0x83834485, 0x26C2D6FB, 0x1AC1F1DD, 0xBF8063A3, 0x55AEA3D0, 0xF0EF31AE,
+		0x841F55C7, 0x215EC7B9, 0xCB7007CA, 0x6E3195B4, 0x2290CF18, 0x87D15D66,
+		0x6DFF9D15, 0xC8BE0F6B, 0xBC4E6B02, 0x190FF97C, 0xF321390F, 0x5660AB71,
+		0x4C42F79A, 0xE90365E4, 0x032DA597, 0xA66C37E9, 0xD29C5380, 0x77DDC1FE,
+		0x9DF3018D, 0x38B293F3, 0x7413C95F, 0xD1525B21, 0x3B7C9B52, 0x9E3D092C,
+		0xEACD6D45, 0x4F8CFF3B, 0xA5A23F48, 0x00E3AD36, 0x3CE08A10, 0x99A1186E,
+		0x738FD81D, 0xD6CE4A63, 0xA23E2E0A, 0x077FBC74, 0xED517C07, 0x4810EE79,
+		0x04B1B4D5, 0xA1F026AB, 0x4BDEE6D8, 0xEE9F74A6, 0x9A6F10CF, 0x3F2E82B1,
+		0xD50042C2, 0x7041D0BC, 0xAD060C8E, 0x08479EF0, 0xE2695E83, 0x4728CCFD,
+		0x33D8A894, 0x96993AEA, 0x7CB7FA99, 0xD9F668E7, 0x9557324B, 0x3016A035,
+		0xDA386046, 0x7F79F238, 0x0B899651, 0xAEC8042F, 0x44E6C45C, 0xE1A75622,
+		0xDDA47104, 0x78E5E37A, 0x92CB2309, 0x378AB177, 0x437AD51E, 0xE63B4760,
+		0x0C158713, 0xA954156D, 0xE5F54FC1, 0x40B4DDBF, 0xAA9A1DCC, 0x0FDB8FB2,
+		0x7B2BEBDB, 0xDE6A79A5, 0x3444B9D6, 0x91052BA8
+	},
+	{
+		0x00000000, 0xDD45AAB8, 0xBF672381, 0x62228939, 0x7B2231F3, 0xA6679B4B,
+		0xC4451272, 0x1900B8CA, 0xF64463E6, 0x2B01C95E, 0x49234067, 0x9466EADF,
+		0x8D665215, 0x5023F8AD, 0x32017194, 0xEF44DB2C, 0xE964B13D, 0x34211B85,
+		0x560392BC, 0x8B463804, 0x924680CE, 0x4F032A76, 0x2D21A34F, 0xF06409F7,
+		0x1F20D2DB, 0xC2657863, 0xA047F15A, 0x7D025BE2, 0x6402E328, 0xB9474990,
+		0xDB65C0A9, 0x06206A11, 0xD725148B, 0x0A60BE33, 0x6842370A, 0xB5079DB2,
+		0xAC072578, 0x71428FC0, 0x136006F9, 0xCE25AC41, 0x2161776D, 0xFC24DDD5,
+		0x9E0654EC, 0x4343FE54, 0x5A43469E, 0x8706EC26, 0xE524651F, 0x3861CFA7,
+		0x3E41A5B6, 0xE3040F0E, 0x81268637, 0x5C632C8F, 0x45639445, 0x98263EFD,
+		0xFA04B7C4, 0x27411D7C, 0xC805C650, 0x15406CE8, 0x7762E5D1, 0xAA274F69,
+		0xB327F7A3, 0x6E625D1B, 0x0C40D422, 0xD1057E9A, 0xABA65FE7, 0x76E3F55F,
+		0x14C17C66, 0xC984D6DE, 0xD0846E14, 0x0DC1C4AC, 0x6FE34D95, 0xB2A6E72D,
+		0x5DE23C01, 0x80A796B9, 0xE2851F80, 0x3FC0B538, 0x26C00DF2, 0xFB85A74A,
+		0x99A72E73, 0x44E284CB, 0x42C2EEDA, 0x9F874462, 0xFDA5CD5B, 0x20E067E3,
+		0x39E0DF29, 0xE4A57591, 0x8687FCA8, 0x5BC25610, 0xB4868D3C, 0x69C32784,
+		0x0BE1AEBD, 0xD6A40405, 0xCFA4BCCF, 0x12E11677, 0x70C39F4E, 0xAD8635F6,
+		0x7C834B6C, 0xA1C6E1D4, 0xC3E468ED, 0x1EA1C255, 0x07A17A9F, 0xDAE4D027,
+		0xB8C6591E, 0x6583F3A6, 0x8AC7288A, 0x57828232, 0x35A00B0B, 0xE8E5A1B3,
+		0xF1E51979, 0x2CA0B3C1, 0x4E823AF8, 0x93C79040, 0x95E7FA51, 0x48A250E9,
+		0x2A80D9D0, 0xF7C57368, 0xEEC5CBA2, 0x3380611A, 0x51A2E823, 0x8CE7429B,
+		0x63A399B7, 0xBEE6330F, 0xDCC4BA36, 0x0181108E, 0x1881A844, 0xC5C402FC,
+		0xA7E68BC5, 0x7AA3217D, 0x52A0C93F, 0x8FE56387, 0xEDC7EABE, 0x30824006,
+		0x2982F8CC, 0xF4C75274, 0x96E5DB4D, 0x4BA071F5, 0xA4E4AAD9, 0x79A10061,
+		0x1B838958, 0xC6C623E0, 0xDFC69B2A, 0x02833192, 0x60A1B8AB, 0xBDE41213,
+		0xBBC47802, 0x6681D2BA, 0x04A35B83, 0xD9E6F13B, 0xC0E649F1, 0x1DA3E349,
+		0x7F816A70, 0xA2C4C0C8, 0x4D801BE4, 0x90C5B15C, 0xF2E73865, 0x2FA292DD,
+		0x36A22A17, 0xEBE780AF, 0x89C50996, 0x5480A32E, 0x8585DDB4, 0x58C0770C,
+		0x3AE2FE35, 0xE7A7548D, 0xFEA7EC47, 0x23E246FF, 0x41C0CFC6, 0x9C85657E,
+		0x73C1BE52, 0xAE8414EA, 0xCCA69DD3, 0x11E3376B, 0x08E38FA1, 0xD5A62519,
+		0xB784AC20, 0x6AC10698, 0x6CE16C89, 0xB1A4C631, 0xD3864F08, 0x0EC3E5B0,
+		0x17C35D7A, 0xCA86F7C2, 0xA8A47EFB, 0x75E1D443, 0x9AA50F6F, 0x47E0A5D7,
+		0x25C22CEE, 0xF8878656, 0xE1873E9C, 0x3CC29424, 0x5EE01D1D, 0x83A5B7A5,
+		0xF90696D8, 0x24433C60, 0x4661B559, 0x9B241FE1, 0x8224A72B, 0x5F610D93,
+		0x3D4384AA, 0xE0062E12, 0x0F42F53E, 0xD2075F86, 0xB025D6BF, 0x6D607C07,
+		0x7460C4CD, 0xA9256E75, 0xCB07E74C, 0x16424DF4, 0x106227E5, 0xCD278D5D,
+		0xAF050464, 0x7240AEDC, 0x6B401616, 0xB605BCAE, 0xD4273597, 0x09629F2F,
+		0xE6264403, 0x3B63EEBB, 0x59416782, 0x8404CD3A, 0x9D0475F0, 0x4041DF48,
+		0x22635671, 0xFF26FCC9, 0x2E238253, 0xF36628EB, 0x9144A1D2, 0x4C010B6A,
+		0x5501B3A0, 0x88441918, 0xEA669021, 0x37233A99, 0xD867E1B5, 0x05224B0D,
+		0x6700C234, 0xBA45688C, 0xA345D046, 0x7E007AFE, 0x1C22F3C7, 0xC167597F,
+		0xC747336E, 0x1A0299D6, 0x782010EF, 0xA565BA57, 0xBC65029D, 0x6120A825,
+		0x0302211C, 0xDE478BA4, 0x31035088, 0xEC46FA30, 0x8E647309, 0x5321D9B1,
+		0x4A21617B, 0x9764CBC3, 0xF54642FA, 0x2803E842
+	},
+	{
+		0x00000000, 0x38116FAC, 0x7022DF58, 0x4833B0F4, 0xE045BEB0, 0xD854D11C,
+		0x906761E8, 0xA8760E44, 0xC5670B91, 0xFD76643D, 0xB545D4C9, 0x8D54BB65,
+		0x2522B521, 0x1D33DA8D, 0x55006A79, 0x6D1105D5, 0x8F2261D3, 0xB7330E7F,
+		0xFF00BE8B, 0xC711D127, 0x6F67DF63, 0x5776B0CF, 0x1F45003B, 0x27546F97,
+		0x4A456A42, 0x725405EE, 0x3A67B51A, 0x0276DAB6, 0xAA00D4F2, 0x9211BB5E,
+		0xDA220BAA, 0xE2336406, 0x1BA8B557, 0x23B9DAFB, 0x6B8A6A0F, 0x539B05A3,
+		0xFBED0BE7, 0xC3FC644B, 0x8BCFD4BF, 0xB3DEBB13, 0xDECFBEC6, 0xE6DED16A,
+		0xAEED619E, 0x96FC0E32, 0x3E8A0076, 0x069B6FDA, 0x4EA8DF2E, 0x76B9B082,
+		0x948AD484, 0xAC9BBB28, 0xE4A80BDC, 0xDCB96470, 0x74CF6A34, 0x4CDE0598,
+		0x04EDB56C, 0x3CFCDAC0, 0x51EDDF15, 0x69FCB0B9, 0x21CF004D, 0x19DE6FE1,
+		0xB1A861A5, 0x89B90E09, 0xC18ABEFD, 0xF99BD151, 0x37516AAE, 0x0F400502,
+		0x4773B5F6, 0x7F62DA5A, 0xD714D41E, 0xEF05BBB2, 0xA7360B46, 0x9F2764EA,
+		0xF236613F, 0xCA270E93, 0x8214BE67, 0xBA05D1CB, 0x1273DF8F, 0x2A62B023,
+		0x625100D7, 0x5A406F7B, 0xB8730B7D, 0x806264D1, 0xC851D425, 0xF040BB89,
+		0x5836B5CD, 0x6027DA61, 0x28146A95, 0x10050539, 0x7D1400EC, 0x45056F40,
+		0x0D36DFB4, 0x3527B018, 0x9D51BE5C, 0xA540D1F0, 0xED736104, 0xD5620EA8,
+		0x2CF9DFF9, 0x14E8B055, 0x5CDB00A1, 0x64CA6F0D, 0xCCBC6149, 0xF4AD0EE5,
+		0xBC9EBE11, 0x848FD1BD, 0xE99ED468, 0xD18FBBC4, 0x99BC0B30, 0xA1AD649C,
+		0x09DB6AD8, 0x31CA0574, 0x79F9B580, 0x41E8DA2C, 0xA3DBBE2A, 0x9BCAD186,
+		0xD3F96172, 0xEBE80EDE, 0x439E009A, 0x7B8F6F36, 0x33BCDFC2, 0x0BADB06E,
+		0x66BCB5BB, 0x5EADDA17, 0x169E6AE3, 0x2E8F054F, 0x86F90B0B, 0xBEE864A7,
+		0xF6DBD453, 0xCECABBFF, 0x6EA2D55C, 0x56B3BAF0, 0x1E800A04, 0x269165A8,
+		0x8EE76BEC, 0xB6F60440, 0xFEC5B4B4, 0xC6D4DB18, 0xABC5DECD, 0x93D4B161,
+		0xDBE70195, 0xE3F66E39, 0x4B80607D, 0x73910FD1, 0x3BA2BF25, 0x03B3D089,
+		0xE180B48F, 0xD991DB23, 0x91A26BD7, 0xA9B3047B, 0x01C50A3F, 0x39D46593,
+		0x71E7D567, 0x49F6BACB, 0x24E7BF1E, 0x1CF6D0B2, 0x54C56046, 0x6CD40FEA,
+		0xC4A201AE, 0xFCB36E02, 0xB480DEF6, 0x8C91B15A, 0x750A600B, 0x4D1B0FA7,
+		0x0528BF53, 0x3D39D0FF, 0x954FDEBB, 0xAD5EB117, 0xE56D01E3, 0xDD7C6E4F,
+		0xB06D6B9A, 0x887C0436, 0xC04FB4C2, 0xF85EDB6E, 0x5028D52A, 0x6839BA86,
+		0x200A0A72, 0x181B65DE, 0xFA2801D8, 0xC2396E74, 0x8A0ADE80, 0xB21BB12C,
+		0x1A6DBF68, 0x227CD0C4, 0x6A4F6030, 0x525E0F9C, 0x3F4F0A49, 0x075E65E5,
+		0x4F6DD511, 0x777CBABD, 0xDF0AB4F9, 0xE71BDB55, 0xAF286BA1, 0x9739040D,
+		0x59F3BFF2, 0x61E2D05E, 0x29D160AA, 0x11C00F06, 0xB9B60142, 0x81A76EEE,
+		0xC994DE1A, 0xF185B1B6, 0x9C94B463, 0xA485DBCF, 0xECB66B3B, 0xD4A70497,
+		0x7CD10AD3, 0x44C0657F, 0x0CF3D58B, 0x34E2BA27, 0xD6D1DE21, 0xEEC0B18D,
+		0xA6F30179, 0x9EE26ED5, 0x36946091, 0x0E850F3D, 0x46B6BFC9, 0x7EA7D065,
+		0x13B6D5B0, 0x2BA7BA1C, 0x63940AE8, 0x5B856544, 0xF3F36B00, 0xCBE204AC,
+		0x83D1B458, 0xBBC0DBF4, 0x425B0AA5, 0x7A4A6509, 0x3279D5FD, 0x0A68BA51,
+		0xA21EB415, 0x9A0FDBB9, 0xD23C6B4D, 0xEA2D04E1, 0x873C0134, 0xBF2D6E98,
+		0xF71EDE6C, 0xCF0FB1C0, 0x6779BF84, 0x5F68D028, 0x175B60DC, 0x2F4A0F70,
+		0xCD796B76, 0xF56804DA, 0xBD5BB42E, 0x854ADB82, 0x2D3CD5C6, 0x152DBA6A,
+		0x5D1E0A9E, 0x650F6532, 0x081E60E7, 0x300F0F4B, 0x783CBFBF, 0x402DD013,
+		0xE85BDE57, 0xD04AB1FB, 0x9879010F, 0xA0686EA3
+	},
+	{
+		0x00000000, 0xEF306B19, 0xDB8CA0C3, 0x34BCCBDA, 0xB2F53777, 0x5DC55C6E,
+		0x697997B4, 0x8649FCAD, 0x6006181F, 0x8F367306, 0xBB8AB8DC, 0x54BAD3C5,
+		0xD2F32F68, 0x3DC34471, 0x097F8FAB, 0xE64FE4B2, 0xC00C303E, 0x2F3C5B27,
+		0x1B8090FD, 0xF4B0FBE4, 0x72F90749, 0x9DC96C50, 0xA975A78A, 0x4645CC93,
+		0xA00A2821, 0x4F3A4338, 0x7B8688E2, 0x94B6E3FB, 0x12FF1F56, 0xFDCF744F,
+		0xC973BF95, 0x2643D48C, 0x85F4168D, 0x6AC47D94, 0x5E78B64E, 0xB148DD57,
+		0x370121FA, 0xD8314AE3, 0xEC8D8139, 0x03BDEA20, 0xE5F20E92, 0x0AC2658B,
+		0x3E7EAE51, 0xD14EC548, 0x570739E5, 0xB83752FC, 0x8C8B9926, 0x63BBF23F,
+		0x45F826B3, 0xAAC84DAA, 0x9E748670, 0x7144ED69, 0xF70D11C4, 0x183D7ADD,
+		0x2C81B107, 0xC3B1DA1E, 0x25FE3EAC, 0xCACE55B5, 0xFE729E6F, 0x1142F576,
+		0x970B09DB, 0x783B62C2, 0x4C87A918, 0xA3B7C201, 0x0E045BEB, 0xE13430F2,
+		0xD588FB28, 0x3AB89031, 0xBCF16C9C, 0x53C10785, 0x677DCC5F, 0x884DA746,
+		0x6E0243F4, 0x813228ED, 0xB58EE337, 0x5ABE882E, 0xDCF77483, 0x33C71F9A,
+		0x077BD440, 0xE84BBF59, 0xCE086BD5, 0x213800CC, 0x1584CB16, 0xFAB4A00F,
+		0x7CFD5CA2, 0x93CD37BB, 0xA771FC61, 0x48419778, 0xAE0E73CA, 0x413E18D3,
+		0x7582D309, 0x9AB2B810, 0x1CFB44BD, 0xF3CB2FA4, 0xC777E47E, 0x28478F67,
+		0x8BF04D66, 0x64C0267F, 0x507CEDA5, 0xBF4C86BC, 0x39057A11, 0xD6351108,
+		0xE289DAD2, 0x0DB9B1CB, 0xEBF65579, 0x04C63E60, 0x307AF5BA, 0xDF4A9EA3,
+		0x5903620E, 0xB6330917, 0x828FC2CD, 0x6DBFA9D4, 0x4BFC7D58, 0xA4CC1641,
+		0x9070DD9B, 0x7F40B682, 0xF9094A2F, 0x16392136, 0x2285EAEC, 0xCDB581F5,
+		0x2BFA6547, 0xC4CA0E5E, 0xF076C584, 0x1F46AE9D, 0x990F5230, 0x763F3929,
+		0x4283F2F3, 0xADB399EA, 0x1C08B7D6, 0xF338DCCF, 0xC7841715, 0x28B47C0C,
+		0xAEFD80A1, 0x41CDEBB8, 0x75712062, 0x9A414B7B, 0x7C0EAFC9, 0x933EC4D0,
+		0xA7820F0A, 0x48B26413, 0xCEFB98BE, 0x21CBF3A7, 0x1577387D, 0xFA475364,
+		0xDC0487E8, 0x3334ECF1, 0x0788272B, 0xE8B84C32, 0x6EF1B09F, 0x81C1DB86,
+		0xB57D105C, 0x5A4D7B45, 0xBC029FF7, 0x5332F4EE, 0x678E3F34, 0x88BE542D,
+		0x0EF7A880, 0xE1C7C399, 0xD57B0843, 0x3A4B635A, 0x99FCA15B, 0x76CCCA42,
+		0x42700198, 0xAD406A81, 0x2B09962C, 0xC439FD35, 0xF08536EF, 0x1FB55DF6,
+		0xF9FAB944, 0x16CAD25D, 0x22761987, 0xCD46729E, 0x4B0F8E33, 0xA43FE52A,
+		0x90832EF0, 0x7FB345E9, 0x59F09165, 0xB6C0FA7C, 0x827C31A6, 0x6D4C5ABF,
+		0xEB05A612, 0x0435CD0B, 0x308906D1, 0xDFB96DC8, 0x39F6897A, 0xD6C6E263,
+		0xE27A29B9, 0x0D4A42A0, 0x8B03BE0D, 0x6433D514, 0x508F1ECE, 0xBFBF75D7,
+		0x120CEC3D, 0xFD3C8724, 0xC9804CFE, 0x26B027E7, 0xA0F9DB4A, 0x4FC9B053,
+		0x7B757B89, 0x94451090, 0x720AF422, 0x9D3A9F3B, 0xA98654E1, 0x46B63FF8,
+		0xC0FFC355, 0x2FCFA84C, 0x1B736396, 0xF443088F, 0xD200DC03, 0x3D30B71A,
+		0x098C7CC0, 0xE6BC17D9, 0x60F5EB74, 0x8FC5806D, 0xBB794BB7, 0x544920AE,
+		0xB206C41C, 0x5D36AF05, 0x698A64DF, 0x86BA0FC6, 0x00F3F36B, 0xEFC39872,
+		0xDB7F53A8, 0x344F38B1, 0x97F8FAB0, 0x78C891A9, 0x4C745A73, 0xA344316A,
+		0x250DCDC7, 0xCA3DA6DE, 0xFE816D04, 0x11B1061D, 0xF7FEE2AF, 0x18CE89B6,
+		0x2C72426C, 0xC3422975, 0x450BD5D8, 0xAA3BBEC1, 0x9E87751B, 0x71B71E02,
+		0x57F4CA8E, 0xB8C4A197, 0x8C786A4D, 0x63480154, 0xE501FDF9, 0x0A3196E0,
+		0x3E8D5D3A, 0xD1BD3623, 0x37F2D291, 0xD8C2B988, 0xEC7E7252, 0x034E194B,
+		0x8507E5E6, 0x6A378EFF, 0x5E8B4525, 0xB1BB2E3C
+	},
+	{
+		0x00000000, 0x68032CC8, 0xD0065990, 0xB8057558, 0xA5E0C5D1, 0xCDE3E919,
+		0x75E69C41, 0x1DE5B089, 0x4E2DFD53, 0x262ED19B, 0x9E2BA4C3, 0xF628880B,
+		0xEBCD3882, 0x83CE144A, 0x3BCB6112, 0x53C84DDA, 0x9C5BFAA6, 0xF458D66E,
+		0x4C5DA336, 0x245E8FFE, 0x39BB3F77, 0x51B813BF, 0xE9BD66E7, 0x81BE4A2F,
+		0xD27607F5, 0xBA752B3D, 0x02705E65, 0x6A7372AD, 0x7796C224, 0x1F95EEEC,
+		0xA7909BB4, 0xCF93B77C, 0x3D5B83BD, 0x5558AF75, 0xED5DDA2D, 0x855EF6E5,
+		0x98BB466C, 0xF0B86AA4, 0x48BD1FFC, 0x20BE3334, 0x73767EEE, 0x1B755226,
+		0xA370277E, 0xCB730BB6, 0xD696BB3F, 0xBE9597F7, 0x0690E2AF, 0x6E93CE67,
+		0xA100791B, 0xC90355D3, 0x7106208B, 0x19050C43, 0x04E0BCCA, 0x6CE39002,
+		0xD4E6E55A, 0xBCE5C992, 0xEF2D8448, 0x872EA880, 0x3F2BDDD8, 0x5728F110,
+		0x4ACD4199, 0x22CE6D51, 0x9ACB1809, 0xF2C834C1, 0x7AB7077A, 0x12B42BB2,
+		0xAAB15EEA, 0xC2B27222, 0xDF57C2AB, 0xB754EE63, 0x0F519B3B, 0x6752B7F3,
+		0x349AFA29, 0x5C99D6E1, 0xE49CA3B9, 0x8C9F8F71, 0x917A3FF8, 0xF9791330,
+		0x417C6668, 0x297F4AA0, 0xE6ECFDDC, 0x8EEFD114, 0x36EAA44C, 0x5EE98884,
+		0x430C380D, 0x2B0F14C5, 0x930A619D, 0xFB094D55, 0xA8C1008F, 0xC0C22C47,
+		0x78C7591F, 0x10C475D7, 0x0D21C55E, 0x6522E996, 0xDD279CCE, 0xB524B006,
+		0x47EC84C7, 0x2FEFA80F, 0x97EADD57, 0xFFE9F19F, 0xE20C4116, 0x8A0F6DDE,
+		0x320A1886, 0x5A09344E, 0x09C17994, 0x61C2555C, 0xD9C72004, 0xB1C40CCC,
+		0xAC21BC45, 0xC422908D, 0x7C27E5D5, 0x1424C91D, 0xDBB77E61, 0xB3B452A9,
+		0x0BB127F1, 0x63B20B39, 0x7E57BBB0, 0x16549778, 0xAE51E220, 0xC652CEE8,
+		0x959A8332, 0xFD99AFFA, 0x459CDAA2, 0x2D9FF66A, 0x307A46E3, 0x58796A2B,
+		0xE07C1F73, 0x887F33BB, 0xF56E0EF4, 0x9D6D223C, 0x25685764, 0x4D6B7BAC,
+		0x508ECB25, 0x388DE7ED, 0x808892B5, 0xE88BBE7D, 0xBB43F3A7, 0xD340DF6F,
+		0x6B45AA37, 0x034686FF, 0x1EA33676, 0x76A01ABE, 0xCEA56FE6, 0xA6A6432E,
+		0x6935F452, 0x0136D89A, 0xB933ADC2, 0xD130810A, 0xCCD53183, 0xA4D61D4B,
+		0x1CD36813, 0x74D044DB, 0x27180901, 0x4F1B25C9, 0xF71E5091, 0x9F1D7C59,
+		0x82F8CCD0, 0xEAFBE018, 0x52FE9540, 0x3AFDB988, 0xC8358D49, 0xA036A181,
+		0x1833D4D9, 0x7030F811, 0x6DD54898, 0x05D66450, 0xBDD31108, 0xD5D03DC0,
+		0x8618701A, 0xEE1B5CD2, 0x561E298A, 0x3E1D0542, 0x23F8B5CB, 0x4BFB9903,
+		0xF3FEEC5B, 0x9BFDC093, 0x546E77EF, 0x3C6D5B27, 0x84682E7F, 0xEC6B02B7,
+		0xF18EB23E, 0x998D9EF6, 0x2188EBAE, 0x498BC766, 0x1A438ABC, 0x7240A674,
+		0xCA45D32C, 0xA246FFE4, 0xBFA34F6D, 0xD7A063A5, 0x6FA516FD, 0x07A63A35,
+		0x8FD9098E, 0xE7DA2546, 0x5FDF501E, 0x37DC7CD6, 0x2A39CC5F, 0x423AE097,
+		0xFA3F95CF, 0x923CB907, 0xC1F4F4DD, 0xA9F7D815, 0x11F2AD4D, 0x79F18185,
+		0x6414310C, 0x0C171DC4, 0xB412689C, 0xDC114454, 0x1382F328, 0x7B81DFE0,
+		0xC384AAB8, 0xAB878670, 0xB66236F9, 0xDE611A31, 0x66646F69, 0x0E6743A1,
+		0x5DAF0E7B, 0x35AC22B3, 0x8DA957EB, 0xE5AA7B23, 0xF84FCBAA, 0x904CE762,
+		0x2849923A, 0x404ABEF2, 0xB2828A33, 0xDA81A6FB, 0x6284D3A3, 0x0A87FF6B,
+		0x17624FE2, 0x7F61632A, 0xC7641672, 0xAF673ABA, 0xFCAF7760, 0x94AC5BA8,
+		0x2CA92EF0, 0x44AA0238, 0x594FB2B1, 0x314C9E79, 0x8949EB21, 0xE14AC7E9,
+		0x2ED97095, 0x46DA5C5D, 0xFEDF2905, 0x96DC05CD, 0x8B39B544, 0xE33A998C,
+		0x5B3FECD4, 0x333CC01C, 0x60F48DC6, 0x08F7A10E, 0xB0F2D456, 0xD8F1F89E,
+		0xC5144817, 0xAD1764DF, 0x15121187, 0x7D113D4F
+	},
+	{
+		0x00000000, 0x493C7D27, 0x9278FA4E, 0xDB448769, 0x211D826D, 0x6821FF4A,
+		0xB3657823, 0xFA590504, 0x423B04DA, 0x0B0779FD, 0xD043FE94, 0x997F83B3,
+		0x632686B7, 0x2A1AFB90, 0xF15E7CF9, 0xB86201DE, 0x847609B4, 0xCD4A7493,
+		0x160EF3FA, 0x5F328EDD, 0xA56B8BD9, 0xEC57F6FE, 0x37137197, 0x7E2F0CB0,
+		0xC64D0D6E, 0x8F717049, 0x5435F720, 0x1D098A07, 0xE7508F03, 0xAE6CF224,
+		0x7528754D, 0x3C14086A, 0x0D006599, 0x443C18BE, 0x9F789FD7, 0xD644E2F0,
+		0x2C1DE7F4, 0x65219AD3, 0xBE651DBA, 0xF759609D, 0x4F3B6143, 0x06071C64,
+		0xDD439B0D, 0x947FE62A, 0x6E26E32E, 0x271A9E09, 0xFC5E1960, 0xB5626447,
+		0x89766C2D, 0xC04A110A, 0x1B0E9663, 0x5232EB44, 0xA86BEE40, 0xE1579367,
+		0x3A13140E, 0x732F6929, 0xCB4D68F7, 0x827115D0, 0x593592B9, 0x1009EF9E,
+		0xEA50EA9A, 0xA36C97BD, 0x782810D4, 0x31146DF3, 0x1A00CB32, 0x533CB615,
+		0x8878317C, 0xC1444C5B, 0x3B1D495F, 0x72213478, 0xA965B311, 0xE059CE36,
+		0x583BCFE8, 0x1107B2CF, 0xCA4335A6, 0x837F4881, 0x79264D85, 0x301A30A2,
+		0xEB5EB7CB, 0xA262CAEC, 0x9E76C286, 0xD74ABFA1, 0x0C0E38C8, 0x453245EF,
+		0xBF6B40EB, 0xF6573DCC, 0x2D13BAA5, 0x642FC782, 0xDC4DC65C, 0x9571BB7B,
+		0x4E353C12, 0x07094135, 0xFD504431, 0xB46C3916, 0x6F28BE7F, 0x2614C358,
+		0x1700AEAB, 0x5E3CD38C, 0x857854E5, 0xCC4429C2, 0x361D2CC6, 0x7F2151E1,
+		0xA465D688, 0xED59ABAF, 0x553BAA71, 0x1C07D756, 0xC743503F, 0x8E7F2D18,
+		0x7426281C, 0x3D1A553B, 0xE65ED252, 0xAF62AF75, 0x9376A71F, 0xDA4ADA38,
+		0x010E5D51, 0x48322076, 0xB26B2572, 0xFB575855, 0x2013DF3C, 0x692FA21B,
+		0xD14DA3C5, 0x9871DEE2, 0x4335598B, 0x0A0924AC, 0xF05021A8, 0xB96C5C8F,
+		0x6228DBE6, 0x2B14A6C1, 0x34019664, 0x7D3DEB43, 0xA6796C2A, 0xEF45110D,
+		0x151C1409, 0x5C20692E, 0x8764EE47, 0xCE589360, 0x763A92BE, 0x3F06EF99,
+		0xE44268F0, 0xAD7E15D7, 0x572710D3, 0x1E1B6DF4, 0xC55FEA9D, 0x8C6397BA,
+		0xB0779FD0, 0xF94BE2F7, 0x220F659E, 0x6B3318B9, 0x916A1DBD, 0xD856609A,
+		0x0312E7F3, 0x4A2E9AD4, 0xF24C9B0A, 0xBB70E62D, 0x60346144, 0x29081C63,
+		0xD3511967, 0x9A6D6440, 0x4129E329, 0x08159E0E, 0x3901F3FD, 0x703D8EDA,
+		0xAB7909B3, 0xE2457494, 0x181C7190, 0x51200CB7, 0x8A648BDE, 0xC358F6F9,
+		0x7B3AF727, 0x32068A00, 0xE9420D69, 0xA07E704E, 0x5A27754A, 0x131B086D,
+		0xC85F8F04, 0x8163F223, 0xBD77FA49, 0xF44B876E, 0x2F0F0007, 0x66337D20,
+		0x9C6A7824, 0xD5560503, 0x0E12826A, 0x472EFF4D, 0xFF4CFE93, 0xB67083B4,
+		0x6D3404DD, 0x240879FA, 0xDE517CFE, 0x976D01D9, 0x4C2986B0, 0x0515FB97,
+		0x2E015D56, 0x673D2071, 0xBC79A718, 0xF545DA3F, 0x0F1CDF3B, 0x4620A21C,
+		0x9D642575, 0xD4585852, 0x6C3A598C, 0x250624AB, 0xFE42A3C2, 0xB77EDEE5,
+		0x4D27DBE1, 0x041BA6C6, 0xDF5F21AF, 0x96635C88, 0xAA7754E2, 0xE34B29C5,
+		0x380FAEAC, 0x7133D38B, 0x8B6AD68F, 0xC256ABA8, 0x19122CC1, 0x502E51E6,
+		0xE84C5038, 0xA1702D1F, 0x7A34AA76, 0x3308D751, 0xC951D255, 0x806DAF72,
+		0x5B29281B, 0x1215553C, 0x230138CF, 0x6A3D45E8, 0xB179C281, 0xF845BFA6,
+		0x021CBAA2, 0x4B20C785, 0x906440EC, 0xD9583DCB, 0x613A3C15, 0x28064132,
+		0xF342C65B, 0xBA7EBB7C, 0x4027BE78, 0x091BC35F, 0xD25F4436, 0x9B633911,
+		0xA777317B, 0xEE4B4C5C, 0x350FCB35, 0x7C33B612, 0x866AB316, 0xCF56CE31,
+		0x14124958, 0x5D2E347F, 0xE54C35A1, 0xAC704886, 0x7734CFEF, 0x3E08B2C8,
+		0xC451B7CC, 0x8D6DCAEB, 0x56294D82, 0x1F1530A5
+	}
+};
+#endif
+
+/*  unsigned long bcrc32cblk (unsigned long crc, const void * blk, int len)
+ *
+ *  Update the CRC-32C crc, the CRC of the data preceding blk (0 for none),
+ *  with the len bytes at blk, and return the new value.  If blk is NULL or
+ *  len is not positive, crc is returned unchanged.
+ */
+unsigned long bcrc32cblk (unsigned long crc, const void * blk, int len) {
+const unsigned char * p = (const unsigned char *) blk;
+
+	if (NULL == p || len <= 0) return crc;
+	crc = ~crc & BSHA_MASK;
+
+#if defined (__SSE4_2__) || defined (__ARM_FEATURE_CRC32)
+	{
+	unsigned int c = (unsigned int) crc;
+	unsigned long long w;
+	unsigned int v;
+
+		for (; len >= 8; p += 8, len -= 8) {
+			memcpy (&w, p, 8);
+#if defined (__SSE4_2__) && defined (__x86_64__)
+			c = (unsigned int) _mm_crc32_u64 (c, w);
+#elif defined (__SSE4_2__)
+			c = _mm_crc32_u32 (_mm_crc32_u32 (c, (unsigned int) w),
+			                   (unsigned int) (w >> 32));
+#else
+			c = __crc32cd (c, w);
+#endif
+		}
+		for (; len >= 4; p += 4, len -= 4) {
+			memcpy (&v, p, 4);
+#if defined (__SSE4_2__)
+			c = _mm_crc32_u32 (c, v);
+#else
+			c = __crc32cw (c, v);
+#endif
+		}
+		for (; len > 0; p++, len--) {
+#if defined (__SSE4_2__)
+			c = _mm_crc32_u8 (c, *p);
+#else
+			c = __crc32cb (c, *p);
+#endif
+		}
+		crc = c;
+	}
+#else
+	for (; len >= 8; p += 8, len -= 8) {
+		unsigned long lo = crc ^ (p[0] | ((unsigned long) p[1] << 8) |
+		                   ((unsigned long) p[2] << 16) | ((unsigned long) p[3] << 24));
+		crc = bCrcTable[7][lo & 0xFF] ^ bCrcTable[6][(lo >> 8) & 0xFF] ^
+		      bCrcTable[5][(lo >> 16) & 0xFF] ^ bCrcTable[4][lo >> 24] ^
+		      bCrcTable[3][p[4]] ^ bCrcTable[2][p[5]] ^
+		      bCrcTable[1][p[6]] ^ bCrcTable[0][p[7]];
+	}
+	for (; len > 0; p++, len--) {
+		crc = bCrcTable[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+	}
+#endif
+
+	return ~crc & BSHA_MASK;
+}
+
+/*  unsigned long bcrc32c (const_bstring b)
+ *
+ *  Returns the CRC-32C of the content of b, or 0 if b is NULL or invalid.
+ */
+unsigned long bcrc32c (const_bstring b) {
+	if (NULL == b || NULL == b->data || b->slen < 0) return 0;
+	return bcrc32cblk (0, b->data, b->slen);
+}
+
+#define BH64_P1 (0x9E3779B185EBCA87ULL)
+#define BH64_P2 (0xC2B2AE3D27D4EB4FULL)
+#define BH64_P3 (0x165667B19E3779F9ULL)
+#define BH64_P4 (0x85EBCA77C2B2AE63ULL)
+#define BH64_P5 (0x27D4EB2F165667C5ULL)
+#define BH64_ROL(x,n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static unsigned long long bHash64Load (const unsigned char * p, int n) {
+unsigned long long v = 0;
+	while (n-- > 0) v = (v << 8) | p[n];
+	return v;
+}
+
+static unsigned long long bHash64Round (unsigned long long acc, unsigned long long v) {
+	acc += v * BH64_P2;
+	return BH64_ROL (acc, 31) * BH64_P1;
+}
+
+/*  unsigned long long bHash64 (const_bstring b, unsigned long long seed)
+ *
+ *  Returns the 64 bit XXH64 hash of the content of b with the given seed.
+ *  The input is consumed 32 bytes at a time by four independent
+ *  multiply-rotate lanes.  This is not a cryptographic hash.  If b is NULL
+ *  or invalid, 0 is returned.
+ */
+unsigned long long bHash64 (const_bstring b, unsigned long long seed) {
+const unsigned char * p;
+unsigned long long h, v0, v1, v2, v3;
+int len;
+
+	if (NULL == b || NULL == b->data || b->slen < 0) return 0;
+	p = b->data;
+	len = b->slen;
+
+	if (len >= 32) {
+		v0 = seed + BH64_P1 + BH64_P2;
+		v1 = seed + BH64_P2;
+		v2 = seed;
+		v3 = seed - BH64_P1;
+		for (; len >= 32; p += 32, len -= 32) {
+			v0 = bHash64Round (v0, bHash64Load (p, 8));
+			v1 = bHash64Round (v1, bHash64Load (p + 8, 8));
+			v2 = bHash64Round (v2, bHash64Load (p + 16, 8));
+			v3 = bHash64Round (v3, bHash64Load (p + 24, 8));
+		}
+		h = BH64_ROL (v0, 1) + BH64_ROL (v1, 7) + BH64_ROL (v2, 12) + BH64_ROL (v3, 18);
+		h = (h ^ bHash64Round (0, v0)) * BH64_P1 + BH64_P4;
+		h = (h ^ bHash64Round (0, v1)) * BH64_P1 + BH64_P4;
+		h = (h ^ bHash64Round (0, v2)) * BH64_P1 + BH64_P4;
+		h = (h ^ bHash64Round (0, v3)) * BH64_P1 + BH64_P4;
+	} else {
+		h = seed + BH64_P5;
+	}
+	h += (unsigned long long) b->slen;
+
+	for (; len >= 8; p += 8, len -= 8) {
+		h ^= bHash64Round (0, bHash64Load (p, 8));
+		h = BH64_ROL (h, 27) * BH64_P1 + BH64_P4;
+	}
+	if (len >= 4) {
+		h ^= bHash64Load (p, 4) * BH64_P1;
+		h = BH64_ROL (h, 23) * BH64_P2 + BH64_P3;
+		p += 4;
+		len -= 4;
+	}
+	for (; len > 0; p++, len--) {
+		h ^= *p * BH64_P5;
+		h = BH64_ROL (h, 11) * BH64_P1;
+	}
+
+	h ^= h >> 33;
+	h *= BH64_P2;
+	h ^= h >> 29;
+	h *= BH64_P3;
+	h ^= h >> 32;
+	return h;
+}
+
+struct bsCrcCtx {
+	struct bStream * sInp;
+	unsigned long * crc;
+	bstring buf;
+};
+
+static size_t bsCrc32cPart (void * buff, size_t elsize, size_t nelem, void * parm) {
+struct bsCrcCtx * ctx = (struct bsCrcCtx *) parm;
+size_t tsz;
+
+	if (NULL == buff || NULL == parm || 0 == elsize) return 0;
+	tsz = elsize * nelem;
+	if (tsz > INT_MAX - 1) tsz = INT_MAX - 1;
+
+	if (0 > bsread (ctx->buf, ctx->sInp, (int) tsz) || 0 == ctx->buf->slen) {
+		/* Deallocate once EOF becomes triggered */
+		bdestroy (ctx->buf);
+		free (ctx);
+		return 0;
+	}
+	memcpy (buff, ctx->buf->data, ctx->buf->slen);
+	*ctx->crc = bcrc32cblk (*ctx->crc, ctx->buf->data, ctx->buf->slen);
+	return ctx->buf->slen / elsize;
+}
+
+/*  struct bStream * bsCrc32c (struct bStream * sInp, unsigned long * crc)
+ *
+ *  Creates a bStream which reads the content of sInp unchanged, while
+ *  updating *crc with the CRC-32C of each byte that passes through.  *crc
+ *  should be 0 (or the CRC of data preceding sInp) before reading begins.
+ *  The stream should be read to its end before being closed with bsclose,
+ *  after which sInp may be closed.  NULL is returned on error.
+ */
+struct bStream * bsCrc32c (struct bStream * sInp, unsigned long * crc) {
+struct bsCrcCtx * ctx;
+struct bStream * sOut;
+
+	if (NULL == sInp || NULL == crc) return NULL;
+	if (NULL == (ctx = (struct bsCrcCtx *) malloc (sizeof (struct bsCrcCtx))))
+		return NULL;
+	ctx->sInp = sInp;
+	ctx->crc = crc;
+	if (NULL == (ctx->buf = bfromcstr ("")) ||
+	    NULL == (sOut = bsopen ((bNread) bsCrc32cPart, ctx))) {
+		bdestroy (ctx->buf);
+		free (ctx);
+		return NULL;
+	}
+	return sOut;
+}
+
+/*  int bwsCrc32c (struct bwriteStream * ws, unsigned long * crc)
+ *
+ *  Attach the CRC-32C accumulator crc to ws.  Data already buffered in ws
+ *  is first flushed to the core stream, so it counts towards the
+ *  accumulator previously attached, if any, rather than crc.  Each block
+ *  subsequently delivered to the core stream updates *crc, so once
+ *  bwsWriteFlush has been called, *crc is the CRC-32C of everything written
+ *  since attachment (continued from the initial value of *crc).  A NULL crc
+ *  detaches the accumulator.  BSTR_ERR is returned if the flush fails.
+ */
+int bwsCrc32c (struct bwriteStream * ws, unsigned long * crc) {
+	if (NULL == ws || NULL == ws->buff || 0 >= ws->minBuffSz ||
+	    NULL == ws->writeFn) return BSTR_ERR;
+	if (ws->buff->slen > 0 && BSTR_OK != bwsWriteFlush (ws)) return BSTR_ERR;
+	ws->crc = crc;
+	return BSTR_OK;
+}
+
+/*
+ *  Byte translation tables, in the manner of tr.  A byte is "active" if it
+ *  is deleted, translated to another byte, or squeezed; runs of inactive
+ *  bytes are moved in bulk.  When there are at most BTR_SCAN active bytes,
+ *  such runs are found a machine word at a time.
+ */
+#define BTR_WORD         unsigned long
+#define BTR_WSZ          ((int) sizeof (BTR_WORD))
+#define BTR_ONES         (((BTR_WORD) ~(BTR_WORD) 0) / 0xFF)
+#define BTR_HASZERO(x)   (((x) - BTR_ONES) & ~(x) & (BTR_ONES << 7))
+
+/* Expand the tr style set s, in which "a-z" stands for the range of bytes
+   from a to z inclusive, into the bytes it lists.  A '-' at either end of s
+   stands for itself. */
+static bstring bTrExpand (const_bstring s) {
+bstring r;
+int i, c;
+
+	if (NULL == (r = bfromcstr (""))) return NULL;
+	if (NULL == s) return r;
+	if (NULL == s->data || s->slen < 0) goto Fail;
+	for (i = 0; i < s->slen; i++) {
+		if (i + 2 < s->slen && '-' == s->data[i + 1]) {
+			if (s->data[i] > s->data[i + 2]) goto Fail;
+			for (c = s->data[i]; c <= s->data[i + 2]; c++) {
+				if (0 > bconchar (r, (char) c)) goto Fail;
+			}
+			i += 2;
+		} else if (0 > bconchar (r, (char) s->data[i])) goto Fail;
+	}
+	return r;
+
+	Fail:;
+	bdestroy (r);
+	return NULL;
+}
+
+/*  int bTrCompile (struct bTrTable * t, const_bstring from, const_bstring to,
+ *                  const_bstring del, const_bstring squeeze)
+ *
+ *  Compile a translation table into t.  Each byte of the set from is
+ *  translated to the byte in the same position of the set to, where to is
+ *  extended with copies of its last byte if it is shorter than from.  Bytes
+ *  of the set del are deleted, and each run of a repeated output byte of the
+ *  set squeeze is replaced by a single occurrence.  In each set "a-z" stands
+ *  for a range of bytes.  Any of the sets may be NULL, except that to may
+ *  not be NULL or empty if from is not.  BSTR_OK or BSTR_ERR is returned.
+ */
+int bTrCompile (struct bTrTable * t, const_bstring from, const_bstring to,
+                const_bstring del, const_bstring squeeze) {
+bstring f, m = NULL, d = NULL, s = NULL;
+int i, c, ret = BSTR_ERR;
+
+	if (NULL == t || NULL == (f = bTrExpand (from))) return BSTR_ERR;
+	if (NULL == (m = bTrExpand (to)) || NULL == (d = bTrExpand (del)) ||
+	    NULL == (s = bTrExpand (squeeze)) || (f->slen > 0 && m->slen <= 0))
+		goto Done;
+
+	for (i = 0; i < 256; i++) {
+		t->map[i] = (unsigned char) i;
+		t->flags[i] = 0;
+	}
+	for (i = 0; i < f->slen; i++) {
+		t->map[f->data[i]] = m->data[(i < m->slen) ? i : m->slen - 1];
+	}
+	for (i = 0; i < d->slen; i++) t->flags[d->data[i]] |= BTR_DELETE;
+	for (i = 0; i < s->slen; i++) t->flags[s->data[i]] |= BTR_SQUEEZE;
+
+	t->nact = 0;
+	for (i = 0; i < 256; i++) {
+		c = (t->flags[i] & BTR_DELETE) || t->map[i] != i ||
+		    (t->flags[t->map[i]] & BTR_SQUEEZE);
+		t->active[i] = (unsigned char) c;
+		if (c) {
+			if (t->nact < BTR_SCAN) t->act[t->nact] = (unsigned char) i;
+			t->nact++;
+		}
+	}
+	ret = BSTR_OK;
+
+	Done:;
+	bdestroy (s);
+	bdestroy (d);
+	bdestroy (m);
+	bdestroy (f);
+	return ret;
+}
+
+/* Translate the len bytes at s to d, where d may be s, returning the length
+   of the output, which is never more than len.  *last is the preceding
+   output byte, or -1. */
+static int bTrRun (unsigned char * d, const unsigned char * s, int len,
+                   const struct bTrTable * t, int * last) {
+BTR_WORD pat[BTR_SCAN], w, x;
+int i, j, k, o, c, l = *last;
+
+	for (k = 0; k < t->nact && k < BTR_SCAN; k++) pat[k] = BTR_ONES * t->act[k];
+
+	for (i = o = 0; i < len;) {
+		j = i;
+		if (t->nact <= BTR_SCAN) {
+			for (; j + BTR_WSZ <= len; j += BTR_WSZ) {
+				memcpy (&w, s + j, BTR_WSZ);
+				for (x = 0, k = 0; k < t->nact; k++) x |= BTR_HASZERO (w ^ pat[k]);
+				if (x) break;
+			}
+		}
+		while (j < len && !t->active[s[j]]) j++;
+
+		if (j > i) {
+			if (d + o != s + i) memmove (d + o, s + i, j - i);
+			o += j - i;
+			l = s[j - 1];
+			i = j;
+			if (i >= len) break;
+		}
+
+		c = s[i++];
+		if (t->flags[c] & BTR_DELETE) continue;
+		c = t->map[c];
+		if ((t->flags[c] & BTR_SQUEEZE) && l == c) continue;
+		d[o++] = (unsigned char) (l = c);
+	}
+
+	*last = l;
+	return o;
+}
+
+/*  int bTranslate (bstring b, const struct bTrTable * t)
+ *
+ *  Apply the translation table t, compiled by bTrCompile, to b in place.
+ *  The content of b never grows.  BSTR_OK or BSTR_ERR is returned.
+ */
+int bTranslate (bstring b, const struct bTrTable * t) {
+int last = -1;
+
+	if (NULL == b || NULL == b->data || b->slen < 0 || b->mlen <= 0 ||
+	    b->mlen < b->slen || NULL == t) return BSTR_ERR;
+	if (0 == t->nact) return BSTR_OK;
+	b->slen = bTrRun (b->data, b->data, b->slen, t, &last);
+	b->data[b->slen] = (unsigned char) '\0';
+	return BSTR_OK;
+}
+
+struct bsTrCtx {
+	struct bTrTable t;
+	struct bStream * sInp;
+	bstring buf;
+	int last;
+};
+
+static size_t bsTrPart (void * buff, size_t elsize, size_t nelem, void * parm) {
+struct bsTrCtx * ctx = (struct bsTrCtx *) parm;
+size_t tsz;
+int l;
+
+	if (NULL == buff || NULL == parm || 0 == elsize) return 0;
+	tsz = elsize * nelem;
+	if (tsz > INT_MAX - 1) tsz = INT_MAX - 1;
+
+	/* Keep reading until something survives deletion and squeezing */
+	while (0 <= bsread (ctx->buf, ctx->sInp, (int) tsz) && ctx->buf->slen > 0) {
+		l = bTrRun ((unsigned char *) buff, ctx->buf->data, ctx->buf->slen,
+		            &ctx->t, &ctx->last);
+		if (l > 0) return l / elsize;
+	}
+
+	/* Deallocate once EOF becomes triggered */
+	bdestroy (ctx->buf);
+	free (ctx);
+	return 0;
+}
+
+/*  struct bStream * bsTranslate (struct bStream * sInp,
+ *                                const struct bTrTable * t)
+ *
+ *  Creates a bStream which reads the content of sInp translated by the
+ *  table t as bTranslate does.  The table is copied, so t need not outlive
+ *  the call.  The stream should be read to its end before being closed with
+ *  bsclose, after which sInp may be closed.  NULL is returned on error.
+ */
+struct bStream * bsTranslate (struct bStream * sInp, const struct bTrTable * t) {
+struct bsTrCtx * ctx;
+struct bStream * sOut;
+
+	if (NULL == sInp || NULL == t) return NULL;
+	if (NULL == (ctx = (struct bsTrCtx *) malloc (sizeof (struct bsTrCtx))))
+		return NULL;
+	ctx->t = *t;
+	ctx->sInp = sInp;
+	ctx->last = -1;
+	if (NULL == (ctx->buf = bfromcstr ("")) ||
+	    NULL == (sOut = bsopen ((bNread) bsTrPart, ctx))) {
+		bdestroy (ctx->buf);
+		free (ctx);
+		return NULL;
+	}
+	return sOut;
+}
+
+/*
+ *  HTTP/1.x request heads.  The head is parsed only once it is complete, so
+ *  bHttpParse only has to search the bytes appended since its last call for
+ *  the empty line which ends the head.  The views it produces point into the
+ *  buffer holding the head.
+ */
+
+/* The token characters of RFC 7230, 3.2.6 */
+static int bHttpTchar (int c) {
+	if (c >= 'a' && c <= 'z') return 1;
+	if (c >= 'A' && c <= 'Z') return 1;
+	if (c >= '0' && c <= '9') return 1;
+	return NULL != strchr ("!#$%&'*+-.^_`|~", c) && c != '\0';
+}
+
+/*  int bHttpInit (struct bHttpRequest * r)
+ *
+ *  Prepare r for parsing a new request head with bHttpParse.
+ */
+int bHttpInit (struct bHttpRequest * r) {
+	if (NULL == r) return BSTR_ERR;
+	r->qty = 0;
+	r->minor = -1;
+	r->scanned = 0;
+	return BSTR_OK;
+}
+
+/* Return the length of the line of d starting at p without its line
+   terminator, and store the position following the terminator in *next. */
+static int bHttpLine (const unsigned char * d, int p, int end, int * next) {
+const unsigned char * q;
+int l;
+
+	q = (const unsigned char *) memchr (d + p, '\n', end - p);
+	l = (int) (q - d) - p;
+	*next = p + l + 1;
+	if (l > 0 && d[p + l - 1] == '\r') l--;
+	return l;
+}
+
+/* Search the len bytes of d for an empty line among the lines beginning
+   at start, continuing the search from *scan, which should initially be
+   start.  The position following the empty line is returned.  If there is
+   none yet, 0 is returned; either way *scan is left where a later search,
+   once more data has been appended to d, should continue. */
+static int bHttpEnd (const unsigned char * d, int start, int * scan, int len) {
+const unsigned char * q;
+int i = *scan, first = (i == start), r;
+
+	for (;; first = 0) {
+		if (!first) {
+			q = (const unsigned char *) memchr (d + i, '\n', len - i);
+			if (NULL == q) {
+				*scan = len;
+				return 0;
+			}
+			i = (int) (q - d) + 1;
+		}
+		/* i is the start of a line, and r the position to resume from */
+		r = first ? start : i - 1;
+		if (i >= len || (i + 1 >= len && d[i] == '\r')) {
+			*scan = r;
+			return 0;
+		}
+		if (d[i] == '\n' || (d[i] == '\r' && d[i + 1] == '\n')) {
+			*scan = r;
+			return i + 1 + (d[i] == '\r');
+		}
+	}
+}
+
+/* Parse the header field lines of d from p up to the empty line ending at
+   end into h, returning their number or BSTR_ERR.  Field values have the
+   whitespace around them removed. */
+static int bHttpFields (const unsigned char * d, int p, int end,
+                        struct bHttpHeader * h, int max) {
+int i, l, qty, next;
+
+	for (qty = 0; ; p = next, qty++) {
+		if (0 == (l = bHttpLine (d, p, end, &next))) return qty;
+		if (qty >= max) return BSTR_ERR;
+		for (i = p; i < p + l && bHttpTchar (d[i]); i++) ;
+		if (i == p || i >= p + l || d[i] != ':') return BSTR_ERR;
+		blk2tbstr (h[qty].name, d + p, i - p);
+		for (i++; i < p + l && (d[i] == ' ' || d[i] == '\t'); i++) ;
+		for (l += p; l > i && (d[l - 1] == ' ' || d[l - 1] == '\t'); l--) {}
+		blk2tbstr (h[qty].value, d + i, l - i);
+	}
+}
+
+/*  int bHttpParse (struct bHttpRequest * r, const_bstring buf)
+ *
+ *  Parse the HTTP/1.x request head at the start of buf into r, which must
+ *  have been prepared with bHttpInit.  If buf does not yet hold the entire
+ *  head, 0 is returned, and bHttpParse should be called again with the same
+ *  r once more data has been appended to buf; only the new data is searched.
+ *  Otherwise the length of the head, including the empty line ending it, is
+ *  returned and r holds read only views into buf of the method, request
+ *  target, and the names and values of up to BHTTP_MAX_HEADERS header
+ *  fields, with the whitespace around values removed.  Lines may end with
+ *  "\r\n" or "\n".  BSTR_ERR is returned if the head is malformed, uses
+ *  obsolete line folding, or has too many header fields.
+ */
+int bHttpParse (struct bHttpRequest * r, const_bstring buf) {
+const unsigned char * d;
+int p, i, l, end, next;
+
+	if (NULL == r || NULL == buf || NULL == buf->data || buf->slen < 0 ||
+	    r->scanned < 0 || r->scanned > buf->slen) return BSTR_ERR;
+	d = buf->data;
+	if (0 == (end = bHttpEnd (d, 0, &r->scanned, buf->slen))) return 0;
+
+	/* The request line: method SP request-target SP HTTP-version */
+	l = bHttpLine (d, 0, end, &next);
+	for (i = 0; i < l && bHttpTchar (d[i]); i++) ;
+	if (i == 0 || i >= l || d[i] != ' ') return BSTR_ERR;
+	blk2tbstr (r->method, d, i);
+	for (p = ++i; i < l && d[i] > ' ' && d[i] != 0x7F; i++) ;
+	if (i == p || i >= l || d[i] != ' ') return BSTR_ERR;
+	blk2tbstr (r->path, d + p, i - p);
+	i++;
+	if (l - i != 8 || 0 != memcmp (d + i, "HTTP/1.", 7) ||
+	    d[i + 7] < '0' || d[i + 7] > '9') return BSTR_ERR;
+	r->minor = d[i + 7] - '0';
+
+	/* Header fields: field-name ":" OWS field-value OWS */
+	if (0 > (r->qty = bHttpFields (d, next, end, r->header, BHTTP_MAX_HEADERS))) {
+		r->qty = 0;
+		return BSTR_ERR;
+	}
+	return end;
+}
+
+/*  int bHttpFind (const struct bHttpRequest * r, const_bstring name, int pos)
+ *
+ *  Returns the index of the first header field of r at or after index pos
+ *  whose name matches name without regard to case, or BSTR_ERR if there is
+ *  none.
+ */
+int bHttpFind (const struct bHttpRequest * r, const_bstring name, int pos) {
+int i;
+
+	if (NULL == r || NULL == name || NULL == name->data || name->slen < 0 ||
+	    pos < 0) return BSTR_ERR;
+	for (i = pos; i < r->qty; i++) {
+		if (r->header[i].name.slen == name->slen &&
+		    1 == biseqcaseless (&r->header[i].name, name)) return i;
+	}
+	return BSTR_ERR;
+}
+
+/*  int bsHttpRead (struct bHttpRequest * r, bstring buf, struct bStream * s,
+ *                  int maxLen)
+ *
+ *  Read an HTTP/1.x request head from s into buf, replacing its content, and
+ *  parse it into r as bHttpParse does.  Each step reads only what s has
+ *  buffered, or a single read of the core stream, and never more than is
+ *  left of maxLen, so at most maxLen bytes are held and a head split across
+ *  any number of reads of the core stream is handled.  Anything read past
+ *  the end of the head is returned to s with bsunread, so no part of the
+ *  request body is consumed.  The length of the head is returned.  If s
+ *  ends before anything is read, 0 is returned.  BSTR_ERR is returned on
+ *  error, if s ends before the head is complete, or if the head is longer
+ *  than maxLen bytes.
+ */
+int bsHttpRead (struct bHttpRequest * r, bstring buf, struct bStream * s,
+                int maxLen) {
+struct tagbstring t;
+bstring p;
+int n, ret;
+
+	if (NULL == s || maxLen <= 0 || BSTR_OK != bHttpInit (r) ||
+	    NULL == buf || buf->slen < 0 || buf->mlen <= 0) return BSTR_ERR;
+	if (NULL == (p = bfromcstr (""))) return BSTR_ERR;
+	buf->slen = 0;
+	for (ret = BSTR_ERR; buf->slen < maxLen;) {
+		/* Take what is buffered, or else make one read of the core stream;
+		   either way no more than is left of maxLen. */
+		if (BSTR_OK != bspeek (p, s)) break;
+		n = (p->slen > 0) ? p->slen : bsbufflength (s, BSTR_BS_BUFF_LENGTH_GET);
+		if (n > maxLen - buf->slen) n = maxLen - buf->slen;
+		if (BSTR_OK != balloc (buf, buf->slen + n + 1)) break;
+		if (BSTR_OK != bsreada (buf, s, n)) {
+			if (0 == buf->slen) ret = 0;
+			break;
+		}
+		if (0 > (ret = bHttpParse (r, buf))) break;
+		if (ret > 0) {
+			if (ret > maxLen) {
+				ret = BSTR_ERR;
+			} else if (ret < buf->slen) {
+				blk2tbstr (t, buf->data + ret, buf->slen - ret);
+				if (BSTR_OK != bsunread (s, &t)) ret = BSTR_ERR;
+				else btrunc (buf, ret);
+			}
+			break;
+		}
+		ret = BSTR_ERR;
+	}
+	bdestroy (p);
+	return ret;
+}
+
+/*
+ *  Quoted-printable (RFC 2045, 6.7).  CRLF is a hard line break and is kept;
+ *  every other byte which is not printable ASCII, '=', and whitespace at the
+ *  end of a line or of the data are written as =XX, so decoding restores the
+ *  input exactly.  Encoded lines are broken with soft line breaks ("=" CRLF)
+ *  to at most 76 characters.  Runs of bytes which need no attention are
+ *  found a machine word at a time and copied with memcpy.
+ */
+#define BQP_LINE         (75)   /* Columns available before a soft break */
+#define BQP_ONES         BTR_ONES
+#define BQP_HIGH         (BQP_ONES << 7)
+#define BQP_HASLESS(x,n) (((x) - BQP_ONES * (n)) & ~(x) & BQP_HIGH)
+#define BQP_HASMORE(x,n) ((((x) + BQP_ONES * (127 - (n))) | (x)) & BQP_HIGH)
+
+static const char bQpHex[] = "0123456789ABCDEF";
+
+static int bQpHexVal (int c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+/* The number of bytes at d, up to len, which are printable ASCII other than
+   '=' (the encoder) or which are not '=', ' ' or '\t' (the decoder). */
+static int bQpRun (const unsigned char * d, int len, int enc) {
+BTR_WORD w;
+int i;
+
+	for (i = 0; i + BTR_WSZ <= len; i += BTR_WSZ) {
+		memcpy (&w, d + i, BTR_WSZ);
+		if (enc) {
+			if (BQP_HASLESS (w, 33) | BQP_HASMORE (w, 126) | BTR_HASZERO (w ^ (BQP_ONES * '='))) break;
+		} else {
+			if (BTR_HASZERO (w ^ (BQP_ONES * '=')) | BTR_HASZERO (w ^ (BQP_ONES * ' ')) |
+			    BTR_HASZERO (w ^ (BQP_ONES * '\t'))) break;
+		}
+	}
+	if (enc) {
+		for (; i < len && d[i] > ' ' && d[i] < 127 && d[i] != '='; i++) ;
+	} else {
+		for (; i < len && d[i] != '=' && d[i] != ' ' && d[i] != '\t'; i++) ;
+	}
+	return i;
+}
+
+/* Encode the len bytes at d to o, or just count the output if o is NULL,
+   continuing from column *col.  Unless final is set, a last byte whose
+   encoding depends on what follows it is left unconsumed.  The number of
+   bytes consumed is stored in *used and the output length is returned. */
+static int bQpEnc (unsigned char * o, const unsigned char * d, int len,
+                   int * col, int final, int * used) {
+int i, n, l, c, k = 0, cl = *col;
+
+	for (i = 0; i < len;) {
+		n = bQpRun (d + i, len - i, 1);
+		while (n > 0) {
+			if (cl >= BQP_LINE) {
+				if (o) memcpy (o + k, "=\r\n", 3);
+				k += 3;
+				cl = 0;
+			}
+			l = (n < BQP_LINE - cl) ? n : BQP_LINE - cl;
+			if (o) memcpy (o + k, d + i, l);
+			k += l;
+			cl += l;
+			i += l;
+			n -= l;
+		}
+		if (i >= len) break;
+
+		c = d[i];
+		if (c == '\r' || c == ' ' || c == '\t') {
+			if (i + 1 >= len && !final) break;
+			if (c == '\r' && i + 1 < len && d[i + 1] == '\n') {
+				if (o) memcpy (o + k, "\r\n", 2);
+				k += 2;
+				cl = 0;
+				i += 2;
+				continue;
+			}
+		}
+		l = ((c == ' ' || c == '\t') && i + 1 < len &&
+		     !(d[i + 1] == '\r' && (i + 2 >= len || d[i + 2] == '\n'))) ? 1 : 3;
+		if (l == 3 && (c == ' ' || c == '\t') && i + 2 >= len && !final) break;
+		if (cl + l > BQP_LINE) {
+			if (o) memcpy (o + k, "=\r\n", 3);
+			k += 3;
+			cl = 0;
+		}
+		if (o) {
+			if (l == 1) o[k] = (unsigned char) c;
+			else {
+				o[k] = '=';
+				o[k + 1] = (unsigned char) bQpHex[c >> 4];
+				o[k + 2] = (unsigned char) bQpHex[c & 15];
+			}
+		}
+		k += l;
+		cl += l;
+		i++;
+	}
+
+	*col = cl;
+	*used = i;
+	return k;
+}
+
+/* Decode the len bytes at d to o, which may be d itself.  Unless final is
+   set, decoding stops before a sequence which may be completed by data
+   which follows.  The number of bytes consumed is stored in *used and the
+   output length is returned. */
+static int bQpDec (unsigned char * o, const unsigned char * d, int len,
+                   int final, int * used) {
+int i, j, n, h, l, k = 0;
+
+	for (i = 0; i < len;) {
+		if (0 < (n = bQpRun (d + i, len - i, 0))) {
+			if (o + k != d + i) memmove (o + k, d + i, n);
+			k += n;
+			i += n;
+			if (i >= len) break;
+		}
+
+		/* The whitespace from j up to i is followed by a line end */
+		j = i + (d[i] == '=');
+		for (l = j; l < len && (d[l] == ' ' || d[l] == '\t'); l++) ;
+		if (l >= len || (d[l] == '\r' && l + 1 >= len)) {
+			if (!final) break;
+			if (l >= len) {
+				i = len;
+				continue;
+			}
+		}
+		if (d[l] == '\n' || (d[l] == '\r' && l + 1 < len && d[l + 1] == '\n')) {
+			i = (d[i] == '=') ? l + 1 + (d[l] == '\r') : l;
+			continue;
+		}
+
+		if (d[i] != '=' || l > j) {
+			/* Whitespace within a line, or a stray '=' */
+			n = (l > j) ? l - i : 1;
+			if (o + k != d + i) memmove (o + k, d + i, n);
+			k += n;
+			i += n;
+			continue;
+		}
+		if (i + 2 >= len && !final) break;
+		if (i + 2 < len && 0 <= (h = bQpHexVal (d[i + 1])) && 0 <= (n = bQpHexVal (d[i + 2]))) {
+			o[k++] = (unsigned char) ((h << 4) | n);
+			i += 3;
+		} else {
+			o[k++] = '=';
+			i++;
+		}
+	}
+
+	*used = i;
+	return k;
+}
+
+/*  bstring bQpEncode (const_bstring b)
+ *
+ *  Generate a quoted-printable encoding of b.  CRLF pairs are kept as hard
+ *  line breaks.  See: RFC2045
+ */
+bstring bQpEncode (const_bstring b) {
+bstring out;
+int col = 0, used, n;
+
+	if (b == NULL || b->slen < 0 || b->data == NULL) return NULL;
+	n = bQpEnc (NULL, b->data, b->slen, &col, 1, &used);
+	if (NULL == (out = bfromcstralloc (n + 1, ""))) return NULL;
+	col = 0;
+	out->slen = bQpEnc (out->data, b->data, b->slen, &col, 1, &used);
+	out->data[out->slen] = (unsigned char) '\0';
+	return out;
+}
+
+/*  bstring bQpDecode (const_bstring b)
+ *
+ *  Decode a quoted-printable block of data.  Soft line breaks and trailing
+ *  whitespace on lines are removed; an '=' which does not begin a valid
+ *  escape is kept as it is.  See: RFC2045
+ */
+bstring bQpDecode (const_bstring b) {
+bstring out;
+int used;
+
+	if (b == NULL || b->slen < 0 || b->data == NULL) return NULL;
+	if (NULL == (out = bfromcstralloc (b->slen + 1, ""))) return NULL;
+	out->slen = bQpDec (out->data, b->data, b->slen, 1, &used);
+	out->data[out->slen] = (unsigned char) '\0';
+	return out;
+}
+
+struct bsQpCtx {
+	struct bStream * sInp;
+	bstring src, dst;
+	int encode, col, eof;
+};
+
+static size_t bsQpPart (void * buff, size_t elsize, size_t nelem, void * parm) {
+struct bsQpCtx * ctx = (struct bsQpCtx *) parm;
+size_t tsz;
+int n, used, col;
+
+	if (NULL == buff || NULL == parm || 0 == elsize) return 0;
+	tsz = elsize * nelem;
+
+	while ((size_t) ctx->dst->slen < tsz && !ctx->eof) {
+		if (0 > bsreada (ctx->src, ctx->sInp, bsbufflength (ctx->sInp, BSTR_BS_BUFF_LENGTH_GET)))
+			ctx->eof = 1;
+		if (ctx->encode) {
+			col = ctx->col;
+			n = bQpEnc (NULL, ctx->src->data, ctx->src->slen, &col, ctx->eof, &used);
+		} else n = ctx->src->slen;
+		if (BSTR_OK != balloc (ctx->dst, ctx->dst->slen + n + 1)) break;
+		if (ctx->encode) {
+			n = bQpEnc (ctx->dst->data + ctx->dst->slen, ctx->src->data,
+			            ctx->src->slen, &ctx->col, ctx->eof, &used);
+		} else {
+			n = bQpDec (ctx->dst->data + ctx->dst->slen, ctx->src->data,
+			            ctx->src->slen, ctx->eof, &used);
+		}
+		ctx->dst->slen += n;
+		bdelete (ctx->src, 0, used);
+	}
+
+	if (ctx->dst->slen > 0) {
+		n = ((size_t) ctx->dst->slen < tsz) ? ctx->dst->slen : (int) tsz;
+		memcpy (buff, ctx->dst->data, n);
+		bdelete (ctx->dst, 0, n);
+		return n / elsize;
+	}
+
+	/* Deallocate once EOF becomes triggered */
+	bdestroy (ctx->src);
+	bdestroy (ctx->dst);
+	free (ctx);
+	return 0;
+}
+
+static struct bStream * bsQpOpen (struct bStream * sInp, int encode) {
+struct bsQpCtx * ctx;
+struct bStream * sOut;
+
+	if (NULL == sInp) return NULL;
+	if (NULL == (ctx = (struct bsQpCtx *) malloc (sizeof (struct bsQpCtx))))
+		return NULL;
+	ctx->sInp = sInp;
+	ctx->encode = encode;
+	ctx->col = 0;
+	ctx->eof = 0;
+	ctx->src = bfromcstr ("");
+	ctx->dst = bfromcstr ("");
+	if (NULL == ctx->src || NULL == ctx->dst ||
+	    NULL == (sOut = bsopen ((bNread) bsQpPart, ctx))) {
+		bdestroy (ctx->src);
+		bdestroy (ctx->dst);
+		free (ctx);
+		return NULL;
+	}
+	return sOut;
+}
+
+/*  struct bStream * bsQpEncode (struct bStream * sInp)
+ *
+ *  Creates a bStream which reads the quoted-printable encoding of the
+ *  content of sInp, as bQpEncode would produce it.  The stream should be
+ *  read to its end before being closed with bsclose, after which sInp may
+ *  be closed.  NULL is returned on error.
+ */
+struct bStream * bsQpEncode (struct bStream * sInp) {
+	return bsQpOpen (sInp, 1);
+}
+
+/*  struct bStream * bsQpDecode (struct bStream * sInp)
+ *
+ *  Creates a bStream which reads the quoted-printable decoding of the
+ *  content of sInp, as bQpDecode would produce it.  The stream should be
+ *  read to its end before being closed with bsclose, after which sInp may
+ *  be closed.  NULL is returned on error.
+ */
+struct bStream * bsQpDecode (struct bStream * sInp) {
+	return bsQpOpen (sInp, 0);
+}
+
+/*
+ *  MIME multipart bodies (RFC 2046).  The body is read through a buffer
+ *  holding at most one read of the stream beyond what has been delivered,
+ *  plus the bytes which could be the start of a delimiter.  A delimiter is
+ *  CRLF "--" boundary; a CRLF is placed in front of the stream so that a
+ *  boundary at its very start is found the same way.
+ */
+#define BMP_IDENTITY (0)
+#define BMP_BASE64   (1)
+#define BMP_QP       (2)
+
+struct bMpCtx {
+	const struct bMultipartCb * cb;
+	int part, cte;
+	unsigned long acc;       /* Pending base64 bits */
+	int n, pad;              /* The number of pending sextets, and whether
+	                            padding has ended the data */
+	bstring in;              /* Pending quoted-printable input */
+	bstring out;
+};
+
+/* Deliver the body data d of length len of the current part, decoded as
+   necessary. */
+static int bMpData (struct bMpCtx * c, const unsigned char * d, int len) {
+unsigned char * o;
+int i, v;
+
+	if (NULL == c->cb->data || len <= 0) return 0;
+	if (c->cte == BMP_IDENTITY) return c->cb->data (c->cb->parm, c->part, d, len);
+	if (c->cte == BMP_QP) {
+		if (BSTR_OK != bcatblk (c->in, d, len) ||
+		    BSTR_OK != balloc (c->out, c->in->slen + 1)) return BSTR_ERR;
+		c->out->slen = bQpDec (c->out->data, c->in->data, c->in->slen, 0, &i);
+		bdelete (c->in, 0, i);
+		if (c->out->slen <= 0) return 0;
+		return c->cb->data (c->cb->parm, c->part, c->out->data, c->out->slen);
+	}
+
+	if (BSTR_OK != balloc (c->out, len / 4 * 3 + 4)) return BSTR_ERR;
+	o = c->out->data;
+	for (i = 0; i < len && !c->pad; i++) {
+		if (0 > (v = base64DecodeSymbol (d[i]))) {
+			c->pad = (v == B64_PAD);
+			continue;
+		}
+		c->acc = (c->acc << 6) | (unsigned long) v;
+		if (4 == ++c->n) {
+			*o++ = (unsigned char) (c->acc >> 16);
+			*o++ = (unsigned char) (c->acc >> 8);
+			*o++ = (unsigned char) c->acc;
+			c->n = 0;
+			c->acc = 0;
+		}
+	}
+	if (o == c->out->data) return 0;
+	return c->cb->data (c->cb->parm, c->part, c->out->data, (int) (o - c->out->data));
+}
+
+/* Finish the current part, flushing a final partial base64 group. */
+static int bMpEnd (struct bMpCtx * c) {
+unsigned char t[2];
+int used, ret = 0;
+
+	if (c->cte == BMP_QP && c->in->slen > 0 && NULL != c->cb->data) {
+		if (BSTR_OK != balloc (c->out, c->in->slen + 1)) return BSTR_ERR;
+		c->out->slen = bQpDec (c->out->data, c->in->data, c->in->slen, 1, &used);
+		ret = (c->out->slen > 0) ? c->cb->data (c->cb->parm, c->part, c->out->data, c->out->slen) : 0;
+	}
+	if (c->cte == BMP_BASE64 && c->n >= 2 && NULL != c->cb->data) {
+		if (c->n == 2) c->acc <<= 6;
+		t[0] = (unsigned char) (c->acc >> 10);
+		t[1] = (unsigned char) (c->acc >> 2);
+		ret = c->cb->data (c->cb->parm, c->part, t, c->n - 1);
+	}
+	if (ret >= 0 && NULL != c->cb->end) ret = c->cb->end (c->cb->parm, c->part);
+	return ret;
+}
+
+/* Return the position of the delimiter del in the len bytes of d from p, or
+   -1 if it is not entirely present. */
+static int bMpFind (const unsigned char * d, int p, int len, const_bstring del) {
+const unsigned char * q;
+
+	while (len - p >= del->slen) {
+		q = (const unsigned char *) memchr (d + p, '\r', len - p - del->slen + 1);
+		if (NULL == q) break;
+		p = (int) (q - d);
+		if (0 == memcmp (q, del->data, del->slen)) return p;
+		p++;
+	}
+	return -1;
+}
+
+/* Discard the first *p bytes of buf, then append a read from s.  BSTR_ERR
+   is returned at the end of s. */
+static int bMpFill (bstring buf, int * p, struct bStream * s) {
+	if (*p > 0 && BSTR_OK != bdelete (buf, 0, *p)) return BSTR_ERR;
+	*p = 0;
+	return bsreada (buf, s, bsbufflength (s, BSTR_BS_BUFF_LENGTH_GET));
+}
+
+/*  int bsMultipart (struct bStream * s, const_bstring boundary, int decode,
+ *                   const struct bMultipartCb * cb)
+ *
+ *  Parse the MIME multipart body read from s, whose parts are separated by
+ *  the given boundary (see bMultipartBoundary).  For each part, cb->headers
+ *  is called with views of its header fields, then cb->data with
+ *  successive pieces of its body, then cb->end.  Parts are numbered from 0,
+ *  views and data are only valid during the call, and any callback may be
+ *  NULL.  If decode is non-zero, bodies with a Content-Transfer-Encoding of
+ *  base64 or quoted-printable are decoded before being passed to cb->data.  Memory use is
+ *  bounded by the buffer length of s, the boundary length and
+ *  BMULTIPART_MAX_HEAD; the boundary is found even when it is split across
+ *  reads.  Reading stops at the close delimiter, and anything read beyond
+ *  it is returned to s with bsunread.  The number of parts is returned, or
+ *  a negative value returned by a callback, or BSTR_ERR if the body is
+ *  malformed or s ends before the close delimiter.
+ */
+int bsMultipart (struct bStream * s, const_bstring boundary, int decode,
+                 const struct bMultipartCb * cb) {
+static struct tagbstring cteName = bsStatic ("Content-Transfer-Encoding");
+static struct tagbstring b64 = bsStatic ("base64");
+static struct tagbstring qp = bsStatic ("quoted-printable");
+struct bHttpHeader h[BHTTP_MAX_HEADERS];
+struct bMpCtx c;
+struct tagbstring t;
+bstring buf, del;
+int p, j, i, qty, end, scan, ret = BSTR_ERR, inPart = 0;
+
+	if (NULL == s || NULL == cb || NULL == boundary || NULL == boundary->data ||
+	    boundary->slen <= 0 || boundary->slen > 70) return BSTR_ERR;
+	c.cb = cb;
+	c.part = -1;
+	c.cte = BMP_IDENTITY;
+	buf = bfromcstr ("\r\n");
+	del = bfromcstr ("\r\n--");
+	c.in = bfromcstr ("");
+	c.out = bfromcstr ("");
+	if (NULL == buf || NULL == c.in || NULL == c.out ||
+	    BSTR_OK != bconcat (del, boundary)) goto Done;
+
+	for (p = 0;;) {
+		/* Body (or preamble) up to the next delimiter */
+		while (0 > (j = bMpFind (buf->data, p, buf->slen, del))) {
+			i = buf->slen - (del->slen - 1);
+			if (i > p) {
+				if (inPart && 0 > (ret = bMpData (&c, buf->data + p, i - p))) goto Done;
+				p = i;
+			}
+			ret = BSTR_ERR;
+			if (0 > bMpFill (buf, &p, s)) goto Done;
+		}
+		if (inPart && 0 > (ret = bMpData (&c, buf->data + p, j - p))) goto Done;
+		p = j + del->slen;
+
+		/* "--" for the close delimiter, otherwise padding and a line end */
+		for (i = p;; i++) {
+			while (buf->slen - i < 2) {
+				ret = BSTR_ERR;
+				i -= p;
+				if (0 > bMpFill (buf, &p, s)) goto Done;
+				i += p;
+			}
+			if (buf->data[i] != ' ' && buf->data[i] != '\t') break;
+		}
+		if (inPart && 0 > (ret = bMpEnd (&c))) goto Done;
+		if (i == p && buf->data[i] == '-' && buf->data[i + 1] == '-') {
+			blk2tbstr (t, buf->data + p + 2, buf->slen - p - 2);
+			ret = (t.slen > 0 && BSTR_OK != bsunread (s, &t)) ? BSTR_ERR : c.part + 1;
+			goto Done;
+		}
+		if (buf->data[i] == '\r' && buf->data[i + 1] == '\n') i++;
+		if (buf->data[i] != '\n') {
+			ret = BSTR_ERR;
+			goto Done;
+		}
+		p = i + 1;
+
+		/* The header fields of the next part */
+		for (scan = p; 0 == (end = bHttpEnd (buf->data, p, &scan, buf->slen));) {
+			ret = BSTR_ERR;
+			if (buf->slen - p > BMULTIPART_MAX_HEAD) goto Done;
+			scan -= p;
+			if (0 > bMpFill (buf, &p, s)) goto Done;
+			scan += p;
+		}
+		if (0 > (qty = bHttpFields (buf->data, p, end, h, BHTTP_MAX_HEADERS))) {
+			ret = BSTR_ERR;
+			goto Done;
+		}
+		c.part++;
+		c.cte = BMP_IDENTITY;
+		c.acc = 0;
+		c.n = c.pad = 0;
+		c.in->slen = 0;
+		for (i = 0; decode && i < qty; i++) {
+			if (1 != biseqcaseless (&h[i].name, &cteName)) continue;
+			if (1 == biseqcaseless (&h[i].value, &b64)) c.cte = BMP_BASE64;
+			if (1 == biseqcaseless (&h[i].value, &qp)) c.cte = BMP_QP;
+		}
+		if (NULL != cb->headers && 0 > (ret = cb->headers (cb->parm, c.part, h, qty)))
+			goto Done;
+		inPart = 1;
+		p = end;
+	}
+
+	Done:;
+	bdestroy (c.out);
+	bdestroy (c.in);
+	bdestroy (del);
+	bdestroy (buf);
+	return ret;
+}
+
+/*  int bMultipartBoundary (struct tagbstring * t, const_bstring contentType)
+ *
+ *  Set t to a read only view of the boundary parameter of the value of a
+ *  multipart Content-Type header field, which may be quoted.  BSTR_OK is
+ *  returned, or BSTR_ERR if there is no such parameter.
+ */
+int bMultipartBoundary (struct tagbstring * t, const_bstring contentType) {
+static struct tagbstring name = bsStatic ("boundary");
+const unsigned char * d;
+struct tagbstring n;
+int i, j, len;
+
+	if (NULL == t || NULL == contentType || NULL == contentType->data ||
+	    contentType->slen < 0) return BSTR_ERR;
+	d = contentType->data;
+	len = contentType->slen;
+
+	for (i = 0; i < len;) {
+		/* Skip to the next parameter */
+		while (i < len && d[i] != ';') {
+			if (d[i++] == '"') {
+				while (i < len && d[i] != '"') i++;
+				i++;
+			}
+		}
+		for (i++; i < len && (d[i] == ' ' || d[i] == '\t'); i++) ;
+		for (j = i; i < len && bHttpTchar (d[i]); i++) {}
+		blk2tbstr (n, d + j, i - j);
+		if (i >= len || d[i] != '=' || 1 != biseqcaseless (&n, &name)) continue;
+		if (++i < len && d[i] == '"') {
+			for (j = ++i; i < len && d[i] != '"' && d[i] != '\\'; i++) ;
+			if (i >= len || d[i] != '"') return BSTR_ERR;
+		} else {
+			for (j = i; i < len && bHttpTchar (d[i]); i++) {}
+		}
+		if (i == j) return BSTR_ERR;
+		blk2tbstr (*t, d + j, i - j);
+		return BSTR_OK;
+	}
+	return BSTR_ERR;
+}
+
+/*
+ *  JSON strings and structure.  Runs of bytes which need no attention are
+ *  found a machine word at a time, with word wide compares for the quote,
+ *  backslash and control characters; outside of strings, a mask folds the
+ *  four brackets onto one value so that a word of text is tested for all
+ *  of the structural characters at once.  See: RFC8259
+ */
+#define BJS_ONES          BTR_ONES
+#define BJS_HIGH          (BJS_ONES << 7)
+#define BJS_HASBYTE(x,c)  BTR_HASZERO ((x) ^ (BJS_ONES * (c)))
+#define BJS_HASCTRL(x)    (((x) - BJS_ONES * 0x20) & ~(x) & BJS_HIGH)
+
+/* Short escapes of the control characters, or 'u' for \u00XX */
+static const char bJsonCtrl[] = "uuuuuuuubtnufruuuuuuuuuuuuuuuuuu";
+
+/* The number of bytes at d, up to len, which are not '"' or '\\', nor (if
+   ctrl is set) control characters. */
+static int bJsonRun (const unsigned char * d, int len, int ctrl) {
+BTR_WORD w;
+int i;
+
+	for (i = 0; i + BTR_WSZ <= len; i += BTR_WSZ) {
+		memcpy (&w, d + i, BTR_WSZ);
+		if (BJS_HASBYTE (w, '"') | BJS_HASBYTE (w, '\\') |
+		    (ctrl ? BJS_HASCTRL (w) : 0)) break;
+	}
+	for (; i < len; i++) {
+		if (d[i] == '"' || d[i] == '\\' || (ctrl && d[i] < 0x20)) break;
+	}
+	return i;
+}
+
+/* Escape len bytes of d into o, returning the number of bytes written, or
+   just count them if o is NULL.  -1 is returned if the count overflows. */
+static int bJsonEsc (unsigned char * o, const unsigned char * d, int len) {
+int i, k, n;
+unsigned char c;
+
+	for (n = i = 0; i < len;) {
+		k = bJsonRun (d + i, len - i, 1);
+		if (o) memcpy (o + n, d + i, (size_t) k);
+		n += k;
+		i += k;
+		if (i >= len) break;
+		if (n > INT_MAX - 7) return -1;
+		c = d[i++];
+		if (o) o[n] = (unsigned char) '\\';
+		n++;
+		if (c >= 0x20 || bJsonCtrl[c] != 'u') {
+			if (o) o[n] = (unsigned char) (c >= 0x20 ? c : bJsonCtrl[c]);
+			n++;
+		} else {
+			if (o) {
+				o[n    ] = (unsigned char) 'u';
+				o[n + 1] = (unsigned char) '0';
+				o[n + 2] = (unsigned char) '0';
+				o[n + 3] = (unsigned char) bQpHex[c >> 4];
+				o[n + 4] = (unsigned char) bQpHex[c & 15];
+			}
+			n += 5;
+		}
+	}
+	return n;
+}
+
+/*  int bJsonEscape (bstring out, const_bstring b)
+ *
+ *  Append the contents of b to out, escaped so that it may be placed
+ *  between the quotes of a JSON string.  The quote and backslash are
+ *  escaped with a backslash, and the control characters by their short
+ *  escapes or as \u00XX; other bytes, including any UTF-8, are copied as
+ *  they are.  The space required is computed exactly before anything is
+ *  written.
+ */
+int bJsonEscape (bstring out, const_bstring b) {
+int len, n;
+
+	if (out == NULL || out->data == NULL || out->slen < 0 || out->mlen <= 0 ||
+	    out->mlen < out->slen || b == NULL || b->data == NULL || b->slen < 0)
+		return BSTR_ERR;
+	len = b->slen;
+	if (0 > (n = bJsonEsc (NULL, b->data, len)) || n >= INT_MAX - out->slen ||
+	    BSTR_OK != balloc (out, out->slen + n + 1)) return BSTR_ERR;
+	/* If b is out, its content is still the first len bytes */
+	out->slen += bJsonEsc (out->data + out->slen, b->data, len);
+	out->data[out->slen] = (unsigned char) '\0';
+	return BSTR_OK;
+}
+
+/* The value of the 4 hex digits at d, or -1 */
+static long bJsonHex4 (const unsigned char * d, int len) {
+long v;
+int i, h;
+
+	if (len < 4) return -1;
+	for (v = 0, i = 0; i < 4; i++) {
+		if (0 > (h = bQpHexVal (d[i]))) return -1;
+		v = (v << 4) | h;
+	}
+	return v;
+}
+
+/*  int bJsonUnescape (bstring out, const_bstring b)
+ *
+ *  Append the contents of b, the text between the quotes of a JSON string,
+ *  to out with its escapes decoded.  \uXXXX escapes are written as UTF-8,
+ *  with surrogate pairs combined; a surrogate which is not part of a pair
+ *  is written as U+FFFD.  Since the output is no longer than b, the space
+ *  for it is allocated up front.  If b contains an invalid escape, BSTR_ERR
+ *  is returned and out is left unchanged.
+ */
+int bJsonUnescape (bstring out, const_bstring b) {
+const unsigned char * d, * p;
+unsigned char * o;
+int i, k, len;
+long v, v2;
+
+	if (out == NULL || out->data == NULL || out->slen < 0 || out->mlen <= 0 ||
+	    out->mlen < out->slen || b == NULL || b->data == NULL || b->slen < 0 ||
+	    b->slen >= INT_MAX - out->slen) return BSTR_ERR;
+	len = b->slen;
+	if (BSTR_OK != balloc (out, out->slen + len + 1)) return BSTR_ERR;
+	d = b->data;
+	o = out->data + out->slen;
+
+	for (i = 0; i < len;) {
+		if (NULL == (p = (const unsigned char *) memchr (d + i, '\\', (size_t) (len - i)))) p = d + len;
+		k = (int) (p - d) - i;
+		memcpy (o, d + i, (size_t) k);
+		o += k;
+		i += k;
+		if (i >= len) break;
+		if (++i >= len) goto Fail;
+		switch (d[i++]) {
+			case '"':  *o++ = (unsigned char) '"';  break;
+			case '\\': *o++ = (unsigned char) '\\'; break;
+			case '/':  *o++ = (unsigned char) '/';  break;
+			case 'b':  *o++ = (unsigned char) '\b'; break;
+			case 'f':  *o++ = (unsigned char) '\f'; break;
+			case 'n':  *o++ = (unsigned char) '\n'; break;
+			case 'r':  *o++ = (unsigned char) '\r'; break;
+			case 't':  *o++ = (unsigned char) '\t'; break;
+			case 'u':
+				if (0 > (v = bJsonHex4 (d + i, len - i))) goto Fail;
+				i += 4;
+				if (v >= 0xD800 && v < 0xE000) {
+					if (v < 0xDC00 && i + 6 <= len && d[i] == '\\' && d[i + 1] == 'u' &&
+					    (v2 = bJsonHex4 (d + i + 2, len - i - 2)) >= 0xDC00 && v2 < 0xE000) {
+						v = 0x10000 + ((v - 0xD800) << 10) + (v2 - 0xDC00);
+						i += 6;
+					} else {
+						v = 0xFFFD;
+					}
+				}
+				if (v < 0x80) {
+					*o++ = (unsigned char) v;
+				} else if (v < 0x800) {
+					*o++ = (unsigned char) ( (v >>  6)         + 0xc0);
+					*o++ = (unsigned char) ((        v & 0x3f) + 0x80);
+				} else if (v < 0x10000) {
+					*o++ = (unsigned char) ( (v >> 12)         + 0xe0);
+					*o++ = (unsigned char) (((v >>  6) & 0x3f) + 0x80);
+					*o++ = (unsigned char) ((        v & 0x3f) + 0x80);
+				} else {
+					*o++ = (unsigned char) ( (v >> 18)         + 0xf0);
+					*o++ = (unsigned char) (((v >> 12) & 0x3f) + 0x80);
+					*o++ = (unsigned char) (((v >>  6) & 0x3f) + 0x80);
+					*o++ = (unsigned char) ((        v & 0x3f) + 0x80);
+				}
+				break;
+			default:
+				goto Fail;
+		}
+	}
+
+	out->slen = (int) (o - out->data);
+	*o = (unsigned char) '\0';
+	return BSTR_OK;
+
+	Fail:;
+	out->data[out->slen] = (unsigned char) '\0';
+	return BSTR_ERR;
+}
+
+/*  int bJsonIndex (const_bstring b, int * pos, int n, int flags)
+ *
+ *  Find the structural characters of the JSON text b: the quotes which
+ *  open and close strings and, outside of strings, the characters
+ *  { } [ ] : and ,.  If flags includes BJSON_ESCAPES, the backslash which
+ *  starts each escape within a string is reported too, so that strings
+ *  which need bJsonUnescape can be told apart from those which do not.
+ *  The byte following such a backslash is never reported, so an escaped
+ *  quote does not end a string.  The offsets of the first n characters
+ *  found are written to pos and the total number is returned, so a call
+ *  with n = 0 (and pos NULL) gives the size of the array needed.
+ *  BSTR_ERR is returned if the parameters are invalid.
+ */
+int bJsonIndex (const_bstring b, int * pos, int n, int flags) {
+const unsigned char * d;
+BTR_WORD w;
+int i, len, qty;
+unsigned char c;
+
+	if (b == NULL || b->data == NULL || b->slen < 0 || n < 0 ||
+	    (n > 0 && pos == NULL)) return BSTR_ERR;
+	d = b->data;
+	len = b->slen;
+
+	for (qty = 0, i = 0; i < len; i++) {
+		while (i + BTR_WSZ <= len) {
+			memcpy (&w, d + i, BTR_WSZ);
+			/* 0xD9 maps { } [ ] (and a few others) to 0x59 */
+			if (BJS_HASBYTE (w & (BJS_ONES * 0xD9), 0x59) | BJS_HASBYTE (w, '"') |
+			    BJS_HASBYTE (w, ':') | BJS_HASBYTE (w, ',')) break;
+			i += BTR_WSZ;
+		}
+		if (i >= len) break;
+
+		c = d[i];
+		if (c == '"') {
+			if (qty < n) pos[qty] = i;
+			qty++;
+			for (i++; i < len; i++) {
+				i += bJsonRun (d + i, len - i, 0);
+				if (i >= len || d[i] == '"') break;
+				if (flags & BJSON_ESCAPES) {
+					if (qty < n) pos[qty] = i;
+					qty++;
+				}
+				i++; /* The escaped byte */
+			}
+			if (i >= len) break;
+		} else if (c != '{' && c != '}' && c != '[' && c != ']' &&
+		           c != ':' && c != ',') continue;
+		if (qty < n) pos[qty] = i;
+		qty++;
+	}
+	return qty;
+}
+
+/*
+ *  RFC3339 timestamps, YYYY-MM-DDTHH:MM:SS[.fraction](Z|+HH:MM|-HH:MM), for
+ *  years 0000 to 9999 of the proleptic Gregorian calendar.  Neither the C
+ *  library's time functions nor the locale are involved.  The fixed part is
+ *  validated a machine word at a time: XOR with a template leaves every
+ *  separator as 0 and every digit as 0 to 9.
+ */
+#define BRFC_ONES  (~0ULL / 0xFF)
+
+static const unsigned char bRfcTmpl[] = "0000-00-00T00:00:00";
+static const unsigned char bRfcDigit[19] = {
+	15, 15, 15, 15, 0, 15, 15, 0, 15, 15, 0, 15, 15, 0, 15, 15, 0, 15, 15
+};
+
+/* Days since 1970-01-01 of the given date.  See:
+   http://howardhinnant.github.io/date_algorithms.html */
+static long bRfcDays (int y, int m, int d) {
+int era, yoe, doy, doe;
+
+	y -= m <= 2;
+	era = (y >= 0 ? y : y - 399) / 400;
+	yoe = y - era * 400;
+	doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return (long) era * 146097L + doe - 719468L;
+}
+
+/* Write the date of the day z days since 1970-01-01 as YYYY-MM-DD to o. */
+static void bRfcDate (unsigned char * o, long z) {
+long era;
+int doe, yoe, doy, mp, y, m, d;
+
+	z += 719468L;
+	era = (z >= 0 ? z : z - 146096L) / 146097L;
+	doe = (int) (z - era * 146097L);
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp = (5 * doy + 2) / 153;
+	d = doy - (153 * mp + 2) / 5 + 1;
+	m = mp < 10 ? mp + 3 : mp - 9;
+	y = (int) (yoe + era * 400) + (m <= 2);
+	o[0] = (unsigned char) ('0' + y / 1000);
+	o[1] = (unsigned char) ('0' + y / 100 % 10);
+	o[2] = (unsigned char) ('0' + y / 10 % 10);
+	o[3] = (unsigned char) ('0' + y % 10);
+	o[4] = (unsigned char) '-';
+	o[5] = (unsigned char) ('0' + m / 10);
+	o[6] = (unsigned char) ('0' + m % 10);
+	o[7] = (unsigned char) '-';
+	o[8] = (unsigned char) ('0' + d / 10);
+	o[9] = (unsigned char) ('0' + d % 10);
+}
+
+#define BRFC_MIN  (-62167219200LL)  /* 0000-01-01T00:00:00 */
+#define BRFC_MAX  (253402300800LL)  /* 10000-01-01T00:00:00 */
+
+/*  int bRfc3339Cat (bstring b, const struct bTime * t, int digits,
+ *                   struct bTimeCache * cache)
+ *
+ *  Append the time t to b as an RFC3339 timestamp, in the local time of
+ *  its offset, with digits (0 to 9) digits of fractional seconds.  If cache
+ *  is not NULL it holds the text of the last second formatted through it,
+ *  so that consecutive times in the same second (or day) are not
+ *  converted again; it must be zero filled before its first use.  Nothing
+ *  is allocated if b has room for the result.
+ */
+int bRfc3339Cat (bstring b, const struct bTime * t, int digits, struct bTimeCache * cache) {
+struct bTimeCache tmp;
+unsigned char * o;
+long long local;
+long f;
+int s, n, i, off;
+
+	if (b == NULL || b->data == NULL || b->slen < 0 || b->mlen <= 0 ||
+	    b->mlen < b->slen || t == NULL || digits < 0 || digits > 9 ||
+	    t->nsec < 0 || t->nsec > 999999999L || t->offset <= -1440 ||
+	    t->offset >= 1440 || t->sec <= BRFC_MIN - 86400 || t->sec >= BRFC_MAX + 86400)
+		return BSTR_ERR;
+	local = t->sec + 60 * t->offset;
+	if (local < BRFC_MIN || local >= BRFC_MAX) return BSTR_ERR;
+
+	n = 19 + (digits ? digits + 1 : 0) + (t->offset ? 6 : 1);
+	if (b->slen > INT_MAX - n - 1 || BSTR_OK != balloc (b, b->slen + n + 1))
+		return BSTR_ERR;
+
+	if (cache == NULL) {
+		tmp.valid = 0;
+		cache = &tmp;
+	}
+	if (!cache->valid || cache->local != local) {
+		s = (int) ((local - BRFC_MIN) % 86400);
+		if (!cache->valid || (cache->local - BRFC_MIN) / 86400 != (local - BRFC_MIN) / 86400)
+			bRfcDate (cache->text, (long) ((local - BRFC_MIN) / 86400 + BRFC_MIN / 86400));
+		memcpy (cache->text + 10, "T00:00:00", 9);
+		cache->text[11] = (unsigned char) ('0' + s / 36000);
+		cache->text[12] = (unsigned char) ('0' + s / 3600 % 10);
+		cache->text[14] = (unsigned char) ('0' + s / 600 % 6);
+		cache->text[15] = (unsigned char) ('0' + s / 60 % 10);
+		cache->text[17] = (unsigned char) ('0' + s % 60 / 10);
+		cache->text[18] = (unsigned char) ('0' + s % 10);
+		cache->local = local;
+		cache->valid = 1;
+	}
+
+	o = b->data + b->slen;
+	memcpy (o, cache->text, 19);
+	o += 19;
+	if (digits) {
+		*o++ = (unsigned char) '.';
+		for (f = t->nsec, i = 9; i > digits; i--) f /= 10;
+		for (i = digits; i > 0; i--) {
+			o[i - 1] = (unsigned char) ('0' + f % 10);
+			f /= 10;
+		}
+		o += digits;
+	}
+	if (0 == (off = t->offset)) {
+		*o++ = (unsigned char) 'Z';
+	} else {
+		*o++ = (unsigned char) (off < 0 ? '-' : '+');
+		if (off < 0) off = -off;
+		o[0] = (unsigned char) ('0' + off / 600);
+		o[1] = (unsigned char) ('0' + off / 60 % 10);
+		o[2] = (unsigned char) ':';
+		o[3] = (unsigned char) ('0' + off % 60 / 10);
+		o[4] = (unsigned char) ('0' + off % 10);
+		o += 5;
+	}
+	*o = (unsigned char) '\0';
+	b->slen += n;
+	return BSTR_OK;
+}
+
+#define BRFC_2(p) (((p)[0] - '0') * 10 + (p)[1] - '0')
+
+/*  int bRfc3339Parse (struct bTime * t, const_bstring b, int pos)
+ *
+ *  Parse the RFC3339 timestamp at position pos of b into t.  The date and
+ *  time may be separated by 'T', 't' or a space, the zone may be 'Z', 'z'
+ *  or a numeric offset, and digits of fractional seconds past the ninth
+ *  are ignored.  A leap second (:60) is counted as the first second of the
+ *  next minute.  The number of characters parsed is returned, or BSTR_ERR
+ *  if there is not a valid timestamp at pos.
+ */
+int bRfc3339Parse (struct bTime * t, const_bstring b, int pos) {
+static const unsigned char mdays[13] = {0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+unsigned long long w, tm, dm, bad;
+unsigned char f[24];
+const unsigned char * d;
+int i, len, y, mo, dd, h, mi, s, off;
+long ns, k;
+
+	if (t == NULL || b == NULL || b->data == NULL || pos < 0 || b->slen < pos)
+		return BSTR_ERR;
+	d = b->data + pos;
+	len = b->slen - pos;
+	if (len < 20) return BSTR_ERR;
+
+	/* Check the fixed part in three (overlapping) words */
+	memcpy (f, d, 19);
+	if (f[10] == 't' || f[10] == ' ') f[10] = (unsigned char) 'T';
+	for (bad = 0, i = 0; i <= 11; i += (i ? 3 : 8)) {
+		memcpy (&w, f + i, 8);
+		memcpy (&tm, bRfcTmpl + i, 8);
+		memcpy (&dm, bRfcDigit + i, 8);
+		w ^= tm;
+		bad |= (w & ~dm) | ((w + BRFC_ONES * 0x76) & (BRFC_ONES * 0x80));
+	}
+	if (bad) return BSTR_ERR;
+
+	y  = BRFC_2 (d) * 100 + BRFC_2 (d + 2);
+	mo = BRFC_2 (d + 5);
+	dd = BRFC_2 (d + 8);
+	h  = BRFC_2 (d + 11);
+	mi = BRFC_2 (d + 14);
+	s  = BRFC_2 (d + 17);
+	if (mo < 1 || mo > 12 || dd < 1 || dd > mdays[mo] || h > 23 || mi > 59 ||
+	    s > 60) return BSTR_ERR;
+	if (mo == 2 && dd == 29 && (y % 4 != 0 || (y % 100 == 0 && y % 400 != 0)))
+		return BSTR_ERR;
+
+	i = 19;
+	ns = 0;
+	if (d[i] == '.') {
+		for (k = 100000000L, i++; i < len && d[i] >= '0' && d[i] <= '9'; i++) {
+			ns += k * (d[i] - '0');
+			k /= 10;
+		}
+		if (i == 20) return BSTR_ERR;
+	}
+
+	if (i >= len) return BSTR_ERR;
+	if (d[i] == 'Z' || d[i] == 'z') {
+		off = 0;
+		i++;
+	} else {
+		if ((d[i] != '+' && d[i] != '-') || i + 6 > len || d[i + 3] != ':') return BSTR_ERR;
+		for (k = 1; k < 6; k++) {
+			if (k != 3 && (d[i + k] < '0' || d[i + k] > '9')) return BSTR_ERR;
+		}
+		if (BRFC_2 (d + i + 1) > 23 || BRFC_2 (d + i + 4) > 59) return BSTR_ERR;
+		off = BRFC_2 (d + i + 1) * 60 + BRFC_2 (d + i + 4);
+		if (d[i] == '-') off = -off;
+		i += 6;
+	}
+
+	t->sec = (long long) bRfcDays (y, mo, dd) * 86400 + h * 3600L + mi * 60L + s - 60LL * off;
+	t->nsec = ns;
+	t->offset = off;
+	return i;
+}
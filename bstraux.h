@@ -76,7 +76,13 @@ extern bstring bUuDecodeEx (const_bstring src, int * badlines);
 extern bstring bUuEncode (const_bstring src);
 extern bstring bYEncode (const_bstring src);
 extern bstring bYDecode (const_bstring src);
+extern bstring bYEncodeLines (const_bstring src, int lineLen);
+extern int bYDecodeInPlace (bstring b);
 extern int bSGMLEncode (bstring b);
+extern bstring bQpEncode (const_bstring b);
+extern bstring bQpDecode (const_bstring b);
+extern struct bStream * bsQpEncode (struct bStream * sInp);
+extern struct bStream * bsQpDecode (struct bStream * sInp);
 
 /* Writable stream */
 typedef int (* bNwrite) (const void * buf, size_t elsize, size_t nelem, void * parm);
@@ -89,6 +95,133 @@ int bwsIsEOF (const struct bwriteStream * stream);
 int bwsBuffLength (struct bwriteStream * stream, int sz);
 void * bwsClose (struct bwriteStream * stream);
 
+/* Serialized bstrList */
+extern int bwsWriteBstrList (struct bwriteStream * ws, const struct bstrList * sl);
+extern struct bstrList * bstrListRefSerial (const void * blk, int len);
+
+/* Bulk bstrList transformations */
+extern int bstrListToLower (struct bstrList * sl);
+extern int bstrListToUpper (struct bstrList * sl);
+extern int bstrListTrimws (struct bstrList * sl);
+extern int bstrListFindReplace (struct bstrList * sl, const_bstring find, const_bstring repl);
+
+/* Columnar string container */
+struct bstrColumn {
+	int qty, mlen;
+	int * offsets;
+	bstring blob;
+};
+extern struct bstrColumn * bstrColumnCreate (void);
+extern int bstrColumnDestroy (struct bstrColumn * c);
+extern int bstrColumnAlloc (struct bstrColumn * c, int qty, int blen);
+extern int bstrColumnAppend (struct bstrColumn * c, const_bstring b);
+extern int bstrColumnAppendBlk (struct bstrColumn * c, const void * blk, int len);
+extern int bstrColumnEntry (struct tagbstring * t, const struct bstrColumn * c, int i);
+extern struct bstrColumn * bstrColumnFromList (const struct bstrList * sl);
+extern struct bstrList * bstrColumnToList (const struct bstrColumn * c);
+extern int bstrColumnSelectInstr (const struct bstrColumn * c, const_bstring find, int * sel);
+extern int bstrColumnSelectEqCaseless (const struct bstrColumn * c, const_bstring b, int * sel);
+
+/* Approximate matching */
+extern int bLevenshtein (const_bstring a, const_bstring b);
+extern int bLevenshteinMax (const_bstring a, const_bstring b, int k);
+extern int binstrfuzzy (const_bstring b1, int pos, const_bstring b2, int k);
+
+/* Differences */
+#define BDIFF_BYTES (0)
+#define BDIFF_LINES (1)
+struct bDiffEdit {
+	int apos, alen;          /* This range of the old sequence is replaced */
+	int bpos, blen;          /* by this range of the new one */
+};
+struct bDiff {
+	int unit;                /* BDIFF_BYTES or BDIFF_LINES */
+	int qty, mlen;
+	struct bDiffEdit * edit;
+	struct bstrList * data;  /* The inserted content */
+};
+extern struct bDiff * bDiffBytes (const_bstring a, const_bstring b);
+extern struct bDiff * bDiffLines (const struct bstrList * a, const struct bstrList * b);
+extern int bDiffApply (bstring b, const struct bDiff * d);
+extern int bDiffApplyList (struct bstrList * sl, const struct bDiff * d);
+extern int bDiffDestroy (struct bDiff * d);
+
+/* Content defined chunking and hashing */
+typedef int (* bNchunk) (void * parm, const unsigned char * data, int len, const unsigned char * digest);
+extern int bSha256 (const void * blk, int len, unsigned char * digest);
+extern int bsChunk (struct bStream * s, int minSize, int avgSize, int maxSize, bNchunk cb, void * parm);
+extern int bRollingHash (const_bstring b, int w, unsigned long * h, int qty);
+
+/* Checksums */
+extern unsigned long bcrc32cblk (unsigned long crc, const void * blk, int len);
+extern unsigned long bcrc32c (const_bstring b);
+extern unsigned long long bHash64 (const_bstring b, unsigned long long seed);
+extern struct bStream * bsCrc32c (struct bStream * sInp, unsigned long * crc);
+extern int bwsCrc32c (struct bwriteStream * ws, unsigned long * crc);
+
+/* Byte translation tables */
+#define BTR_DELETE  (1)
+#define BTR_SQUEEZE (2)
+#define BTR_SCAN    (4)
+struct bTrTable {
+	unsigned char map[256];    /* Each byte c is output as map[c] */
+	unsigned char flags[256];  /* BTR_DELETE of input bytes, BTR_SQUEEZE of output bytes */
+	unsigned char active[256]; /* Bytes which are not copied unchanged */
+	unsigned char act[BTR_SCAN];
+	int nact;
+};
+extern int bTrCompile (struct bTrTable * t, const_bstring from, const_bstring to, const_bstring del, const_bstring squeeze);
+extern int bTranslate (bstring b, const struct bTrTable * t);
+extern struct bStream * bsTranslate (struct bStream * sInp, const struct bTrTable * t);
+
+/* HTTP/1.x request heads */
+#define BHTTP_MAX_HEADERS (64)
+struct bHttpHeader {
+	struct tagbstring name, value;
+};
+struct bHttpRequest {
+	struct tagbstring method, path;
+	int minor;               /* The x of HTTP/1.x */
+	int qty;                 /* The number of header fields */
+	struct bHttpHeader header[BHTTP_MAX_HEADERS];
+	int scanned;             /* Bytes of the buffer already searched */
+};
+extern int bHttpInit (struct bHttpRequest * r);
+extern int bHttpParse (struct bHttpRequest * r, const_bstring buf);
+extern int bHttpFind (const struct bHttpRequest * r, const_bstring name, int pos);
+extern int bsHttpRead (struct bHttpRequest * r, bstring buf, struct bStream * s, int maxLen);
+
+/* MIME multipart bodies */
+#define BMULTIPART_MAX_HEAD (16384)
+struct bMultipartCb {
+	int (* headers) (void * parm, int part, const struct bHttpHeader * h, int qty);
+	int (* data) (void * parm, int part, const unsigned char * blk, int len);
+	int (* end) (void * parm, int part);
+	void * parm;
+};
+extern int bsMultipart (struct bStream * s, const_bstring boundary, int decode, const struct bMultipartCb * cb);
+extern int bMultipartBoundary (struct tagbstring * t, const_bstring contentType);
+
+/* JSON strings */
+extern int bJsonEscape (bstring out, const_bstring b);
+extern int bJsonUnescape (bstring out, const_bstring b);
+#define BJSON_ESCAPES (1)
+extern int bJsonIndex (const_bstring b, int * pos, int n, int flags);
+
+/* RFC3339 timestamps */
+struct bTime {
+	long long sec;           /* Seconds since 1970-01-01T00:00:00Z */
+	long nsec;               /* Nanoseconds past sec */
+	int offset;              /* Offset of the local time from UTC, in minutes */
+};
+struct bTimeCache {
+	long long local;         /* The local second which text holds */
+	int valid;
+	unsigned char text[19];  /* YYYY-MM-DDTHH:MM:SS */
+};
+extern int bRfc3339Cat (bstring b, const struct bTime * t, int digits, struct bTimeCache * cache);
+extern int bRfc3339Parse (struct bTime * t, const_bstring b, int pos);
+
 /* Security functions */
 #define bSecureDestroy(b) {                                             \
 bstring bstr__tmp = (b);                                                \
@@ -15,6 +15,10 @@
 # define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#if defined (BSTRLIB_THREADS) && !defined (_POSIX_C_SOURCE)
+# define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <stdio.h>
 #include <stddef.h>
 #include <stdarg.h>
@@ -24,6 +28,11 @@
 #include <limits.h>
 #include "bstrlib.h"
 
+#if defined (BSTRLIB_THREADS)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 /* Optionally include a mechanism for debugging memory */
 
 #if defined(MEMORY_DEBUG) || defined(BSTRLIB_MEMORY_DEBUG)
@@ -1657,6 +1666,224 @@ typedef int (*instr_fnptr) (const_bstring s1, int pos, const_bstring s2);
 
 #define INITIAL_STATIC_FIND_INDEX_COUNT 32
 
+/*
+ *  For long strings, when bexecute () can run jobs concurrently, the find
+ *  and replace is split into chunks of candidate match positions which are
+ *  searched independently.  A match found near the end of one chunk may
+ *  overlap the start of the next, so the chunk lists are then stitched
+ *  together serially: matches of a chunk that start inside the previous
+ *  chunk's last match are dropped, and the chunk is rescanned from that
+ *  point until it meets a match already in its list (from there on the
+ *  greedy left to right search necessarily agrees with it).  The output
+ *  length of every chunk then gives its output offset, the result is
+ *  allocated once, and the chunks are copied into it concurrently.  The
+ *  output is identical to that of the serial algorithm.
+ */
+
+#define BSTR_PARFR_MIN_LEN (256 * 1024)
+#define BSTR_PARFR_MAX_CHUNKS (64)
+
+struct bparfrChunk {
+	int lo, hi;        /* Candidate match positions lo .. hi-1 */
+	int qty, mlen;     /* Match positions found */
+	int * d;
+	int src, dst;      /* Start of the chunk's span in the input and output */
+	int ret;
+};
+
+struct bparfrJob {
+	const_bstring b, find, repl;
+	instr_fnptr instr;
+	unsigned char * out;
+	int chunks;
+	struct bparfrChunk c[BSTR_PARFR_MAX_CHUNKS];
+};
+
+static int bparfrPush (struct bparfrChunk * c, int pos) {
+	if (c->qty >= c->mlen) {
+		int * t;
+		int ml = c->mlen ? c->mlen : INITIAL_STATIC_FIND_INDEX_COUNT;
+		if (c->mlen) {
+			if ((size_t) ml > (INT_MAX / sizeof (int)) / 2) return BSTR_ERR;
+			ml += ml;
+		}
+		t = (int *) bstr__realloc (c->d, sizeof (int) * ml);
+		if (NULL == t) return BSTR_ERR;
+		c->d = t;
+		c->mlen = ml;
+	}
+	c->d[c->qty] = pos;
+	c->qty++;
+	return BSTR_OK;
+}
+
+/* Search view of the input that only admits matches starting before hi */
+static void bparfrView (struct tagbstring * v, const struct bparfrJob * j,
+                        int hi) {
+	v->mlen = -1;
+	v->data = j->b->data;
+	if (j->b->slen - hi < j->find->slen - 1) v->slen = j->b->slen;
+	else v->slen = hi - 1 + j->find->slen;
+}
+
+static void bparfrSearch (void * parm, int idx) {
+struct bparfrJob * j = (struct bparfrJob *) parm;
+struct bparfrChunk * c = &j->c[idx];
+struct tagbstring v;
+int pos = c->lo;
+
+	bparfrView (&v, j, c->hi);
+	while ((pos = j->instr (&v, pos, j->find)) >= 0) {
+		if (BSTR_OK != bparfrPush (c, pos)) {
+			c->ret = BSTR_ERR;
+			return;
+		}
+		pos += j->find->slen;
+	}
+}
+
+/* Rebase the match list of a chunk so that the search starts from pos */
+static int bparfrResync (struct bparfrJob * j, struct bparfrChunk * c,
+                         int pos) {
+struct bparfrChunk nc;
+struct tagbstring v;
+int i, q;
+
+	for (i = 0; i < c->qty && c->d[i] < pos; i++) {}
+	nc.qty = nc.mlen = 0;
+	nc.d = NULL;
+	bparfrView (&v, j, c->hi);
+	for (;;) {
+		if ((q = j->instr (&v, pos, j->find)) < 0) {
+			i = c->qty;
+			break;
+		}
+		if (i < c->qty && q == c->d[i]) break;
+		if (BSTR_OK != bparfrPush (&nc, q)) {
+			bstr__free (nc.d);
+			return BSTR_ERR;
+		}
+		pos = q + j->find->slen;
+		while (i < c->qty && c->d[i] < pos) i++;
+	}
+
+	if (nc.qty == 0) {
+		if (i) bstr__memmove (c->d, c->d + i, sizeof (int) * (c->qty - i));
+		c->qty -= i;
+		return BSTR_OK;
+	}
+	for (; i < c->qty; i++) {
+		if (BSTR_OK != bparfrPush (&nc, c->d[i])) {
+			bstr__free (nc.d);
+			return BSTR_ERR;
+		}
+	}
+	bstr__free (c->d);
+	c->d = nc.d;
+	c->qty = nc.qty;
+	c->mlen = nc.mlen;
+	return BSTR_OK;
+}
+
+static void bparfrCopy (void * parm, int idx) {
+struct bparfrJob * j = (struct bparfrJob *) parm;
+struct bparfrChunk * c = &j->c[idx];
+unsigned char * o = j->out + c->dst;
+int i, s, e;
+
+	s = c->src;
+	e = (idx + 1 < j->chunks) ? j->c[idx + 1].src : j->b->slen;
+	for (i = 0; i < c->qty; i++) {
+		if (j->out != j->b->data) {
+			bstr__memcpy (o, j->b->data + s, c->d[i] - s);
+			o += c->d[i] - s;
+		} else {
+			o = j->out + c->d[i];
+		}
+		if (j->repl->slen) bstr__memcpy (o, j->repl->data, j->repl->slen);
+		o += j->repl->slen;
+		s = c->d[i] + j->find->slen;
+	}
+	if (j->out != j->b->data && e > s) bstr__memcpy (o, j->b->data + s, e - s);
+}
+
+static int parfindreplace (bstring b, const_bstring find,
+                           const_bstring repl, int pos,
+                           instr_fnptr instr) {
+struct bparfrJob j;
+struct bparfrChunk * c;
+int i, k, n, q, r, len, cur, tot, delta, nl = 0, ret = BSTR_ERR;
+
+	len = b->slen - pos;
+	n = bexecconcurrency () * 4;
+	if (n > len / (BSTR_PARFR_MIN_LEN / 4)) n = len / (BSTR_PARFR_MIN_LEN / 4);
+	if (n > BSTR_PARFR_MAX_CHUNKS) n = BSTR_PARFR_MAX_CHUNKS;
+	q = len / n;
+	r = len % n;
+
+	j.b = b;
+	j.find = find;
+	j.repl = repl;
+	j.instr = instr;
+	j.chunks = n;
+	for (k = 0; k < n; k++) {
+		c = &j.c[k];
+		c->lo = pos + k * q + (k < r ? k : r);
+		c->hi = pos + (k + 1) * q + (k + 1 < r ? k + 1 : r);
+		c->qty = c->mlen = 0;
+		c->d = NULL;
+		c->ret = BSTR_OK;
+	}
+
+	if (BSTR_OK != bexecute (bparfrSearch, &j, n)) goto done;
+
+	/* Stitch the chunks together and compute their output offsets */
+	delta = find->slen - repl->slen;
+	cur = pos;
+	tot = 0;
+	for (k = 0; k < n; k++) {
+		c = &j.c[k];
+		if (BSTR_OK != c->ret) goto done;
+		if (cur > c->lo && BSTR_OK != bparfrResync (&j, c, cur)) goto done;
+		c->src = (k == 0) ? 0 : (cur > c->lo ? cur : c->lo);
+		if (c->qty > 0) cur = c->d[c->qty - 1] + find->slen;
+	}
+	for (k = 0; k < n; k++) {
+		c = &j.c[k];
+		i = ((k + 1 < n) ? j.c[k + 1].src : b->slen) - c->src;
+		if (delta < 0 && c->qty > (INT_MAX - 1 - i) / -delta) goto done;
+		i -= c->qty * delta;
+		if (i > INT_MAX - 1 - tot) goto done;
+		c->dst = tot;
+		tot += i;
+	}
+
+	if (delta == 0) {
+		j.out = b->data;
+	} else {
+		nl = snapUpSize (tot + 1);
+		if (NULL == (j.out = (unsigned char *) bstr__alloc (nl))) goto done;
+	}
+
+	if (BSTR_OK != bexecute (bparfrCopy, &j, n)) {
+		if (j.out != b->data) bstr__free (j.out);
+		goto done;
+	}
+
+	if (j.out != b->data) {
+		bstr__free (b->data);
+		b->data = j.out;
+		b->mlen = nl;
+		b->slen = tot;
+		b->data[tot] = (unsigned char) '\0';
+	}
+	ret = BSTR_OK;
+
+	done:;
+	for (k = 0; k < n; k++) bstr__free (j.c[k].d);
+	return ret;
+}
+
 static int findreplaceengine (bstring b, const_bstring find,
                               const_bstring repl, int pos,
                               instr_fnptr instr) {
@@ -1688,6 +1915,13 @@ bstring auxr = (bstring) repl;
 		}
 	}
 
+	if (b->slen - pos >= BSTR_PARFR_MIN_LEN && bexecconcurrency () > 1) {
+		ret = parfindreplace (b, auxf, auxr, pos, instr);
+		if (auxf != find) bdestroy (auxf);
+		if (auxr != repl) bdestroy (auxr);
+		return ret;
+	}
+
 	delta = auxf->slen - auxr->slen;
 
 	/* in-place replacement since find and replace strings are of equal
@@ -2780,6 +3014,60 @@ int i, p, ret;
 	return BSTR_OK;
 }
 
+/*  int bfields (struct tagbstring * t, const_bstring str, unsigned char delim,
+ *               const int * k, int n)
+ *
+ *  Set t[0] to t[n-1] to read only views of the fields k[0] to k[n-1] of
+ *  str, where the fields are the substrings that bsplit would divide str
+ *  into on the character delim, numbered from 0.  The field numbers must be
+ *  strictly increasing.  Nothing is allocated and str is scanned only up to
+ *  the end of the last requested field.  The number of the requested fields
+ *  which exist in str is returned, and the views of the remaining ones are
+ *  empty.  BSTR_ERR is returned on a parameter error.
+ */
+int bfields (struct tagbstring * t, const_bstring str, unsigned char delim,
+	const int * k, int n) {
+unsigned char * p, * q, * e;
+int i, f, found;
+
+	if (t == NULL || k == NULL || n < 0 || str == NULL || str->data == NULL
+	 || str->slen < 0) return BSTR_ERR;
+	for (i=0; i < n; i++) {
+		if (k[i] < 0 || (i > 0 && k[i] <= k[i-1])) return BSTR_ERR;
+	}
+
+	p = str->data;
+	e = p + str->slen;
+	for (f=i=0; i < n; i++) {
+		for (; f < k[i]; f++) {
+			q = (unsigned char *) bstr__memchr (p, delim, e - p);
+			if (q == NULL) goto Missing;
+			p = q + 1;
+		}
+		q = (unsigned char *) bstr__memchr (p, delim, e - p);
+		if (q == NULL) q = e;
+		blk2tbstr (t[i], p, (int) (q - p));
+	}
+	return n;
+
+	Missing:;
+	for (found = i; i < n; i++) blk2tbstr (t[i], e, 0);
+	return found;
+}
+
+/*  int bfield (struct tagbstring * t, const_bstring str, unsigned char delim,
+ *              int k)
+ *
+ *  Set t to a read only view of field k of str, as bfields does, and return
+ *  its position in str.  If str has no field k, t is set to be empty and
+ *  BSTR_ERR is returned.
+ */
+int bfield (struct tagbstring * t, const_bstring str, unsigned char delim,
+	int k) {
+	if (1 != bfields (t, str, delim, &k, 1)) return BSTR_ERR;
+	return (int) (t->data - str->data);
+}
+
 struct genBstrList {
 	bstring b;
 	struct bstrList * bl;
@@ -3135,3 +3423,274 @@ int n, r, l;
 }
 
 #endif
+
+/*
+ *  Parallel execution.  Operations which can be split into independent
+ *  pieces of work (jobs) hand them to bexecute, which runs them on the
+ *  executor installed with bsetexecutor.  With no executor installed the
+ *  jobs are run by the built-in thread pool if the library was compiled
+ *  with BSTRLIB_THREADS, or otherwise one after another by the caller.
+ */
+
+static bNexec bexec__fn = NULL;
+static void * bexec__ctx = NULL;
+static int bexec__concurrency = 0;
+
+/* Set while the current thread is running a job, so that a bexecute made
+   from within a job (bstrListFindReplace calling bfindreplace, say) runs
+   its jobs serially rather than reentering the executor.  Without thread
+   local storage, nested calls are not detected. */
+#if defined (_MSC_VER)
+#define BEXEC_TLS __declspec (thread)
+#elif defined (__GNUC__) || defined (__clang__)
+#define BEXEC_TLS __thread
+#elif defined (__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define BEXEC_TLS _Thread_local
+#endif
+
+#if defined (BEXEC_TLS)
+static BEXEC_TLS int bexec__inJob = 0;
+#define bexecInJob() (bexec__inJob)
+#else
+#define bexecInJob() (0)
+#endif
+
+struct bexecBatch {
+	bNjob job;
+	void * parm;
+};
+
+static void bexecRun (void * parm, int idx) {
+struct bexecBatch * b = (struct bexecBatch *) parm;
+#if defined (BEXEC_TLS)
+int in = bexec__inJob;
+	bexec__inJob = 1;
+	b->job (b->parm, idx);
+	bexec__inJob = in;
+#else
+	b->job (b->parm, idx);
+#endif
+}
+
+#if defined (BSTRLIB_THREADS)
+
+/*
+ *  The built-in pool.  Its threads are started on first use and the caller
+ *  of bexecute always works on its own batch alongside them.  Each
+ *  participant claims the next unclaimed job index for itself whenever it
+ *  finishes a job, so idle threads keep taking work away from busy ones
+ *  until the batch is exhausted.  Only one batch runs at a time; a bexecute
+ *  that finds the pool busy (including one made from within a job) simply
+ *  runs its jobs itself.
+ */
+
+static pthread_mutex_t bpool__batchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t bpool__lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bpool__work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t bpool__idle = PTHREAD_COND_INITIALIZER;
+static pthread_t * bpool__thr = NULL;
+static int bpool__qtyThr = 0, bpool__wantThr = 0, bpool__stop = 0;
+static bNjob bpool__job = NULL;
+static void * bpool__parm = NULL;
+static int bpool__qty = 0, bpool__next = 0, bpool__active = 0;
+
+/* Run jobs from the current batch until none are left unclaimed.  Must be
+   called with bpool__lock held, and returns with it held. */
+static void bpoolDrain (void) {
+	while (bpool__job && bpool__next < bpool__qty) {
+		bNjob job = bpool__job;
+		void * parm = bpool__parm;
+		int idx = bpool__next++;
+		bpool__active++;
+		pthread_mutex_unlock (&bpool__lock);
+		job (parm, idx);
+		pthread_mutex_lock (&bpool__lock);
+		bpool__active--;
+	}
+	if (0 == bpool__active) pthread_cond_broadcast (&bpool__idle);
+}
+
+static void * bpoolWorker (void * arg) {
+	(void) arg;
+	pthread_mutex_lock (&bpool__lock);
+	for (;;) {
+		while (!bpool__stop && (NULL == bpool__job || bpool__next >= bpool__qty))
+			pthread_cond_wait (&bpool__work, &bpool__lock);
+		if (bpool__stop) break;
+		bpoolDrain ();
+	}
+	pthread_mutex_unlock (&bpool__lock);
+	return NULL;
+}
+
+static int bpoolDefaultThreads (void) {
+#if defined (_SC_NPROCESSORS_ONLN)
+	long n = sysconf (_SC_NPROCESSORS_ONLN);
+	if (n > 1) return (n > 256) ? 256 : (int) n;
+#endif
+	return 1;
+}
+
+/* Start the helper threads.  Called with bpool__lock held. */
+static void bpoolStart (void) {
+int i, n;
+	if (0 == bpool__wantThr) bpool__wantThr = bpoolDefaultThreads ();
+	n = bpool__wantThr - 1;
+	if (n <= 0 || bpool__thr) return;
+	bpool__thr = (pthread_t *) bstr__alloc (sizeof (pthread_t) * n);
+	if (NULL == bpool__thr) return;
+	for (i = 0; i < n; i++) {
+		if (0 != pthread_create (&bpool__thr[i], NULL, bpoolWorker, NULL)) break;
+	}
+	bpool__qtyThr = i;
+}
+
+static int bpoolExecute (bNjob job, void * parm, int qty) {
+	if (0 != pthread_mutex_trylock (&bpool__batchLock)) return BSTR_ERR;
+	pthread_mutex_lock (&bpool__lock);
+	if (NULL == bpool__thr) bpoolStart ();
+	if (0 == bpool__qtyThr) {
+		pthread_mutex_unlock (&bpool__lock);
+		pthread_mutex_unlock (&bpool__batchLock);
+		return BSTR_ERR;
+	}
+	bpool__job = job;
+	bpool__parm = parm;
+	bpool__qty = qty;
+	bpool__next = 0;
+	pthread_cond_broadcast (&bpool__work);
+	bpoolDrain ();
+	while (bpool__active > 0) pthread_cond_wait (&bpool__idle, &bpool__lock);
+	bpool__job = NULL;
+	bpool__parm = NULL;
+	pthread_mutex_unlock (&bpool__lock);
+	pthread_mutex_unlock (&bpool__batchLock);
+	return BSTR_OK;
+}
+
+#endif
+
+/*  int bsetexecutor (bNexec exec, void * ctx, int concurrency)
+ *
+ *  Install exec as the executor for the parallel operations of the
+ *  library, or remove the current executor if exec is NULL.  concurrency is
+ *  the number of jobs exec is able to run at once, and is used to decide
+ *  how finely work is divided.  exec may fail (return a negative value)
+ *  only before it has called any job, since bexecute then runs all of the
+ *  jobs serially.  This must not be called while any bstrlib
+ *  function might be running on another thread.
+ */
+int bsetexecutor (bNexec exec, void * ctx, int concurrency) {
+	if (concurrency < 0 || (NULL != exec && 0 == concurrency)) return BSTR_ERR;
+	bexec__fn = exec;
+	bexec__ctx = exec ? ctx : NULL;
+	bexec__concurrency = exec ? concurrency : 0;
+	return BSTR_OK;
+}
+
+/*  int bsetthreads (int n)
+ *
+ *  Set the number of threads (including the calling thread) used by the
+ *  built-in pool.  n == 0 selects the number of online processors.  If the
+ *  pool is running, it is shut down, and will be restarted with the new
+ *  size when it is next needed.  If the library was not compiled with
+ *  BSTRLIB_THREADS, only n <= 1 is accepted.
+ */
+int bsetthreads (int n) {
+	if (n < 0) return BSTR_ERR;
+#if defined (BSTRLIB_THREADS)
+	if (BSTR_OK != bexecshutdown ()) return BSTR_ERR;
+	pthread_mutex_lock (&bpool__lock);
+	bpool__wantThr = n;
+	pthread_mutex_unlock (&bpool__lock);
+	return BSTR_OK;
+#else
+	return (n <= 1) ? BSTR_OK : BSTR_ERR;
+#endif
+}
+
+/*  int bexecshutdown (void)
+ *
+ *  Stop and join the threads of the built-in pool, if it is running.  The
+ *  pool is restarted automatically when it is next needed, so this may be
+ *  called at any time no parallel operation is running, such as before a
+ *  fork() or at program exit.  If a parallel operation is running in
+ *  another thread, nothing is done and BSTR_ERR is returned.
+ */
+int bexecshutdown (void) {
+#if defined (BSTRLIB_THREADS)
+int i, n;
+pthread_t * thr;
+
+	if (0 != pthread_mutex_trylock (&bpool__batchLock)) return BSTR_ERR;
+	pthread_mutex_lock (&bpool__lock);
+	thr = bpool__thr;
+	n = bpool__qtyThr;
+	bpool__stop = 1;
+	pthread_cond_broadcast (&bpool__work);
+	pthread_mutex_unlock (&bpool__lock);
+
+	for (i = 0; i < n; i++) pthread_join (thr[i], NULL);
+
+	pthread_mutex_lock (&bpool__lock);
+	bpool__thr = NULL;
+	bpool__qtyThr = 0;
+	bpool__stop = 0;
+	pthread_mutex_unlock (&bpool__lock);
+	pthread_mutex_unlock (&bpool__batchLock);
+	bstr__free (thr);
+#endif
+	return BSTR_OK;
+}
+
+/*  int bexecconcurrency (void)
+ *
+ *  Return the number of jobs that bexecute can run at once.  A result of 1
+ *  means that jobs are run sequentially, so splitting work up any further
+ *  than is necessary for other reasons will not make it faster.
+ */
+int bexecconcurrency (void) {
+	if (bexec__fn) return bexec__concurrency;
+#if defined (BSTRLIB_THREADS)
+	{
+		int n;
+		pthread_mutex_lock (&bpool__lock);
+		if (0 == bpool__wantThr) bpool__wantThr = bpoolDefaultThreads ();
+		n = bpool__wantThr;
+		pthread_mutex_unlock (&bpool__lock);
+		return n;
+	}
+#else
+	return 1;
+#endif
+}
+
+/*  int bexecute (bNjob job, void * parm, int qty)
+ *
+ *  Call job (parm, idx) once for every idx from 0 to qty-1, and return once
+ *  all of them have completed.  The calls may be made concurrently and in
+ *  any order, so each job must only modify state that no other job of the
+ *  batch touches.  A bexecute made from within a job runs its jobs serially
+ *  in the calling thread, so the executor is never reentered.
+ */
+int bexecute (bNjob job, void * parm, int qty) {
+int i;
+
+	if (NULL == job || qty < 0) return BSTR_ERR;
+	if (qty == 0) return BSTR_OK;
+	if (qty > 1 && !bexecInJob ()) {
+		struct bexecBatch b;
+		b.job = job;
+		b.parm = parm;
+		if (bexec__fn) {
+			if (0 <= bexec__fn (bexec__ctx, bexecRun, &b, qty)) return BSTR_OK;
+		}
+#if defined (BSTRLIB_THREADS)
+		else if (BSTR_OK == bpoolExecute (bexecRun, &b, qty)) return BSTR_OK;
+#endif
+	}
+
+	/* Run the jobs here, in order */
+	for (i = 0; i < qty; i++) job (parm, i);
+	return BSTR_OK;
+}
@@ -128,6 +128,10 @@ extern int bsplitscb (const_bstring str, const_bstring splitStr, int pos,
 	int (* cb) (void * parm, int ofs, int len), void * parm);
 extern int bsplitstrcb (const_bstring str, const_bstring splitStr, int pos,
 	int (* cb) (void * parm, int ofs, int len), void * parm);
+extern int bfield (struct tagbstring * t, const_bstring str, unsigned char delim,
+	int k);
+extern int bfields (struct tagbstring * t, const_bstring str, unsigned char delim,
+	const int * k, int n);
 
 /* Miscellaneous functions */
 extern int bpattern (bstring b, int len);
@@ -194,6 +198,18 @@ extern int bssplitstrcb (struct bStream * s, const_bstring splitStr,
 	int (* cb) (void * parm, int ofs, const_bstring entry), void * parm);
 extern int bseof (const struct bStream * s);
 
+/* Parallel execution functions */
+typedef void (* bNjob) (void * parm, int idx);
+/* An executor may fail (return < 0) only before calling any job, as the
+   batch is then run serially; nested bexecute calls never reenter it. */
+typedef int (* bNexec) (void * ctx, bNjob job, void * parm, int qty);
+
+extern int bsetexecutor (bNexec exec, void * ctx, int concurrency);
+extern int bsetthreads (int n);
+extern int bexecshutdown (void);
+extern int bexecconcurrency (void);
+extern int bexecute (bNjob job, void * parm, int qty);
+
 struct tagbstring {
 	int mlen;
 	int slen;
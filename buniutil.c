@@ -13,9 +13,16 @@
  * this module is dependent upon bstrlib.c and utf8util.c
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include "bstrlib.h"
 #include "buniutil.h"
 
+#define BUNITAB_FOLD
+#define BUNITAB_WIDTH
+#define BUNITAB_GRAPHEME
+#include "bunitab.h"
+
 #define UNICODE__CODE_POINT__REPLACEMENT_CHARACTER (0xFFFDL)
 
 /*  int buIsUTF8Content (const_bstring bu)
@@ -272,3 +279,1365 @@ int cc, i, sm, oldSlen;
 
 	return BSTR_OK;
 }
+
+/*
+ *  Helpers for scanning UTF-8 a machine word at a time.  Runs of ASCII are
+ *  by far the most common content, and for those the case folding and
+ *  comparisons can be done on whole words without decoding anything.
+ */
+
+#define BU_WORD unsigned long
+#define BU_WSZ  ((int) sizeof (BU_WORD))
+#define BU_ONES ((BU_WORD) -1 / 0xFF)
+#define BU_HIGH (BU_ONES * 0x80)
+#define BU_HASZERO(w) (((w) - BU_ONES) & ~(w) & BU_HIGH)
+
+static BU_WORD buLoadWord (const unsigned char * p) {
+BU_WORD w;
+	memcpy (&w, p, sizeof (BU_WORD));
+	return w;
+}
+
+/* Lower case the letters of a word made of ASCII bytes. */
+static BU_WORD buLowerWord (BU_WORD w) {
+BU_WORD ge = w + BU_ONES * (0x80 - 'A');
+BU_WORD gt = w + BU_ONES * (0x80 - 'Z' - 1);
+	return w | (((ge & ~gt) & BU_HIGH) >> 2);
+}
+
+/*  cpUcs4 buFoldCodePoint (cpUcs4 c)
+ *
+ *  Return the simple case folding of the code point c, as defined by the
+ *  C and S entries of the Unicode CaseFolding.txt file.  Values which are
+ *  not valid code points are returned unchanged.
+ */
+cpUcs4 buFoldCodePoint (cpUcs4 c) {
+	if (c < 0 || c >= BUFOLD_LIMIT) return c;
+	return c + buFoldDelta[buFoldBlock[(buFoldIndex[c >> BUFOLD_SHIFT]
+	                                    << BUFOLD_SHIFT) +
+	                                   (c & ((1 << BUFOLD_SHIFT) - 1))]];
+}
+
+/*  int buFoldCase (bstring b)
+ *
+ *  Replace the UTF-8 content of b by its simple case folding.  Bytes which
+ *  are not part of valid UTF-8 sequences are left as they are.  Since a code
+ *  point and its folding may have encodings of different lengths, the
+ *  length of b may change.
+ */
+int buFoldCase (bstring b) {
+unsigned char c[4];
+int i, j, k, l, d, dmax, n;
+cpUcs4 v, f;
+
+	if (b == NULL || b->data == NULL || b->mlen < b->slen ||
+	    b->slen < 0 || b->mlen <= 0) return BSTR_ERR;
+
+	/* Fold in place for as long as the encoded lengths do not change */
+	for (i = 0; i < b->slen; i += k) {
+		if (i + BU_WSZ <= b->slen) {
+			BU_WORD w = buLoadWord (b->data + i);
+			if (0 == (w & BU_HIGH)) {
+				w = buLowerWord (w);
+				memcpy (b->data + i, &w, sizeof (BU_WORD));
+				k = BU_WSZ;
+				continue;
+			}
+		}
+		v = utf8DecodeCodePoint (b->data + i, b->slen - i, &k);
+		if (v == (f = buFoldCodePoint (v))) continue;
+		if (k != utf8EncodeCodePoint (f, c)) break;
+		memcpy (b->data + i, c, k);
+	}
+	if (i >= b->slen) return BSTR_OK;
+
+	/* Measure the rest, and the most the output ever runs ahead of the
+	   input, so that the tail can be moved out of the way once and then
+	   folded in a single forward pass. */
+	for (j = i, d = dmax = 0; j < b->slen; j += k) {
+		v = utf8DecodeCodePoint (b->data + j, b->slen - j, &k);
+		d += utf8EncodeCodePoint (buFoldCodePoint (v), c) - k;
+		if (d > dmax) dmax = d;
+	}
+	if (dmax > INT_MAX - 1 - b->slen) return BSTR_ERR;
+	if (BSTR_OK != balloc (b, b->slen + dmax + 1)) return BSTR_ERR;
+	n = b->slen + dmax;
+	if (dmax) memmove (b->data + i + dmax, b->data + i, b->slen - i);
+
+	for (j = i + dmax; j < n; j += k) {
+		v = utf8DecodeCodePoint (b->data + j, n - j, &k);
+		l = utf8EncodeCodePoint (buFoldCodePoint (v), c);
+		memcpy (b->data + i, c, l);
+		i += l;
+	}
+	b->slen = i;
+	b->data[i] = (unsigned char) '\0';
+	return BSTR_OK;
+}
+
+/*
+ *  Compare the case folded code points of s0 and s1 for as long as they
+ *  agree.  On return *i0 and *i1 are advanced past the part that matched,
+ *  and the difference of the first folded code points that do not match
+ *  (or 0 if either string ran out) is returned.
+ */
+static cpUcs4 buFoldCmp (const unsigned char * s0, int l0, int * i0,
+                         const unsigned char * s1, int l1, int * i1) {
+int i = *i0, j = *i1, k0, k1;
+cpUcs4 c0, c1;
+
+	while (i < l0 && j < l1) {
+		if (i + BU_WSZ <= l0 && j + BU_WSZ <= l1) {
+			BU_WORD w0 = buLoadWord (s0 + i);
+			BU_WORD w1 = buLoadWord (s1 + j);
+			if (0 == ((w0 | w1) & BU_HIGH) &&
+			    buLowerWord (w0) == buLowerWord (w1)) {
+				i += BU_WSZ;
+				j += BU_WSZ;
+				continue;
+			}
+		}
+		c0 = utf8DecodeCodePoint (s0 + i, l0 - i, &k0);
+		c1 = utf8DecodeCodePoint (s1 + j, l1 - j, &k1);
+		if (c0 != c1) {
+			c0 = buFoldCodePoint (c0);
+			c1 = buFoldCodePoint (c1);
+			if (c0 != c1) {
+				*i0 = i;
+				*i1 = j;
+				return c0 - c1;
+			}
+		}
+		i += k0;
+		j += k1;
+	}
+	*i0 = i;
+	*i1 = j;
+	return 0;
+}
+
+/*  int buStricmp (const_bstring b0, const_bstring b1)
+ *
+ *  Compare two UTF-8 strings without differentiating between case, using
+ *  Unicode simple case folding.  The return value is -1 or 1 according to
+ *  the order of the folded code points where the two strings first differ
+ *  (so that it is never mistaken for SHRT_MIN), or if one string is a
+ *  caseless prefix of the other, 1 if b0 is the longer one and -1 if b1 is.
+ *  0 is returned if the strings are caselessly equal.  Bytes which are not
+ *  part of valid UTF-8 sequences are compared by value, and order after all
+ *  code points.  If either parameter is NULL or invalid, SHRT_MIN is
+ *  returned.
+ */
+int buStricmp (const_bstring b0, const_bstring b1) {
+int i = 0, j = 0;
+cpUcs4 d;
+
+	if (bdata (b0) == NULL || b0->slen < 0 ||
+	    bdata (b1) == NULL || b1->slen < 0) return SHRT_MIN;
+	if (b0->slen == b1->slen && b0->data == b1->data) return BSTR_OK;
+	d = buFoldCmp (b0->data, b0->slen, &i, b1->data, b1->slen, &j);
+	if (d) return (d < 0) ? -1 : 1;
+	if (i < b0->slen) return 1;
+	if (j < b1->slen) return -1;
+	return BSTR_OK;
+}
+
+/*  int buInstrCaseless (const_bstring b1, int pos, const_bstring b2)
+ *
+ *  Search for the UTF-8 string b2 in b1 starting from byte position pos,
+ *  without differentiating between case using Unicode simple case folding.
+ *  The byte position of the first match is returned, or BSTR_ERR if there
+ *  is none or a parameter is invalid.  Note that the matched part of b1
+ *  need not have the same length in bytes as b2.
+ */
+int buInstrCaseless (const_bstring b1, int pos, const_bstring b2) {
+BU_WORD lo, up;
+cpUcs4 f, fu;
+int i, j, k, l;
+
+	if (bdata (b1) == NULL || b1->slen < 0 ||
+	    bdata (b2) == NULL || b2->slen < 0) return BSTR_ERR;
+	if (pos < 0 || pos > b1->slen) return BSTR_ERR;
+	if (b2->slen == 0) return pos;
+
+	/* Candidate starts are found a word at a time.  If the folded first
+	   code point of b2 is ASCII the candidates are that byte in either case
+	   and non-ASCII bytes (a few other code points, such as KELVIN SIGN,
+	   fold to ASCII); otherwise they are only the non-ASCII bytes. */
+	f = buFoldCodePoint (utf8DecodeCodePoint (b2->data, b2->slen, &k));
+	fu = (f >= 'a' && f <= 'z') ? f - 0x20 : f;
+	if (f < 0x80) {
+		lo = BU_ONES * (BU_WORD) f;
+		up = BU_ONES * (BU_WORD) fu;
+	} else {
+		lo = up = BU_ONES * 0x80;
+	}
+
+	for (i = pos; i < b1->slen; i++) {
+		while (i + BU_WSZ <= b1->slen) {
+			BU_WORD w = buLoadWord (b1->data + i);
+			if ((w & BU_HIGH) || BU_HASZERO (w ^ lo) || BU_HASZERO (w ^ up))
+				break;
+			i += BU_WSZ;
+		}
+		if (i >= b1->slen) break;
+		if (b1->data[i] < 0x80 && b1->data[i] != f && b1->data[i] != fu)
+			continue;
+		j = i;
+		l = 0;
+		if (0 == buFoldCmp (b1->data, b1->slen, &j, b2->data, b2->slen, &l)
+		 && l >= b2->slen) return i;
+	}
+	return BSTR_ERR;
+}
+
+/*  int buIsNormalized (const_bstring b, int form)
+ *
+ *  Determine whether the UTF-8 content of b is in the Unicode normalization
+ *  form given by form (UTF8_NFC or UTF8_NFD).  Returns 1 if it is, 0 if it
+ *  is not, and BSTR_ERR if a parameter is invalid.  No memory is allocated.
+ */
+int buIsNormalized (const_bstring b, int form) {
+int ret;
+	if (NULL == bdata (b) || b->slen < 0) return BSTR_ERR;
+	ret = utf8IsNormalized (b->data, b->slen, form);
+	return (ret < 0) ? BSTR_ERR : ret;
+}
+
+static int buNormalizeOut (void * ctx, const unsigned char * data, int len) {
+	return bcatblk ((bstring) ctx, data, len);
+}
+
+/*  int buNormalize (bstring b, int form)
+ *
+ *  Convert the UTF-8 content of b to the Unicode normalization form given
+ *  by form (UTF8_NFC or UTF8_NFD).  Bytes which are not valid UTF-8 are
+ *  left as they are.  If b is already normalized it is not modified and no
+ *  memory is allocated.  Returns BSTR_OK or BSTR_ERR.
+ */
+int buNormalize (bstring b, int form) {
+struct utf8Normalizer n;
+unsigned char * d;
+bstring t;
+int ret;
+
+	if (b == NULL || b->data == NULL || b->mlen < b->slen ||
+	    b->slen < 0 || b->mlen <= 0) return BSTR_ERR;
+	if (0 > (ret = utf8IsNormalized (b->data, b->slen, form))) return BSTR_ERR;
+	if (ret) return BSTR_OK;
+
+	if (NULL == (t = bfromcstralloc (b->slen + (b->slen >> 3) + 8, ""))) return BSTR_ERR;
+	utf8NormalizerInit (&n, form, buNormalizeOut, t);
+	if (0 > utf8NormalizerFeed (&n, b->data, b->slen) ||
+	    0 > utf8NormalizerFinish (&n)) {
+		bdestroy (t);
+		return BSTR_ERR;
+	}
+
+	d = b->data;
+	b->data = t->data;
+	b->slen = t->slen;
+	b->mlen = t->mlen;
+	t->data = d;
+	bdestroy (t);
+	return BSTR_OK;
+}
+
+struct buNormCtx {
+	struct utf8Normalizer n;
+	struct bStream * sInp;
+	bstring src, dst;
+};
+
+static size_t buNormalizePart (void * buff, size_t elsize, size_t nelem, void * parm) {
+struct buNormCtx * ctx = (struct buNormCtx *) parm;
+size_t tsz;
+
+	if (NULL == buff || NULL == parm || 0 == elsize) return 0;
+	tsz = elsize * nelem;
+
+	while ((size_t) ctx->dst->slen < tsz && NULL != ctx->sInp) {
+		if (BSTR_ERR == bsread (ctx->src, ctx->sInp,
+		                        bsbufflength (ctx->sInp, BSTR_BS_BUFF_LENGTH_GET))) {
+			utf8NormalizerFinish (&ctx->n);
+			ctx->sInp = NULL;
+		} else if (0 > utf8NormalizerFeed (&ctx->n, ctx->src->data, ctx->src->slen)) {
+			ctx->sInp = NULL;
+		}
+	}
+
+	tsz = ((size_t) ctx->dst->slen < tsz) ? ctx->dst->slen / elsize : nelem;
+	if (tsz > 0) {
+		memcpy (buff, ctx->dst->data, tsz * elsize);
+		bdelete (ctx->dst, 0, (int) (tsz * elsize));
+		return tsz;
+	}
+
+	/* Deallocate once EOF becomes triggered */
+	bdestroy (ctx->src);
+	bdestroy (ctx->dst);
+	free (ctx);
+	return 0;
+}
+
+/*  struct bStream * buNormalizeStream (struct bStream * sInp, int form)
+ *
+ *  Creates a bStream which reads the UTF-8 content of sInp converted to the
+ *  Unicode normalization form given by form (UTF8_NFC or UTF8_NFD).  Only a
+ *  buffer's worth of the input is held in memory at any one time.  The
+ *  stream should be read to its end before being closed with bsclose, after
+ *  which sInp may be closed.  NULL is returned on error.
+ */
+struct bStream * buNormalizeStream (struct bStream * sInp, int form) {
+struct buNormCtx * ctx;
+struct bStream * sOut;
+
+	if (NULL == sInp) return NULL;
+	if (NULL == (ctx = (struct buNormCtx *) malloc (sizeof (struct buNormCtx))))
+		return NULL;
+	ctx->sInp = sInp;
+	ctx->src = bfromcstr ("");
+	ctx->dst = bfromcstr ("");
+	if (NULL == ctx->src || NULL == ctx->dst ||
+	    0 > utf8NormalizerInit (&ctx->n, form, buNormalizeOut, ctx->dst) ||
+	    NULL == (sOut = bsopen ((bNread) buNormalizePart, ctx))) {
+		bdestroy (ctx->src);
+		bdestroy (ctx->dst);
+		free (ctx);
+		return NULL;
+	}
+	return sOut;
+}
+
+/*
+ *  Code point addressing.  A code point is taken to start at every byte
+ *  which is not a UTF-8 continuation byte (10xxxxxx), except that stray
+ *  continuation bytes at the start of a string belong to its first code
+ *  point.  Lead bytes are counted a machine word at a time.
+ */
+
+#define BU_CPINDEX_DEFAULT_K (256)
+#define BU_CPINDEX_MIN_QTY   (16)
+
+/* Number of lead (non continuation) bytes in a word */
+static int buLeadCount (BU_WORD w) {
+BU_WORD c = w & ~(w << 1) & BU_HIGH;
+	return BU_WSZ - (int) ((((c >> 7) * BU_ONES) >> ((BU_WSZ - 1) * 8)) & 0xFF);
+}
+
+/*
+ *  Return the byte offset of the n'th code point after the one starting at
+ *  byte offset pos, slen if that is the end of the string, or BSTR_ERR if
+ *  the string has fewer code points.
+ */
+static int buSkipCp (const unsigned char * d, int slen, int pos, int n) {
+int p, c;
+
+	if (n == 0) return pos;
+	if (pos >= slen) return BSTR_ERR;
+	for (p = pos + 1; p + BU_WSZ <= slen; p += BU_WSZ) {
+		if ((c = buLeadCount (buLoadWord (d + p))) >= n) break;
+		n -= c;
+	}
+	for (; p < slen; p++) {
+		if ((d[p] & 0xC0) != 0x80 && --n == 0) return p;
+	}
+	return (n == 1) ? slen : BSTR_ERR;
+}
+
+/* Number of code points from byte offset pos to the end of the string */
+static int buCountCp (const unsigned char * d, int slen, int pos) {
+int p, n;
+
+	if (pos >= slen) return 0;
+	for (n = 1, p = pos + 1; p + BU_WSZ <= slen; p += BU_WSZ) {
+		n += buLeadCount (buLoadWord (d + p));
+	}
+	for (; p < slen; p++) n += (d[p] & 0xC0) != 0x80;
+	return n;
+}
+
+/*  struct buCpIndex * buCpIndexCreate (int k)
+ *
+ *  Create an index which maps code point positions to byte offsets by
+ *  recording the offset of every k'th code point (k <= 0 selects a default
+ *  of 256).  The index is built lazily, only as far as the positions looked
+ *  up through it.
+ */
+struct buCpIndex * buCpIndexCreate (int k) {
+struct buCpIndex * ix;
+
+	if (NULL == (ix = (struct buCpIndex *) malloc (sizeof (struct buCpIndex))))
+		return NULL;
+	ix->k = (k > 0) ? k : BU_CPINDEX_DEFAULT_K;
+	ix->qty = ix->mlen = 0;
+	ix->offsets = NULL;
+	ix->cpLen = -1;
+	ix->data = NULL;
+	ix->slen = -1;
+	return ix;
+}
+
+/*  int buCpIndexDestroy (struct buCpIndex * ix)
+ *
+ *  Destroy a code point index.
+ */
+int buCpIndexDestroy (struct buCpIndex * ix) {
+	if (NULL == ix) return BSTR_ERR;
+	free (ix->offsets);
+	free (ix);
+	return BSTR_OK;
+}
+
+/*  int buCpIndexInvalidate (struct buCpIndex * ix, int pos)
+ *
+ *  Discard the part of the index describing the bytes from byte offset pos
+ *  onward, which must be done when the indexed bstring is modified in a way
+ *  that leaves its data pointer and length unchanged.  (Other modifications
+ *  are detected and cause the index to be discarded automatically.)  Only
+ *  the part of the index after an edit needs to be rebuilt.
+ */
+int buCpIndexInvalidate (struct buCpIndex * ix, int pos) {
+	if (NULL == ix) return BSTR_ERR;
+	while (ix->qty > 0 && ix->offsets[ix->qty - 1] >= pos) ix->qty--;
+	ix->cpLen = -1;
+	return BSTR_OK;
+}
+
+/*
+ *  Make sure the index describes b and extend it until it has an entry at
+ *  or beyond code point position cp, or it covers the whole string.
+ *  Returns the number of usable entries, or BSTR_ERR.
+ */
+static int buCpIndexExtend (struct buCpIndex * ix, const_bstring b, int cp) {
+int o, e;
+
+	if (ix->data != b->data || ix->slen != b->slen) {
+		ix->data = b->data;
+		ix->slen = b->slen;
+		ix->qty = 0;
+		ix->cpLen = -1;
+	}
+	if (ix->qty == 0) {
+		if (ix->mlen == 0) {
+			int * t = (int *) malloc (sizeof (int) * BU_CPINDEX_MIN_QTY);
+			if (NULL == t) return BSTR_ERR;
+			ix->offsets = t;
+			ix->mlen = BU_CPINDEX_MIN_QTY;
+		}
+		ix->offsets[0] = 0;
+		ix->qty = 1;
+	}
+
+	e = cp / ix->k;
+	while (ix->qty <= e && ix->cpLen < 0) {
+		o = buSkipCp (b->data, b->slen, ix->offsets[ix->qty - 1], ix->k);
+		if (o < 0 || o >= b->slen) {
+			ix->cpLen = (ix->qty - 1) * ix->k +
+			            buCountCp (b->data, b->slen, ix->offsets[ix->qty - 1]);
+			break;
+		}
+		if (ix->qty >= ix->mlen) {
+			int * t;
+			if (ix->mlen > INT_MAX / 2 / (int) sizeof (int)) return BSTR_ERR;
+			t = (int *) realloc (ix->offsets, sizeof (int) * ix->mlen * 2);
+			if (NULL == t) return BSTR_ERR;
+			ix->offsets = t;
+			ix->mlen *= 2;
+		}
+		ix->offsets[ix->qty++] = o;
+	}
+	return ix->qty;
+}
+
+/*  int buCpOffset (const_bstring b, struct buCpIndex * ix, int cp)
+ *
+ *  Return the byte offset of the code point at position cp in the UTF-8
+ *  string b, or b->slen if cp is the number of code points in b.  BSTR_ERR
+ *  is returned if cp is out of range or a parameter is invalid.  If ix is
+ *  not NULL it is used (and extended) to skip most of the counting.
+ */
+int buCpOffset (const_bstring b, struct buCpIndex * ix, int cp) {
+int i;
+
+	if (NULL == bdata (b) || b->slen < 0 || cp < 0) return BSTR_ERR;
+	if (NULL == ix) return buSkipCp (b->data, b->slen, 0, cp);
+	if (0 > buCpIndexExtend (ix, b, cp)) return BSTR_ERR;
+	if ((i = cp / ix->k) >= ix->qty) i = ix->qty - 1;
+	return buSkipCp (b->data, b->slen, ix->offsets[i], cp - i * ix->k);
+}
+
+/*  int buCpPosition (const_bstring b, struct buCpIndex * ix, int pos)
+ *
+ *  Return the position of the code point which contains the byte at offset
+ *  pos of the UTF-8 string b (or the number of code points if pos is
+ *  b->slen).  BSTR_ERR is returned if pos is out of range or a parameter is
+ *  invalid.  If ix is not NULL it is used (and extended) to skip most of the
+ *  counting.
+ */
+int buCpPosition (const_bstring b, struct buCpIndex * ix, int pos) {
+int lo, hi, m;
+
+	if (NULL == bdata (b) || b->slen < 0 || pos < 0 || pos > b->slen) return BSTR_ERR;
+	lo = 0;
+	if (NULL != ix) {
+		/* Extend the index until it passes pos, then binary search it */
+		if (0 > buCpIndexExtend (ix, b, 0)) return BSTR_ERR;
+		while (ix->cpLen < 0 && ix->offsets[ix->qty - 1] <= pos) {
+			if (0 > buCpIndexExtend (ix, b, ix->qty * ix->k)) return BSTR_ERR;
+		}
+		hi = ix->qty;
+		while (hi - lo > 1) {
+			m = (lo + hi) >> 1;
+			if (ix->offsets[m] <= pos) lo = m;
+			else hi = m;
+		}
+		m = ix->offsets[lo];
+		lo *= ix->k;
+	} else {
+		m = 0;
+	}
+	if (pos == b->slen) return lo + buCountCp (b->data, b->slen, m);
+	if (pos == m) return lo;
+	return lo + buCountCp (b->data, pos + 1, m) - 1;
+}
+
+/*  int buCpLength (const_bstring b, struct buCpIndex * ix)
+ *
+ *  Return the number of code points in the UTF-8 string b, or BSTR_ERR if b
+ *  is invalid.  If ix is not NULL it is used and completed.
+ */
+int buCpLength (const_bstring b, struct buCpIndex * ix) {
+	if (NULL == bdata (b) || b->slen < 0) return BSTR_ERR;
+	if (NULL == ix) return buCountCp (b->data, b->slen, 0);
+	if (0 > buCpIndexExtend (ix, b, INT_MAX)) return BSTR_ERR;
+	return ix->cpLen;
+}
+
+/*  bstring buMidstr (const_bstring b, struct buCpIndex * ix, int left,
+ *                    int len)
+ *
+ *  Create a bstring which is the substring of the UTF-8 string b made of
+ *  the len code points starting at code point position left.  As with
+ *  bmidstr, the range is clamped to the ends of b.  If ix is not NULL it is
+ *  used to locate the substring.  NULL is returned if b is invalid.
+ */
+bstring buMidstr (const_bstring b, struct buCpIndex * ix, int left, int len) {
+int s, e;
+
+	if (NULL == bdata (b) || b->slen < 0) return NULL;
+	if (left < 0) {
+		len += left;
+		left = 0;
+	}
+	if (len <= 0 || 0 > (s = buCpOffset (b, ix, left))) return bfromcstr ("");
+	if (len > INT_MAX - left || 0 > (e = buCpOffset (b, ix, left + len))) {
+		e = b->slen;
+	}
+	return blk2bstr (b->data + s, e - s);
+}
+
+/*  int buInstr (const_bstring b1, struct buCpIndex * ix, int pos,
+ *               const_bstring b2)
+ *
+ *  Search for the bstring b2 in the UTF-8 string b1 starting from code point
+ *  position pos, and return the code point position of the first match, or
+ *  BSTR_ERR if there is none or a parameter is invalid.  If ix is not NULL
+ *  it is used to translate between code point positions and byte offsets.
+ */
+int buInstr (const_bstring b1, struct buCpIndex * ix, int pos, const_bstring b2) {
+int i;
+
+	if (0 > (i = buCpOffset (b1, ix, pos))) return BSTR_ERR;
+	if (0 > (i = binstr (b1, i, b2))) return BSTR_ERR;
+	return buCpPosition (b1, ix, i);
+}
+
+/*  int buCodePointWidth (cpUcs4 c)
+ *
+ *  Return the number of terminal columns the code point c occupies by
+ *  itself: 0 for combining marks, format and control characters and Hangul
+ *  medial and final jamo, 2 for East Asian Wide and Fullwidth characters
+ *  (which include the emoji with default emoji presentation), and 1 for
+ *  everything else, including values which are not code points.
+ */
+int buCodePointWidth (cpUcs4 c) {
+	if (c < 0) return 1;
+	if (c < BUWIDTH_LIMIT) {
+		return buWidthBlock[(buWidthIndex[c >> BUWIDTH_SHIFT] << BUWIDTH_SHIFT) +
+		                    (c & ((1 << BUWIDTH_SHIFT) - 1))];
+	}
+	if (c <= 0x3FFFD) return ((c & 0xFFFE) == 0xFFFE) ? 1 : 2;
+	if (c == 0xE0001 || (c >= 0xE0020 && c <= 0xE007F) ||
+	    (c >= 0xE0100 && c <= 0xE01EF)) return 0;
+	return 1;
+}
+
+#define BU_ZWJ  (0x200DL)
+#define BU_VS16 (0xFE0FL)
+#define buIsEmojiModifier(c) ((c) >= 0x1F3FBL && (c) <= 0x1F3FFL)
+
+/*
+ *  The display width of a block of UTF-8.  Besides the widths of the
+ *  individual code points, a few emoji sequences are accounted for: VS16
+ *  turns a narrow character into a wide emoji, and skin tone modifiers and
+ *  wide characters joined to a wide character by ZWJ are drawn as part of
+ *  it.  Invalid bytes are one column wide each.
+ */
+static int buWidthBlk (const unsigned char * d, int len) {
+int i, k, w, cw, last, zwj;
+cpUcs4 c;
+
+	for (w = last = zwj = i = 0; i < len; i += k) {
+		if (i + BU_WSZ <= len) {
+			BU_WORD x = buLoadWord (d + i);
+			if (0 == ((x | ((x - BU_ONES * 0x20) & ~x) |
+			              BU_HASZERO (x ^ (BU_ONES * 0x7F))) & BU_HIGH)) {
+				w += BU_WSZ;
+				last = 1;
+				zwj = 0;
+				k = BU_WSZ;
+				continue;
+			}
+		}
+		if (d[i] < 0x80) {
+			k = 1;
+			if (d[i] >= 0x20 && d[i] != 0x7F) {
+				w++;
+				last = 1;
+				zwj = 0;
+			}
+			continue;
+		}
+		c = utf8DecodeCodePoint (d + i, len - i, &k);
+		cw = buCodePointWidth (c);
+		if (c == BU_ZWJ) {
+			zwj = 1;
+			continue;
+		}
+		if (last == 2 && (zwj || buIsEmojiModifier (c)) && cw == 2) {
+			cw = 0;
+		} else if (last == 1 && c == BU_VS16) {
+			cw = 1;
+			last = 2;
+		}
+		zwj = 0;
+		if (cw > 0) last = cw;
+		if (w > INT_MAX - cw) return BSTR_ERR;
+		w += cw;
+	}
+	return w;
+}
+
+/*  int buDisplayWidth (const_bstring b)
+ *
+ *  Return the number of terminal columns the UTF-8 content of b occupies,
+ *  or BSTR_ERR if b is invalid.  Runs of printable ASCII are measured a
+ *  machine word at a time.
+ */
+int buDisplayWidth (const_bstring b) {
+	if (NULL == bdata (b) || b->slen < 0) return BSTR_ERR;
+	return buWidthBlk (b->data, b->slen);
+}
+
+/* Remove leading and trailing space and collapse runs of space as
+   bJustifyLeft does. */
+static int buCollapse (bstring b, int space) {
+int j, i, s, t;
+unsigned char c = (unsigned char) space;
+
+	if (b == NULL || b->data == NULL || b->slen < 0 || b->mlen <= 0 ||
+	    b->mlen < b->slen || space < 0 || space >= 0x80) return BSTR_ERR;
+
+	for (s=j=i=0; i < b->slen; i++) {
+		t = s;
+		s = c != (b->data[j] = b->data[i]);
+		j += (t|s);
+	}
+	if (j > 0 && b->data[j-1] == c) j--;
+
+	b->data[j] = (unsigned char) '\0';
+	b->slen = j;
+	return BSTR_OK;
+}
+
+/*  int buJustifyRight (bstring b, int width, int space)
+ *
+ *  Right justify the UTF-8 content of b to within a given display width,
+ *  after collapsing runs of the (ASCII) character space as bJustifyLeft
+ *  does.
+ */
+int buJustifyRight (bstring b, int width, int space) {
+int w;
+	if (width <= 0 || BSTR_OK != buCollapse (b, space)) return BSTR_ERR;
+	if (0 > (w = buWidthBlk (b->data, b->slen))) return BSTR_ERR;
+	if (w < width) return binsertch (b, 0, width - w, (unsigned char) space);
+	return BSTR_OK;
+}
+
+/*  int buJustifyCenter (bstring b, int width, int space)
+ *
+ *  Center the UTF-8 content of b within a given display width by inserting
+ *  the (ASCII) character space at the beginning, after collapsing runs of
+ *  space as bJustifyLeft does.
+ */
+int buJustifyCenter (bstring b, int width, int space) {
+int w;
+	if (width <= 0 || BSTR_OK != buCollapse (b, space)) return BSTR_ERR;
+	if (0 > (w = buWidthBlk (b->data, b->slen))) return BSTR_ERR;
+	if (w < width) return binsertch (b, 0, (width - w + 1) >> 1, (unsigned char) space);
+	return BSTR_OK;
+}
+
+/*  int buJustifyMargin (bstring b, int width, int space)
+ *
+ *  Stretch the UTF-8 content of b to flush against left and right margins
+ *  of the given display width by evenly distributing additional copies of
+ *  the (ASCII) character space between words.  If the line is too wide to
+ *  be margin justified, it is left justified.
+ */
+int buJustifyMargin (bstring b, int width, int space) {
+struct bstrList * sl;
+int i, l, c, w;
+
+	if (BSTR_OK != buCollapse (b, space)) return BSTR_ERR;
+	if (NULL == (sl = bsplit (b, (unsigned char) space))) return BSTR_ERR;
+	for (l=c=i=0; i < sl->qty; i++) {
+		if (sl->entry[i]->slen > 0) {
+			c ++;
+			l += buWidthBlk (sl->entry[i]->data, sl->entry[i]->slen);
+		}
+	}
+
+	if (l + c >= width || c < 2) {
+		bstrListDestroy (sl);
+		return BSTR_OK;
+	}
+
+	b->slen = 0;
+	for (w=i=0; i < sl->qty; i++) {
+		if (sl->entry[i]->slen > 0) {
+			if (b->slen > 0) {
+				int s = (width - l + (c / 2)) / c;
+				if (BSTR_OK != binsertch (b, b->slen, s, (unsigned char) space)) w = 1;
+				l += s;
+			}
+			if (BSTR_OK != bconcat (b, sl->entry[i])) w = 1;
+			c--;
+			if (c <= 0) break;
+		}
+	}
+
+	bstrListDestroy (sl);
+	return w ? BSTR_ERR : BSTR_OK;
+}
+
+/* Length of the longest valid UTF-8 prefix of d, skipping through runs of
+   ASCII a word at a time. */
+static int buValidPrefix (const unsigned char * d, int len) {
+int i, k;
+
+	for (i = 0; i < len; i += k) {
+		if (i + BU_WSZ <= len && 0 == (buLoadWord (d + i) & BU_HIGH)) {
+			k = BU_WSZ;
+		} else if (d[i] < 0x80) {
+			k = 1;
+		} else if (utf8DecodeCodePoint (d + i, len - i, &k) >= UTF8_INVALID_BYTE_BASE) {
+			break;
+		}
+	}
+	return i;
+}
+
+/*  int buSanitize (bstring b, cpUcs4 errCh, int * nrepl)
+ *
+ *  Make the content of b valid UTF-8 by replacing every byte which does not
+ *  start a valid sequence with the encoding of errCh (or U+FFFD, if errCh
+ *  is not a legal code point).  Valid runs are copied as they are, and if
+ *  the encoding of errCh is a single byte the repair is made in place.  If
+ *  nrepl is not NULL, the number of replacements is written to it.
+ */
+int buSanitize (bstring b, cpUcs4 errCh, int * nrepl) {
+unsigned char e[4];
+unsigned char * d;
+bstring t;
+int i, k, el, n;
+
+	if (NULL != nrepl) *nrepl = 0;
+	if (b == NULL || b->data == NULL || b->mlen < b->slen ||
+	    b->slen < 0 || b->mlen <= 0) return BSTR_ERR;
+	if (!isLegalUnicodeCodePoint (errCh)) errCh = UNICODE__CODE_POINT__REPLACEMENT_CHARACTER;
+	el = utf8EncodeCodePoint (errCh, e);
+
+	i = buValidPrefix (b->data, b->slen);
+	if (i >= b->slen) return BSTR_OK;
+
+	n = 0;
+	if (el == 1) {
+		while (i < b->slen) {
+			b->data[i++] = e[0];
+			n++;
+			i += buValidPrefix (b->data + i, b->slen - i);
+		}
+	} else {
+		if (NULL == (t = bfromcstralloc (b->slen + 2 * el + 8, ""))) return BSTR_ERR;
+		if (BSTR_OK != bcatblk (t, b->data, i)) goto Fail;
+		while (i < b->slen) {
+			i++;
+			n++;
+			k = buValidPrefix (b->data + i, b->slen - i);
+			if (BSTR_OK != bcatblk (t, e, el) ||
+			    BSTR_OK != bcatblk (t, b->data + i, k)) goto Fail;
+			i += k;
+		}
+
+		d = b->data;
+		b->data = t->data;
+		b->slen = t->slen;
+		b->mlen = t->mlen;
+		t->data = d;
+		bdestroy (t);
+	}
+
+	if (NULL != nrepl) *nrepl = n;
+	return BSTR_OK;
+
+	Fail:;
+	bdestroy (t);
+	return BSTR_ERR;
+}
+
+/*
+ *  Character references.  The named ones are those of HTML 4, which include
+ *  the five of XML.  Each reference is at least as long as the UTF-8
+ *  encoding of what it stands for, so they can be decoded in place, and the
+ *  runs of text between them are found with memchr.
+ */
+static const struct {
+	char name[9];
+	cpUcs4 cp;
+} buEntity[] = {
+	{"AElig", 0x00C6}, {"Aacute", 0x00C1}, {"Acirc", 0x00C2},
+	{"Agrave", 0x00C0}, {"Alpha", 0x0391}, {"Aring", 0x00C5},
+	{"Atilde", 0x00C3}, {"Auml", 0x00C4}, {"Beta", 0x0392},
+	{"Ccedil", 0x00C7}, {"Chi", 0x03A7}, {"Dagger", 0x2021},
+	{"Delta", 0x0394}, {"ETH", 0x00D0}, {"Eacute", 0x00C9},
+	{"Ecirc", 0x00CA}, {"Egrave", 0x00C8}, {"Epsilon", 0x0395},
+	{"Eta", 0x0397}, {"Euml", 0x00CB}, {"Gamma", 0x0393}, {"Iacute", 0x00CD},
+	{"Icirc", 0x00CE}, {"Igrave", 0x00CC}, {"Iota", 0x0399},
+	{"Iuml", 0x00CF}, {"Kappa", 0x039A}, {"Lambda", 0x039B}, {"Mu", 0x039C},
+	{"Ntilde", 0x00D1}, {"Nu", 0x039D}, {"OElig", 0x0152},
+	{"Oacute", 0x00D3}, {"Ocirc", 0x00D4}, {"Ograve", 0x00D2},
+	{"Omega", 0x03A9}, {"Omicron", 0x039F}, {"Oslash", 0x00D8},
+	{"Otilde", 0x00D5}, {"Ouml", 0x00D6}, {"Phi", 0x03A6}, {"Pi", 0x03A0},
+	{"Prime", 0x2033}, {"Psi", 0x03A8}, {"Rho", 0x03A1}, {"Scaron", 0x0160},
+	{"Sigma", 0x03A3}, {"THORN", 0x00DE}, {"Tau", 0x03A4}, {"Theta", 0x0398},
+	{"Uacute", 0x00DA}, {"Ucirc", 0x00DB}, {"Ugrave", 0x00D9},
+	{"Upsilon", 0x03A5}, {"Uuml", 0x00DC}, {"Xi", 0x039E},
+	{"Yacute", 0x00DD}, {"Yuml", 0x0178}, {"Zeta", 0x0396},
+	{"aacute", 0x00E1}, {"acirc", 0x00E2}, {"acute", 0x00B4},
+	{"aelig", 0x00E6}, {"agrave", 0x00E0}, {"alefsym", 0x2135},
+	{"alpha", 0x03B1}, {"amp", 0x0026}, {"and", 0x2227}, {"ang", 0x2220},
+	{"apos", 0x0027}, {"aring", 0x00E5}, {"asymp", 0x2248},
+	{"atilde", 0x00E3}, {"auml", 0x00E4}, {"bdquo", 0x201E},
+	{"beta", 0x03B2}, {"brvbar", 0x00A6}, {"bull", 0x2022}, {"cap", 0x2229},
+	{"ccedil", 0x00E7}, {"cedil", 0x00B8}, {"cent", 0x00A2}, {"chi", 0x03C7},
+	{"circ", 0x02C6}, {"clubs", 0x2663}, {"cong", 0x2245}, {"copy", 0x00A9},
+	{"crarr", 0x21B5}, {"cup", 0x222A}, {"curren", 0x00A4}, {"dArr", 0x21D3},
+	{"dagger", 0x2020}, {"darr", 0x2193}, {"deg", 0x00B0}, {"delta", 0x03B4},
+	{"diams", 0x2666}, {"divide", 0x00F7}, {"eacute", 0x00E9},
+	{"ecirc", 0x00EA}, {"egrave", 0x00E8}, {"empty", 0x2205},
+	{"emsp", 0x2003}, {"ensp", 0x2002}, {"epsilon", 0x03B5},
+	{"equiv", 0x2261}, {"eta", 0x03B7}, {"eth", 0x00F0}, {"euml", 0x00EB},
+	{"euro", 0x20AC}, {"exist", 0x2203}, {"fnof", 0x0192},
+	{"forall", 0x2200}, {"frac12", 0x00BD}, {"frac14", 0x00BC},
+	{"frac34", 0x00BE}, {"frasl", 0x2044}, {"gamma", 0x03B3}, {"ge", 0x2265},
+	{"gt", 0x003E}, {"hArr", 0x21D4}, {"harr", 0x2194}, {"hearts", 0x2665},
+	{"hellip", 0x2026}, {"iacute", 0x00ED}, {"icirc", 0x00EE},
+	{"iexcl", 0x00A1}, {"igrave", 0x00EC}, {"image", 0x2111},
+	{"infin", 0x221E}, {"int", 0x222B}, {"iota", 0x03B9}, {"iquest", 0x00BF},
+	{"isin", 0x2208}, {"iuml", 0x00EF}, {"kappa", 0x03BA}, {"lArr", 0x21D0},
+	{"lambda", 0x03BB}, {"lang", 0x2329}, {"laquo", 0x00AB},
+	{"larr", 0x2190}, {"lceil", 0x2308}, {"ldquo", 0x201C}, {"le", 0x2264},
+	{"lfloor", 0x230A}, {"lowast", 0x2217}, {"loz", 0x25CA}, {"lrm", 0x200E},
+	{"lsaquo", 0x2039}, {"lsquo", 0x2018}, {"lt", 0x003C}, {"macr", 0x00AF},
+	{"mdash", 0x2014}, {"micro", 0x00B5}, {"middot", 0x00B7},
+	{"minus", 0x2212}, {"mu", 0x03BC}, {"nabla", 0x2207}, {"nbsp", 0x00A0},
+	{"ndash", 0x2013}, {"ne", 0x2260}, {"ni", 0x220B}, {"not", 0x00AC},
+	{"notin", 0x2209}, {"nsub", 0x2284}, {"ntilde", 0x00F1}, {"nu", 0x03BD},
+	{"oacute", 0x00F3}, {"ocirc", 0x00F4}, {"oelig", 0x0153},
+	{"ograve", 0x00F2}, {"oline", 0x203E}, {"omega", 0x03C9},
+	{"omicron", 0x03BF}, {"oplus", 0x2295}, {"or", 0x2228}, {"ordf", 0x00AA},
+	{"ordm", 0x00BA}, {"oslash", 0x00F8}, {"otilde", 0x00F5},
+	{"otimes", 0x2297}, {"ouml", 0x00F6}, {"para", 0x00B6}, {"part", 0x2202},
+	{"permil", 0x2030}, {"perp", 0x22A5}, {"phi", 0x03C6}, {"pi", 0x03C0},
+	{"piv", 0x03D6}, {"plusmn", 0x00B1}, {"pound", 0x00A3},
+	{"prime", 0x2032}, {"prod", 0x220F}, {"prop", 0x221D}, {"psi", 0x03C8},
+	{"quot", 0x0022}, {"rArr", 0x21D2}, {"radic", 0x221A}, {"rang", 0x232A},
+	{"raquo", 0x00BB}, {"rarr", 0x2192}, {"rceil", 0x2309},
+	{"rdquo", 0x201D}, {"real", 0x211C}, {"reg", 0x00AE}, {"rfloor", 0x230B},
+	{"rho", 0x03C1}, {"rlm", 0x200F}, {"rsaquo", 0x203A}, {"rsquo", 0x2019},
+	{"sbquo", 0x201A}, {"scaron", 0x0161}, {"sdot", 0x22C5},
+	{"sect", 0x00A7}, {"shy", 0x00AD}, {"sigma", 0x03C3}, {"sigmaf", 0x03C2},
+	{"sim", 0x223C}, {"spades", 0x2660}, {"sub", 0x2282}, {"sube", 0x2286},
+	{"sum", 0x2211}, {"sup", 0x2283}, {"sup1", 0x00B9}, {"sup2", 0x00B2},
+	{"sup3", 0x00B3}, {"supe", 0x2287}, {"szlig", 0x00DF}, {"tau", 0x03C4},
+	{"there4", 0x2234}, {"theta", 0x03B8}, {"thetasym", 0x03D1},
+	{"thinsp", 0x2009}, {"thorn", 0x00FE}, {"tilde", 0x02DC},
+	{"times", 0x00D7}, {"trade", 0x2122}, {"uArr", 0x21D1},
+	{"uacute", 0x00FA}, {"uarr", 0x2191}, {"ucirc", 0x00FB},
+	{"ugrave", 0x00F9}, {"uml", 0x00A8}, {"upsih", 0x03D2},
+	{"upsilon", 0x03C5}, {"uuml", 0x00FC}, {"weierp", 0x2118},
+	{"xi", 0x03BE}, {"yacute", 0x00FD}, {"yen", 0x00A5}, {"yuml", 0x00FF},
+	{"zeta", 0x03B6}, {"zwj", 0x200D}, {"zwnj", 0x200C}
+};
+
+#define BU_ENTITY_QTY ((int) (sizeof (buEntity) / sizeof (buEntity[0])))
+
+static int buIsAlnum (int c) {
+	return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+/* Parse the reference which starts with the '&' at d[0], in len bytes of
+   data.  If it is well formed its length is returned and the code point
+   it stands for is written to *v (-1 if that is not a legal character);
+   otherwise 0 is returned. */
+static int buEntityParse (const unsigned char * d, int len, cpUcs4 * v) {
+unsigned long n;
+int i, c, hex, lo, hi, m;
+
+	if (len < 3) return 0;
+	if (d[1] == '#') {
+		hex = (d[2] | 0x20) == 'x';
+		for (n = 0, i = 2 + hex; i < len; i++) {
+			c = d[i];
+			if (c >= '0' && c <= '9') c -= '0';
+			else if (hex && (c | 0x20) >= 'a' && (c | 0x20) <= 'f') c = (c | 0x20) - 'a' + 10;
+			else break;
+			if (n <= 0x10FFFFUL) n = n * (hex ? 16 : 10) + (unsigned long) c;
+		}
+		if (i == 2 + hex || i >= len || d[i] != ';') return 0;
+		*v = (n != 0 && n <= 0x10FFFFUL && isLegalUnicodeCodePoint ((cpUcs4) n)) ? (cpUcs4) n : -1;
+		return i + 1;
+	}
+
+	for (i = 1; i < len && i < 10 && buIsAlnum (d[i]); i++) {}
+	if (i == 1 || i == 10 || i >= len || d[i] != ';') return 0;
+	lo = 0;
+	hi = BU_ENTITY_QTY - 1;
+	while (lo <= hi) {
+		m = (lo + hi) >> 1;
+		c = strncmp ((const char *) d + 1, buEntity[m].name, (size_t) (i - 1));
+		if (c == 0 && buEntity[m].name[i - 1] != '\0') c = -1;
+		if (c == 0) {
+			*v = buEntity[m].cp;
+			return i + 1;
+		}
+		if (c < 0) hi = m - 1;
+		else lo = m + 1;
+	}
+	return 0;
+}
+
+/*  int buEntityDecode (bstring b, cpUcs4 errCh)
+ *
+ *  Replace the character references in b (named ones such as &amp; and
+ *  &eacute;, and numeric ones such as &#233; and &#xE9;) by the UTF-8
+ *  encoding of the characters they stand for.  Numeric references to code
+ *  points which are not legal characters are replaced by errCh, or by
+ *  U+FFFD if errCh is not a legal code point.  References which are not
+ *  terminated by ';', and unknown names, are left as they are.  The
+ *  decoding is done in place, in a single pass.
+ */
+int buEntityDecode (bstring b, cpUcs4 errCh) {
+unsigned char * d, * p;
+int i, j, k, len;
+cpUcs4 v;
+
+	if (b == NULL || b->data == NULL || b->mlen < b->slen ||
+	    b->slen < 0 || b->mlen <= 0) return BSTR_ERR;
+	if (!isLegalUnicodeCodePoint (errCh)) errCh = UNICODE__CODE_POINT__REPLACEMENT_CHARACTER;
+
+	d = b->data;
+	len = b->slen;
+	if (NULL == (p = (unsigned char *) memchr (d, '&', (size_t) len))) return BSTR_OK;
+	for (i = j = (int) (p - d); i < len;) {
+		/* d[i] is an '&' */
+		if (0 < (k = buEntityParse (d + i, len - i, &v))) {
+			j += utf8EncodeCodePoint (v < 0 ? errCh : v, d + j);
+			i += k;
+		} else {
+			d[j++] = d[i++];
+		}
+		if (NULL == (p = (unsigned char *) memchr (d + i, '&', (size_t) (len - i)))) p = d + len;
+		k = (int) (p - d) - i;
+		if (j < i) memmove (d + j, d + i, (size_t) k);
+		i += k;
+		j += k;
+	}
+	b->slen = j;
+	d[j] = (unsigned char) '\0';
+	return BSTR_OK;
+}
+
+/*
+ *  Single byte legacy encodings.  ISO-8859-1 maps each byte to the code
+ *  point of the same value; Windows-1252 differs only in 0x80 - 0x9F, where
+ *  the five bytes it leaves undefined are mapped to the C1 controls of the
+ *  same value, as web browsers do.
+ */
+static const cpUcs4 buCp1252High[32] = {
+	0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+	0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+#define buLatinCodePoint(c,enc) \
+	(((enc) == BU_CP1252 && (c) >= 0x80 && (c) < 0xA0) ? buCp1252High[(c) - 0x80] : (cpUcs4) (c))
+
+/*  int buAppendBlkLatin (bstring bu, const unsigned char* blk, int len,
+ *                        int enc)
+ *
+ *  Append the len bytes at blk, which are in the encoding enc (BU_LATIN1 or
+ *  BU_CP1252), to bu as UTF-8.  As with bcatblk, blk must not point into
+ *  bu.  The output is sized exactly by a counting pass, and runs of ASCII
+ *  are counted and copied a word at a time.
+ */
+int buAppendBlkLatin (bstring bu, const unsigned char* blk, int len, int enc) {
+unsigned char * d;
+int i, n;
+size_t ext;
+
+	if (NULL == bu || NULL == blk || len < 0 || bu->slen < 0 || bu->mlen <= 0 ||
+	    bu->mlen < bu->slen || (enc != BU_LATIN1 && enc != BU_CP1252)) return BSTR_ERR;
+
+	for (ext = 0, i = 0; i < len;) {
+		if (i + BU_WSZ <= len) {
+			BU_WORD w = (buLoadWord (blk + i) & BU_HIGH) >> 7;
+			if (enc == BU_LATIN1 || 0 == w) {
+				ext += (size_t) ((w * BU_ONES) >> ((BU_WSZ - 1) * 8));
+				i += BU_WSZ;
+				continue;
+			}
+		}
+		if (blk[i] >= 0x80) ext += (buLatinCodePoint (blk[i], enc) < 0x800) ? 1 : 2;
+		i++;
+	}
+	if (ext > (size_t) (INT_MAX - 1 - len - bu->slen)) return BSTR_ERR;
+
+	n = bu->slen + len + (int) ext;
+	if (BSTR_OK != balloc (bu, n + 1)) return BSTR_ERR;
+
+	d = bu->data + bu->slen;
+	for (i = 0; i < len;) {
+		if (i + BU_WSZ <= len && 0 == (buLoadWord (blk + i) & BU_HIGH)) {
+			memcpy (d, blk + i, BU_WSZ);
+			d += BU_WSZ;
+			i += BU_WSZ;
+		} else if (blk[i] < 0x80) {
+			*d++ = blk[i++];
+		} else {
+			d += utf8EncodeCodePoint (buLatinCodePoint (blk[i], enc), d);
+			i++;
+		}
+	}
+	bu->slen = n;
+	bu->data[n] = (unsigned char) '\0';
+	return BSTR_OK;
+}
+
+/* The byte of enc which encodes the code point c, or -1 */
+static int buLatinByte (cpUcs4 c, int enc) {
+int i;
+	if (c < 0x80 || (c >= 0xA0 && c < 0x100)) return (int) c;
+	if (enc == BU_LATIN1) return (c < 0x100) ? (int) c : -1;
+	for (i = 0; i < 32; i++) if (buCp1252High[i] == c) return 0x80 + i;
+	return -1;
+}
+
+/* Append the UTF-8 at s to b, which has room for len more bytes, in the
+   encoding enc.  Returns the number of bytes of s converted, which is less
+   than len only if errCh is not a byte value and s holds something which
+   cannot be converted; the output of the bytes before it is kept. */
+static int buLatinConv (bstring b, const unsigned char * s, int len, int enc, int errCh) {
+int i, k, n, c;
+unsigned char * d;
+
+	d = b->data;
+	for (n = b->slen, i = 0; i < len; i += k) {
+		if (i + BU_WSZ <= len && 0 == (buLoadWord (s + i) & BU_HIGH)) {
+			memcpy (d + n, s + i, BU_WSZ);
+			n += BU_WSZ;
+			k = BU_WSZ;
+		} else if (s[i] < 0x80) {
+			d[n++] = s[i];
+			k = 1;
+		} else {
+			c = buLatinByte (utf8DecodeCodePoint (s + i, len - i, &k), enc);
+			if (c < 0) {
+				if (errCh < 0 || errCh > 0xFF) break;
+				c = errCh;
+			}
+			d[n++] = (unsigned char) c;
+		}
+	}
+	b->slen = n;
+	d[n] = (unsigned char) '\0';
+	return i;
+}
+
+/*  int buGetLatin (bstring b, const_bstring bu, int enc, int errCh)
+ *
+ *  Append the UTF-8 content of bu to b in the encoding enc (BU_LATIN1 or
+ *  BU_CP1252).  Code points that enc cannot represent and invalid bytes are
+ *  replaced by the byte errCh; if errCh is not in the range 0 to 255 they
+ *  cause BSTR_ERR to be returned and b to be left unchanged.  The output is
+ *  never longer than bu, so it is allocated up front.
+ */
+int buGetLatin (bstring b, const_bstring bu, int enc, int errCh) {
+int len, oldSlen;
+
+	if (NULL == b || b->slen < 0 || b->mlen <= 0 || b->mlen < b->slen ||
+	    NULL == bdata (bu) || bu->slen < 0 ||
+	    (enc != BU_LATIN1 && enc != BU_CP1252)) return BSTR_ERR;
+	len = bu->slen;
+	if (len > INT_MAX - 1 - b->slen) return BSTR_ERR;
+	if (BSTR_OK != balloc (b, b->slen + len + 1)) return BSTR_ERR;
+
+	oldSlen = b->slen;
+	if (len != buLatinConv (b, bu->data, len, enc, errCh)) {
+		b->slen = oldSlen;
+		b->data[oldSlen] = (unsigned char) '\0';
+		return BSTR_ERR;
+	}
+	return BSTR_OK;
+}
+
+struct buLatinCtx {
+	struct bStream * sInp;
+	bstring src, dst;
+	int enc, errCh, toLatin;
+};
+
+/* Length of an incomplete UTF-8 sequence at the end of d, if any */
+static int buPartialTail (const unsigned char * d, int len) {
+int i, n;
+	for (i = len - 1; i >= 0 && i >= len - 3; i--) {
+		if (0x80 != (d[i] & 0xC0)) {
+			n = (d[i] >= 0xF0) ? 4 : (d[i] >= 0xE0) ? 3 : (d[i] >= 0xC0) ? 2 : 1;
+			return (n > len - i) ? len - i : 0;
+		}
+	}
+	return 0;
+}
+
+static size_t buLatinPart (void * buff, size_t elsize, size_t nelem, void * parm) {
+struct buLatinCtx * ctx = (struct buLatinCtx *) parm;
+size_t tsz;
+int l, n, ret;
+
+	if (NULL == buff || NULL == parm || 0 == elsize) return 0;
+	tsz = elsize * nelem;
+
+	while ((size_t) ctx->dst->slen < tsz && NULL != ctx->sInp) {
+		l = ctx->src->slen;
+		if (BSTR_ERR == bsreada (ctx->src, ctx->sInp,
+		                         bsbufflength (ctx->sInp, BSTR_BS_BUFF_LENGTH_GET))) {
+			ctx->sInp = NULL;
+			l = 0;
+		} else {
+			l = buPartialTail (ctx->src->data, ctx->src->slen);
+			if (!ctx->toLatin) l = 0;
+		}
+		if (ctx->toLatin) {
+			/* On an unconvertible code point, keep what came before it */
+			n = ctx->src->slen - l;
+			ret = BSTR_ERR;
+			if (n < INT_MAX - ctx->dst->slen &&
+			    BSTR_OK == balloc (ctx->dst, ctx->dst->slen + n + 1) &&
+			    n == buLatinConv (ctx->dst, ctx->src->data, n, ctx->enc, ctx->errCh))
+				ret = BSTR_OK;
+		} else {
+			ret = buAppendBlkLatin (ctx->dst, ctx->src->data, ctx->src->slen, ctx->enc);
+		}
+		if (BSTR_OK != ret) ctx->sInp = NULL;
+		bdelete (ctx->src, 0, ctx->src->slen - l);
+	}
+
+	tsz = ((size_t) ctx->dst->slen < tsz) ? ctx->dst->slen / elsize : nelem;
+	if (tsz > 0) {
+		memcpy (buff, ctx->dst->data, tsz * elsize);
+		bdelete (ctx->dst, 0, (int) (tsz * elsize));
+		return tsz;
+	}
+
+	/* Deallocate once EOF becomes triggered */
+	bdestroy (ctx->src);
+	bdestroy (ctx->dst);
+	free (ctx);
+	return 0;
+}
+
+static struct bStream * buLatinStreamOpen (struct bStream * sInp, int enc, int errCh, int toLatin) {
+struct buLatinCtx * ctx;
+struct bStream * sOut;
+
+	if (NULL == sInp || (enc != BU_LATIN1 && enc != BU_CP1252)) return NULL;
+	if (NULL == (ctx = (struct buLatinCtx *) malloc (sizeof (struct buLatinCtx))))
+		return NULL;
+	ctx->sInp = sInp;
+	ctx->enc = enc;
+	ctx->errCh = errCh;
+	ctx->toLatin = toLatin;
+	ctx->src = bfromcstr ("");
+	ctx->dst = bfromcstr ("");
+	if (NULL == ctx->src || NULL == ctx->dst ||
+	    NULL == (sOut = bsopen ((bNread) buLatinPart, ctx))) {
+		bdestroy (ctx->src);
+		bdestroy (ctx->dst);
+		free (ctx);
+		return NULL;
+	}
+	return sOut;
+}
+
+/*  struct bStream * buLatinStream (struct bStream * sInp, int enc)
+ *
+ *  Creates a bStream which reads the content of sInp, in the encoding enc
+ *  (BU_LATIN1 or BU_CP1252), converted to UTF-8.  The stream should be read
+ *  to its end before being closed with bsclose, after which sInp may be
+ *  closed.  NULL is returned on error.
+ */
+struct bStream * buLatinStream (struct bStream * sInp, int enc) {
+	return buLatinStreamOpen (sInp, enc, -1, 0);
+}
+
+/*  struct bStream * buGetLatinStream (struct bStream * sInp, int enc,
+ *                                     int errCh)
+ *
+ *  Creates a bStream which reads the UTF-8 content of sInp converted to the
+ *  encoding enc as buGetLatin does.  If errCh is not a byte value, the
+ *  stream ends at the first code point which cannot be converted, after
+ *  the output for all of the input before it.
+ */
+struct bStream * buGetLatinStream (struct bStream * sInp, int enc, int errCh) {
+	return buLatinStreamOpen (sInp, enc, errCh, 1);
+}
+
+/*
+ *  Grapheme clusters (the extended grapheme clusters of UAX #29).  Each code
+ *  point has a Grapheme_Cluster_Break property from the table in bunitab.h;
+ *  invalid bytes are treated as code points of property Other.  Whether
+ *  there is a boundary between two code points depends only on their
+ *  properties, except for emoji ZWJ sequences and pairs of regional
+ *  indicators, which depend on what precedes them.
+ */
+static int buGraphemeBreak (cpUcs4 c) {
+int g;
+	if (c < BUGRAPHEME_LIMIT) {
+		g = buGraphemeBlock[(buGraphemeIndex[c >> BUGRAPHEME_SHIFT] << BUGRAPHEME_SHIFT) +
+		                    (c & ((1 << BUGRAPHEME_SHIFT) - 1))];
+		if (g == BUGCB_LVT && 0 == (c - 0xAC00) % 28) g = BUGCB_LV; /* Hangul LV */
+		return g;
+	}
+	if ((c >= 0xE0020 && c <= 0xE007F) || (c >= 0xE0100 && c <= 0xE01EF)) return BUGCB_EXTEND;
+	if (c >= 0xE0000 && c <= 0xE0FFF) return BUGCB_CONTROL;
+	return BUGCB_OTHER;
+}
+
+/* 1 if there is a boundary between code points of properties a and b, 0 if
+   there is not, and -1 if it depends on the preceding code points. */
+static int buGraphemePair (int a, int b) {
+	if (a == BUGCB_CR && b == BUGCB_LF) return 0;
+	if (a == BUGCB_CONTROL || a == BUGCB_CR || a == BUGCB_LF ||
+	    b == BUGCB_CONTROL || b == BUGCB_CR || b == BUGCB_LF) return 1;
+	if (a == BUGCB_L && (b == BUGCB_L || b == BUGCB_V || b == BUGCB_LV || b == BUGCB_LVT)) return 0;
+	if ((a == BUGCB_LV || a == BUGCB_V) && (b == BUGCB_V || b == BUGCB_T)) return 0;
+	if ((a == BUGCB_LVT || a == BUGCB_T) && b == BUGCB_T) return 0;
+	if (b == BUGCB_EXTEND || b == BUGCB_ZWJ || b == BUGCB_SPACING) return 0;
+	if (a == BUGCB_PREPEND) return 0;
+	if ((a == BUGCB_ZWJ && b == BUGCB_EXTPICT) || (a == BUGCB_RI && b == BUGCB_RI)) return -1;
+	return 1;
+}
+
+/*  int buGraphemeNext (const_bstring b, int pos)
+ *
+ *  Return the offset of the first grapheme cluster boundary after pos in b,
+ *  which is b->slen at the end of the string, or BSTR_ERR if b is invalid
+ *  or pos is out of range.  pos should itself be a boundary, so that the
+ *  clusters of b are enumerated by starting from 0 and feeding each result
+ *  back in until b->slen is reached.
+ */
+int buGraphemeNext (const_bstring b, int pos) {
+const unsigned char * d;
+int i, k, a, g, ep, join, ri;
+
+	if (NULL == bdata (b) || pos < 0 || pos >= b->slen) return BSTR_ERR;
+	d = b->data;
+
+	/* Nothing joins an ASCII character other than CR to an ASCII successor,
+	   and nothing joins an ASCII control to anything. */
+	if (d[pos] < 0x80 && d[pos] != '\r' &&
+	    (pos + 1 >= b->slen || d[pos + 1] < 0x80 || d[pos] < 0x20 || d[pos] == 0x7F))
+		return pos + 1;
+
+	a = buGraphemeBreak (utf8DecodeCodePoint (d + pos, b->slen - pos, &k));
+	ep = (a == BUGCB_EXTPICT);
+	join = 0;
+	ri = (a == BUGCB_RI);
+	for (i = pos + k; i < b->slen; i += k) {
+		g = buGraphemeBreak (utf8DecodeCodePoint (d + i, b->slen - i, &k));
+		switch (buGraphemePair (a, g)) {
+		case 1:
+			return i;
+		case -1:
+			if (g == BUGCB_RI ? !(ri & 1) : !join) return i;
+			break;
+		}
+		join = (g == BUGCB_ZWJ) && ep;
+		ep = (g == BUGCB_EXTPICT) || (ep && g == BUGCB_EXTEND);
+		ri = (g == BUGCB_RI) ? ri + 1 : 0;
+		a = g;
+	}
+	return b->slen;
+}
+
+/* The code point that ends at offset pos of d, and its length in k; a byte
+   which is not the end of a valid sequence is an invalid code point. */
+static cpUcs4 buPrevCodePoint (const unsigned char * d, int pos, int * k) {
+int i;
+cpUcs4 c;
+
+	for (i = pos - 1; i > 0 && i > pos - 4 && 0x80 == (d[i] & 0xC0); i--) {}
+	c = utf8DecodeCodePoint (d + i, pos - i, k);
+	if (*k == pos - i) return c;
+	*k = 1;
+	return UTF8_INVALID_BYTE_BASE + d[pos - 1];
+}
+
+/*  int buTruncateGraphemes (bstring b, int maxBytes)
+ *
+ *  Truncate b to at most maxBytes bytes without splitting a grapheme
+ *  cluster, that is, to the last cluster boundary at or before maxBytes.
+ *  Only the bytes around the cut are examined: the search steps back from
+ *  maxBytes to a position which is a boundary regardless of its context,
+ *  and then moves forward cluster by cluster.
+ */
+int buTruncateGraphemes (bstring b, int maxBytes) {
+int p, j, k, g;
+
+	if (b == NULL || b->data == NULL || b->slen < 0 || b->mlen < b->slen ||
+	    b->mlen <= 0 || maxBytes < 0) return BSTR_ERR;
+	if (b->slen <= maxBytes) return BSTR_OK;
+
+	for (p = maxBytes; p > 0; p--) {
+		if (0x80 == (b->data[p] & 0xC0)) continue;
+		g = buGraphemeBreak (utf8DecodeCodePoint (b->data + p, b->slen - p, &k));
+		if (1 == buGraphemePair (buGraphemeBreak (buPrevCodePoint (b->data, p, &k)), g))
+			break;
+	}
+	while (p < maxBytes && (j = buGraphemeNext (b, p)) <= maxBytes) p = j;
+
+	return btrunc (b, p);
+}
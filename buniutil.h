@@ -24,6 +24,56 @@ extern "C" {
 
 extern int buIsUTF8Content (const_bstring bu);
 extern int buAppendBlkUcs4 (bstring b, const cpUcs4* bu, int len, cpUcs4 errCh);
+extern int buSanitize (bstring b, cpUcs4 errCh, int * nrepl);
+extern int buEntityDecode (bstring b, cpUcs4 errCh);
+
+/* ISO-8859-1 and Windows-1252 conversions */
+#define BU_LATIN1 (0)
+#define BU_CP1252 (1)
+extern int buAppendBlkLatin (bstring bu, const unsigned char* blk, int len, int enc);
+extern int buGetLatin (bstring b, const_bstring bu, int enc, int errCh);
+extern struct bStream * buLatinStream (struct bStream * sInp, int enc);
+extern struct bStream * buGetLatinStream (struct bStream * sInp, int enc, int errCh);
+
+/* Caseless operations using Unicode simple case folding. */
+extern cpUcs4 buFoldCodePoint (cpUcs4 c);
+extern int buFoldCase (bstring b);
+extern int buStricmp (const_bstring b0, const_bstring b1);
+extern int buInstrCaseless (const_bstring b1, int pos, const_bstring b2);
+
+/* Unicode normalization; form is UTF8_NFC or UTF8_NFD. */
+extern int buIsNormalized (const_bstring b, int form);
+extern int buNormalize (bstring b, int form);
+extern struct bStream * buNormalizeStream (struct bStream * sInp, int form);
+
+/* Code point addressing, optionally through a sparse offset index. */
+struct buCpIndex {
+	int k;                      /* Code points between entries */
+	int qty, mlen;              /* Entries built and allocated */
+	int * offsets;              /* offsets[i] is the offset of code point i*k */
+	int cpLen;                  /* Number of code points, or -1 if not known */
+	const unsigned char * data; /* The string the entries describe */
+	int slen;
+};
+extern struct buCpIndex * buCpIndexCreate (int k);
+extern int buCpIndexDestroy (struct buCpIndex * ix);
+extern int buCpIndexInvalidate (struct buCpIndex * ix, int pos);
+extern int buCpOffset (const_bstring b, struct buCpIndex * ix, int cp);
+extern int buCpPosition (const_bstring b, struct buCpIndex * ix, int pos);
+extern int buCpLength (const_bstring b, struct buCpIndex * ix);
+extern bstring buMidstr (const_bstring b, struct buCpIndex * ix, int left, int len);
+extern int buInstr (const_bstring b1, struct buCpIndex * ix, int pos, const_bstring b2);
+
+/* Terminal display width */
+extern int buCodePointWidth (cpUcs4 c);
+extern int buDisplayWidth (const_bstring b);
+extern int buJustifyRight (bstring b, int width, int space);
+extern int buJustifyCenter (bstring b, int width, int space);
+extern int buJustifyMargin (bstring b, int width, int space);
+
+/* Grapheme clusters */
+extern int buGraphemeNext (const_bstring b, int pos);
+extern int buTruncateGraphemes (bstring b, int maxBytes);
 
 /* For those unfortunate enough to be stuck supporting UTF16. */
 extern int buGetBlkUTF16 (/* @out */ cpUcs2* ucs2, int len, cpUcs4 errCh, const_bstring bu, int pos);
@@ -0,0 +1,376 @@
+#!/usr/bin/env python3
+#
+# This source file is part of the bstring string library.  This code was
+# written by Paul Hsieh in 2002-2015, and is covered by the BSD open source
+# license and the GPL. Refer to the accompanying documentation for details
+# on usage and license.
+#
+
+#
+# mkunitab.py
+#
+# Generates bunitab.h, the Unicode property tables used by buniutil.c and
+# utf8util.c, from the Unicode character database shipped with Python's
+# unicodedata module.  Run "make tables" to regenerate it.
+#
+# Each table is a two level lookup: the code point's high bits select a block
+# number from the index array, and its low bits select an entry within that
+# block.  Identical blocks are stored only once, which keeps the tables to a
+# few kilobytes.  Every table set is guarded by a BUNITAB_xxx macro so that a
+# module only compiles in the tables it uses.
+#
+
+import sys
+import unicodedata
+
+MAX_CP = 0x110000
+
+
+def two_level(name, values, limit, shift, default):
+    """Emit the index/block arrays of a two level table covering code points
+    0 .. limit-1 (rounded up to a whole block) whose entries are the small
+    integers values(cp).  Code points beyond the table take default."""
+    bsize = 1 << shift
+    nblocks = (limit + bsize - 1) >> shift
+    blocks = []
+    bmap = {}
+    index = []
+    for b in range(nblocks):
+        blk = tuple(values(cp) if cp < MAX_CP else default
+                    for cp in range(b << shift, (b + 1) << shift))
+        if blk not in bmap:
+            bmap[blk] = len(blocks)
+            blocks.append(blk)
+        index.append(bmap[blk])
+    assert len(blocks) <= 256
+    assert max(max(b) for b in blocks) <= 255
+    out = []
+    out.append("#define %s_SHIFT (%d)" % (name.upper(), shift))
+    out.append("#define %s_LIMIT (0x%XL)" % (name.upper(), nblocks << shift))
+    out.append("")
+    out.append("static const unsigned char %sIndex[%d] = {" % (name, len(index)))
+    out.extend(rows(index))
+    out.append("};")
+    out.append("")
+    out.append("static const unsigned char %sBlock[%d] = {" %
+               (name, len(blocks) * bsize))
+    for blk in blocks:
+        out.extend(rows(blk))
+    out.append("};")
+    return out
+
+
+def rows(vals, per=16, fmt="%d"):
+    s = [fmt % v for v in vals]
+    return ["\t" + ", ".join(s[i:i + per]) + "," for i in range(0, len(s), per)]
+
+
+def simple_fold(cp):
+    """Simple case folding (CaseFolding.txt statuses C and S)."""
+    c = chr(cp)
+    f = c.casefold()
+    if len(f) == 1:
+        return ord(f)
+    f = c.lower()
+    if len(f) == 1:
+        return ord(f)
+    return cp
+
+
+def gen_fold():
+    deltas = {0: 0}
+    limit = 0
+    for cp in range(MAX_CP):
+        d = simple_fold(cp) - cp
+        if d:
+            limit = cp + 1
+            if d not in deltas:
+                deltas[d] = len(deltas)
+    dlist = sorted(deltas, key=lambda d: deltas[d])
+    out = ["#if defined (BUNITAB_FOLD)", "",
+           "/* Simple case folding: fold (c) = c + buFoldDelta[entry] */", ""]
+    out += two_level("buFold", lambda cp: deltas[simple_fold(cp) - cp],
+                     limit, 7, 0)
+    out.append("")
+    out.append("static const cpUcs4 buFoldDelta[%d] = {" % len(dlist))
+    out.extend(rows(dlist, 8))
+    out.append("};")
+    out += ["", "#endif /* BUNITAB_FOLD */", ""]
+    return out
+
+
+def gen_norm():
+    # Canonical single level decompositions; Hangul syllables are handled
+    # algorithmically and are not in the table.
+    dec = {}
+    for cp in range(MAX_CP):
+        d = unicodedata.decomposition(chr(cp))
+        if d and not d.startswith("<"):
+            dec[cp] = [int(x, 16) for x in d.split()]
+    keys = sorted(dec)
+    assert max(len(v) for v in dec.values()) <= 2
+
+    def full(cp):
+        if cp in dec:
+            return sum((full(x) for x in dec[cp]), [])
+        return [cp]
+    maxfull = max(len(full(cp)) for cp in keys)
+
+    # Primary composites: pairs that recompose under NFC
+    comp = [i for i, cp in enumerate(keys) if len(dec[cp]) == 2 and
+            unicodedata.normalize("NFC", chr(cp)) == chr(cp)]
+    comp.sort(key=lambda i: dec[keys[i]])
+    assert len(keys) < 65536
+    second = set(dec[keys[i]][1] for i in comp)
+    second.update(range(0x1161, 0x1176))
+    second.update(range(0x11A8, 0x11C3))
+
+    def prop(cp):
+        c = chr(cp)
+        f = 0
+        if unicodedata.normalize("NFD", c) != c:
+            f |= 1
+        if unicodedata.normalize("NFC", c) != c:
+            f |= 2
+        elif cp in second:
+            f |= 4
+        return (unicodedata.combining(c), f)
+
+    props = {(0, 0): 0}
+    limit = 0
+    for cp in range(MAX_CP):
+        p = prop(cp)
+        if p != (0, 0):
+            limit = cp + 1
+            if p not in props:
+                props[p] = len(props)
+    plist = sorted(props, key=lambda p: props[p])
+
+    out = ["#if defined (BUNITAB_NORM)", "",
+           "/* Normalization properties: buNormProp[entry] = { canonical combining",
+           "   class, flags }, where the flags are BUNORM_NFD_NO, BUNORM_NFC_NO and",
+           "   BUNORM_NFC_MAYBE (the NFD_QC and NFC_QC properties). */", "",
+           "#define BUNORM_NFD_NO    (1)",
+           "#define BUNORM_NFC_NO    (2)",
+           "#define BUNORM_NFC_MAYBE (4)",
+           "#define BUNORM_MAX_DECOMP (%d)" % maxfull, ""]
+    out += two_level("buNorm", lambda cp: props[prop(cp)], limit, 6, 0)
+    out.append("")
+    out.append("static const unsigned char buNormProp[%d][2] = {" % len(plist))
+    out.extend(rows(["{%d, %d}" % p for p in plist], 8, "%s"))
+    out.append("};")
+    out.append("")
+    out.append("/* Canonical decompositions of buNormDecompKey[i], sorted by code point;")
+    out.append("   singletons have a second element of 0 */")
+    out.append("")
+    out.append("static const cpUcs4 buNormDecompKey[%d] = {" % len(keys))
+    out.extend(rows(keys, 8, "0x%05X"))
+    out.append("};")
+    out.append("")
+    out.append("static const cpUcs4 buNormDecomp[%d][2] = {" % len(keys))
+    out.extend(rows(["{0x%05X, 0x%05X}" % (dec[cp][0], (dec[cp] + [0])[1])
+                     for cp in keys], 4, "%s"))
+    out.append("};")
+    out.append("")
+    out.append("/* Indexes of the primary composites in buNormDecompKey, sorted by their")
+    out.append("   decompositions */")
+    out.append("")
+    out.append("static const unsigned short buNormComp[%d] = {" % len(comp))
+    out.extend(rows(comp, 12))
+    out.append("};")
+    out += ["", "#endif /* BUNITAB_NORM */", ""]
+    return out
+
+
+# Unassigned code points in these ranges default to East Asian Wide
+WIDE_DEFAULT = [(0x3400, 0x4DBF), (0x4E00, 0x9FFF), (0xF900, 0xFAFF),
+                (0x20000, 0x2FFFD), (0x30000, 0x3FFFD)]
+
+# Beyond the table the widths (and grapheme break properties) follow simple
+# rules, see buCodePointWidth and buGraphemeBreak
+WIDTH_TABLE_END = 0x20000
+
+
+def display_width(cp):
+    """Terminal columns: 0 for combining marks, format and control
+    characters and Hangul medial/final jamo, 2 for East Asian Wide and
+    Fullwidth, and 1 otherwise."""
+    c = chr(cp)
+    cat = unicodedata.category(c)
+    if cat == "Cn":
+        return 2 if any(a <= cp <= b for a, b in WIDE_DEFAULT) else 1
+    if cat in ("Mn", "Me", "Cc") or (cat == "Cf" and cp != 0xAD):
+        return 0
+    if 0x1160 <= cp <= 0x11FF or cp == 0x200B:
+        return 0
+    if unicodedata.east_asian_width(c) in ("W", "F"):
+        return 2
+    return 1
+
+
+def gen_width():
+    for cp in range(WIDTH_TABLE_END, MAX_CP):
+        if cp <= 0x3FFFD and (cp & 0xFFFE) != 0xFFFE:
+            w = 2
+        elif cp == 0xE0001 or 0xE0020 <= cp <= 0xE007F or 0xE0100 <= cp <= 0xE01EF:
+            w = 0
+        else:
+            w = 1
+        assert display_width(cp) == w, hex(cp)
+    out = ["#if defined (BUNITAB_WIDTH)", "",
+           "/* Display width in terminal columns of the code points below",
+           "   BUWIDTH_LIMIT */", ""]
+    out += two_level("buWidth", display_width, WIDTH_TABLE_END, 5, 1)
+    out += ["", "#endif /* BUNITAB_WIDTH */", ""]
+    return out
+
+
+# Grapheme_Cluster_Break (UAX #29).  Python's unicodedata lacks the property,
+# so it is derived from the general category and the few other properties
+# below, which are taken from PropList.txt, IndicSyllabicCategory.txt and
+# emoji-data.txt of the same Unicode version.
+GCB = ["Other", "CR", "LF", "Control", "Extend", "ZWJ", "Regional_Indicator",
+       "Prepend", "SpacingMark", "L", "V", "T", "LV", "LVT",
+       "Extended_Pictographic"]
+GCB_SHORT = ["OTHER", "CR", "LF", "CONTROL", "EXTEND", "ZWJ", "RI", "PREPEND",
+             "SPACING", "L", "V", "T", "LV", "LVT", "EXTPICT"]
+
+OTHER_GRAPHEME_EXTEND = [
+    (0x09BE, 0x09BE), (0x09D7, 0x09D7), (0x0B3E, 0x0B3E), (0x0B57, 0x0B57),
+    (0x0BBE, 0x0BBE), (0x0BD7, 0x0BD7), (0x0CC2, 0x0CC2), (0x0CD5, 0x0CD6),
+    (0x0D3E, 0x0D3E), (0x0D57, 0x0D57), (0x0DCF, 0x0DCF), (0x0DDF, 0x0DDF),
+    (0x1B35, 0x1B35), (0x200C, 0x200C), (0x302E, 0x302F), (0xFF9E, 0xFF9F),
+    (0x1133E, 0x1133E), (0x11357, 0x11357), (0x114B0, 0x114B0),
+    (0x114BD, 0x114BD), (0x115AF, 0x115AF), (0x11930, 0x11930),
+    (0x1D165, 0x1D165), (0x1D16E, 0x1D172), (0xE0020, 0xE007F)]
+
+PREPENDED_CONCATENATION_MARK = [
+    (0x0600, 0x0605), (0x06DD, 0x06DD), (0x070F, 0x070F), (0x0890, 0x0891),
+    (0x08E2, 0x08E2), (0x110BD, 0x110BD), (0x110CD, 0x110CD)]
+
+# Indic_Syllabic_Category Consonant_Preceding_Repha and Consonant_Prefixed
+PREPEND_INDIC = [
+    (0x0D4E, 0x0D4E), (0x111C2, 0x111C3), (0x1193F, 0x1193F),
+    (0x11941, 0x11941), (0x11A3A, 0x11A3A), (0x11A84, 0x11A89),
+    (0x11D46, 0x11D46)]
+
+# Unassigned Default_Ignorable_Code_Point ranges
+UNASSIGNED_IGNORABLE = [
+    (0x2065, 0x2065), (0xFFF0, 0xFFF8), (0xE0000, 0xE0000),
+    (0xE0002, 0xE001F), (0xE0080, 0xE00FF), (0xE01F0, 0xE0FFF)]
+
+SPACING_MARK_EXCEPTIONS = [
+    (0x102B, 0x102C), (0x1038, 0x1038), (0x1062, 0x1064), (0x1067, 0x106D),
+    (0x1083, 0x1083), (0x1087, 0x108C), (0x108F, 0x108F), (0x109A, 0x109C),
+    (0x1A61, 0x1A61), (0x1A63, 0x1A64), (0xAA7B, 0xAA7B), (0xAA7D, 0xAA7D),
+    (0x11720, 0x11721)]
+
+EXTENDED_PICTOGRAPHIC = [
+    (0x00A9, 0x00A9), (0x00AE, 0x00AE), (0x203C, 0x203C), (0x2049, 0x2049),
+    (0x2122, 0x2122), (0x2139, 0x2139), (0x2194, 0x2199), (0x21A9, 0x21AA),
+    (0x231A, 0x231B), (0x2328, 0x2328), (0x2388, 0x2388), (0x23CF, 0x23CF),
+    (0x23E9, 0x23F3), (0x23F8, 0x23FA), (0x24C2, 0x24C2), (0x25AA, 0x25AB),
+    (0x25B6, 0x25B6), (0x25C0, 0x25C0), (0x25FB, 0x25FE), (0x2600, 0x2605),
+    (0x2607, 0x2612), (0x2614, 0x2685), (0x2690, 0x2705), (0x2708, 0x2712),
+    (0x2714, 0x2714), (0x2716, 0x2716), (0x271D, 0x271D), (0x2721, 0x2721),
+    (0x2728, 0x2728), (0x2733, 0x2734), (0x2744, 0x2744), (0x2747, 0x2747),
+    (0x274C, 0x274C), (0x274E, 0x274E), (0x2753, 0x2755), (0x2757, 0x2757),
+    (0x2763, 0x2767), (0x2795, 0x2797), (0x27A1, 0x27A1), (0x27B0, 0x27B0),
+    (0x27BF, 0x27BF), (0x2934, 0x2935), (0x2B05, 0x2B07), (0x2B1B, 0x2B1C),
+    (0x2B50, 0x2B50), (0x2B55, 0x2B55), (0x3030, 0x3030), (0x303D, 0x303D),
+    (0x3297, 0x3297), (0x3299, 0x3299), (0x1F000, 0x1F0FF),
+    (0x1F10D, 0x1F10F), (0x1F12F, 0x1F12F), (0x1F16C, 0x1F171),
+    (0x1F17E, 0x1F17F), (0x1F18E, 0x1F18E), (0x1F191, 0x1F19A),
+    (0x1F1AD, 0x1F1E5), (0x1F201, 0x1F20F), (0x1F21A, 0x1F21A),
+    (0x1F22F, 0x1F22F), (0x1F232, 0x1F23A), (0x1F23C, 0x1F23F),
+    (0x1F249, 0x1F3FA), (0x1F400, 0x1F53D), (0x1F546, 0x1F64F),
+    (0x1F680, 0x1F6FF), (0x1F774, 0x1F77F), (0x1F7D5, 0x1F7FF),
+    (0x1F80C, 0x1F80F), (0x1F848, 0x1F84F), (0x1F85A, 0x1F85F),
+    (0x1F888, 0x1F88F), (0x1F8AE, 0x1F8FF), (0x1F90C, 0x1F93A),
+    (0x1F93C, 0x1F945), (0x1F947, 0x1FAFF), (0x1FC00, 0x1FFFD)]
+
+
+def in_ranges(cp, ranges):
+    return any(a <= cp <= b for a, b in ranges)
+
+
+def grapheme_break(cp):
+    """The Grapheme_Cluster_Break value of cp, as an index into GCB, with
+    Extended_Pictographic folded in as an extra value.  Hangul syllables are
+    all given LVT; buniutil.c tells LV syllables apart arithmetically."""
+    c = chr(cp)
+    cat = unicodedata.category(c)
+    if cp == 0x0D:
+        return GCB.index("CR")
+    if cp == 0x0A:
+        return GCB.index("LF")
+    if cp == 0x200D:
+        return GCB.index("ZWJ")
+    if in_ranges(cp, PREPENDED_CONCATENATION_MARK + PREPEND_INDIC):
+        return GCB.index("Prepend")
+    if cat in ("Mn", "Me") or in_ranges(cp, OTHER_GRAPHEME_EXTEND) or \
+            0x1F3FB <= cp <= 0x1F3FF:
+        return GCB.index("Extend")
+    if cat in ("Zl", "Zp", "Cc", "Cf") or \
+            in_ranges(cp, UNASSIGNED_IGNORABLE):
+        return GCB.index("Control")
+    if 0x1F1E6 <= cp <= 0x1F1FF:
+        return GCB.index("Regional_Indicator")
+    if (cat == "Mc" and not in_ranges(cp, SPACING_MARK_EXCEPTIONS)) or \
+            cp in (0x0E33, 0x0EB3):
+        return GCB.index("SpacingMark")
+    if 0x1100 <= cp <= 0x115F or 0xA960 <= cp <= 0xA97C:
+        return GCB.index("L")
+    if 0x1160 <= cp <= 0x11A7 or 0xD7B0 <= cp <= 0xD7C6:
+        return GCB.index("V")
+    if 0x11A8 <= cp <= 0x11FF or 0xD7CB <= cp <= 0xD7FB:
+        return GCB.index("T")
+    if 0xAC00 <= cp <= 0xD7A3:
+        return GCB.index("LVT")
+    if in_ranges(cp, EXTENDED_PICTOGRAPHIC):
+        return GCB.index("Extended_Pictographic")
+    return 0
+
+
+def gen_grapheme():
+    # Beyond the table only the tag characters and variation selectors
+    # (Extend) and the rest of plane 14 (Control) are not Other; see
+    # buGraphemeBreak.
+    for cp in range(WIDTH_TABLE_END, MAX_CP):
+        if 0xE0020 <= cp <= 0xE007F or 0xE0100 <= cp <= 0xE01EF:
+            g = "Extend"
+        elif 0xE0000 <= cp <= 0xE0FFF:
+            g = "Control"
+        else:
+            g = "Other"
+        assert GCB[grapheme_break(cp)] == g, hex(cp)
+    out = ["#if defined (BUNITAB_GRAPHEME)", "",
+           "/* Grapheme_Cluster_Break property of the code points below",
+           "   BUGRAPHEME_LIMIT, with Extended_Pictographic as an extra value */", ""]
+    for i, g in enumerate(GCB):
+        out.append("#define BUGCB_%-8s (%d)" % (GCB_SHORT[i], i))
+    out.append("")
+    out += two_level("buGrapheme", grapheme_break, WIDTH_TABLE_END, 5, 0)
+    out += ["", "#endif /* BUNITAB_GRAPHEME */", ""]
+    return out
+
+def main():
+    out = ["/*",
+           " * This file was generated by mkunitab.py from the Unicode %s" %
+           unicodedata.unidata_version,
+           " * character database.  Do not edit it by hand; run \"make tables\".",
+           " */",
+           "",
+           "#ifndef BSTRLIB_UNICODE_TABLES",
+           "#define BSTRLIB_UNICODE_TABLES",
+           ""]
+    out += gen_fold()
+    out += gen_norm()
+    out += gen_width()
+    out += gen_grapheme()
+    out += ["#endif /* BSTRLIB_UNICODE_TABLES */"]
+    sys.stdout.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -396,6 +396,971 @@ int ret = 0;
 	return ret;
 }
 
+int test15 (void) {
+struct tagbstring t = bsStatic ("alpha,Beta,,gamma,BETA,alphabet");
+struct tagbstring f0 = bsStatic ("alpha");
+struct tagbstring f1 = bsStatic ("ag");
+struct tagbstring f2 = bsStatic ("beta");
+struct tagbstring e;
+struct bstrList * sl, * sl2;
+struct bstrColumn * c;
+bstring b;
+int sel[8], n, i, ret = 0;
+
+	printf ("TEST: struct bstrColumn functions.\n");
+
+	sl = bsplit (&t, ',');
+	c = bstrColumnFromList (sl);
+	ret += NULL == c;
+	ret += 6 != c->qty;
+	ret += 0 != c->offsets[0];
+	ret += 26 != c->offsets[6];
+	ret += 26 != c->blob->slen;
+	ret += BSTR_OK != bstrColumnEntry (&e, c, 1);
+	ret += 1 != biseqcstr (&e, "Beta");
+	ret += 0 == biswriteprotected (e);
+	ret += BSTR_OK != bstrColumnEntry (&e, c, 2);
+	ret += 0 != e.slen;
+	ret += BSTR_ERR != bstrColumnEntry (&e, c, 6);
+
+	n = bstrColumnSelectInstr (c, &f0, sel);
+	ret += 2 != n || 0 != sel[0] || 5 != sel[1];
+	/* "ag" only occurs across the boundary of "Beta" and "gamma" */
+	n = bstrColumnSelectInstr (c, &f1, sel);
+	ret += 0 != n;
+	n = bstrColumnSelectEqCaseless (c, &f2, sel);
+	ret += 2 != n || 1 != sel[0] || 4 != sel[1];
+
+	ret += BSTR_OK != bstrColumnAppend (c, &f1);
+	ret += BSTR_OK != bstrColumnEntry (&e, c, 0);
+	ret += BSTR_OK != bstrColumnAppend (c, &e);
+	ret += 8 != c->qty;
+	ret += BSTR_OK != bstrColumnEntry (&e, c, 7);
+	ret += 1 != biseqcstr (&e, "alpha");
+
+	sl2 = bstrColumnToList (c);
+	ret += NULL == sl2 || 8 != sl2->qty;
+	for (i = 0; i < sl->qty; i++) ret += 1 != biseq (sl->entry[i], sl2->entry[i]);
+	ret += 1 != biseqcstr (sl2->entry[6], "ag");
+	b = bjoinStatic (sl2, "|");
+	ret += 1 != biseqcstr (b, "alpha|Beta||gamma|BETA|alphabet|ag|alpha");
+
+	bdestroy (b);
+	bstrListDestroy (sl2);
+	bstrListDestroy (sl);
+	ret += BSTR_OK != bstrColumnDestroy (c);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test16 (void) {
+struct tagbstring t = bsStatic ("a,,bcd,\0e");
+struct bwriteStream * ws;
+struct bstrList * sl, * sl2;
+bstring b;
+int i, ret = 0;
+
+	printf ("TEST: bwsWriteBstrList and bstrListRefSerial.\n");
+
+	sl = bsplit (&t, ',');
+	ws = bwsOpen ((bNwrite) tWrite, (b = bfromcstr ("")));
+	bwsBuffLength (ws, 8);
+	ret += BSTR_OK != bwsWriteBstrList (ws, sl);
+	ret += b != bwsClose (ws);
+	ret += 16 + 4 * 5 + 10 != b->slen;
+
+	sl2 = bstrListRefSerial (b->data, b->slen);
+	ret += NULL == sl2;
+	ret += sl->qty != sl2->qty;
+	for (i = 0; i < sl->qty; i++) {
+		ret += 1 != biseq (sl->entry[i], sl2->entry[i]);
+		ret += 0 == biswriteprotected (*sl2->entry[i]);
+		ret += '\0' != sl2->entry[i]->data[sl2->entry[i]->slen];
+		ret += b->data > sl2->entry[i]->data;
+		ret += b->data + b->slen <= sl2->entry[i]->data;
+	}
+	ret += BSTR_OK != bstrListDestroy (sl2);
+
+	/* Truncated or damaged input is rejected */
+	ret += NULL != bstrListRefSerial (b->data, b->slen - 1);
+	b->data[b->slen - 1] = 'x';
+	ret += NULL != bstrListRefSerial (b->data, b->slen);
+	b->data[b->slen - 1] = '\0';
+	b->data[16 + 4 * 2] = 0;
+	ret += NULL != bstrListRefSerial (b->data, b->slen);
+	b->data[4] = 2;
+	ret += NULL != bstrListRefSerial (b->data, b->slen);
+	bstrListDestroy (sl);
+
+	/* The empty list */
+	sl = bstrListCreate ();
+	ws = bwsOpen ((bNwrite) tWrite, (b->slen = 0, b));
+	ret += BSTR_OK != bwsWriteBstrList (ws, sl);
+	bwsClose (ws);
+	sl2 = bstrListRefSerial (b->data, b->slen);
+	ret += NULL == sl2 || 0 != sl2->qty;
+	bstrListDestroy (sl2);
+	bstrListDestroy (sl);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test17 (void) {
+struct tagbstring t = bsStatic ("  Hello World \n|ABCDEFGHIJKLMNOPQRSTUVWXYZ[@`{ 0123|\t\t||x|  a.b.a  ");
+struct tagbstring f = bsStatic ("a");
+struct tagbstring r = bsStatic ("<A>");
+struct bstrList * sl, * sl2;
+bstring b;
+int i, ret = 0;
+
+	printf ("TEST: Bulk bstrList transformations.\n");
+
+	sl = bsplit (&t, '|');
+	sl2 = bsplit (&t, '|');
+	ret += BSTR_OK != bstrListToLower (sl);
+	for (i = 0; i < sl2->qty; i++) btolower (sl2->entry[i]);
+	for (i = 0; i < sl2->qty; i++) ret += 1 != biseq (sl->entry[i], sl2->entry[i]);
+	ret += BSTR_OK != bstrListToUpper (sl);
+	for (i = 0; i < sl2->qty; i++) btoupper (sl2->entry[i]);
+	for (i = 0; i < sl2->qty; i++) ret += 1 != biseq (sl->entry[i], sl2->entry[i]);
+	ret += BSTR_OK != bstrListTrimws (sl);
+	for (i = 0; i < sl2->qty; i++) btrimws (sl2->entry[i]);
+	for (i = 0; i < sl2->qty; i++) {
+		ret += 1 != biseq (sl->entry[i], sl2->entry[i]);
+		ret += '\0' != sl->entry[i]->data[sl->entry[i]->slen];
+	}
+	ret += BSTR_OK != bstrListToLower (sl);
+	ret += BSTR_OK != bstrListFindReplace (sl, &f, &r);
+	b = bjoinStatic (sl, "|");
+	ret += 1 != biseqcstr (b, "hello world|<A>bcdefghijklmnopqrstuvwxyz[@`{ 0123|||x|<A>.b.<A>");
+	bdestroy (b);
+
+	/* find aliased to an entry of the list */
+	ret += BSTR_OK != bstrListFindReplace (sl, sl->entry[4], &f);
+	ret += 1 != biseqcstr (sl->entry[4], "a");
+
+	/* A write protected entry rejects the whole operation */
+	bwriteprotect (*sl->entry[0]);
+	ret += BSTR_ERR != bstrListToUpper (sl);
+	ret += 1 != biseqcstr (sl->entry[1], "<A>bcdefghijklmnopqrstuvwayz[@`{ 0123");
+	bwriteallow (*sl->entry[0]);
+
+	bstrListDestroy (sl);
+	bstrListDestroy (sl2);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+static int test18_depth = 0, test18_nested = 0;
+
+static int test18_exec (void * ctx, bNjob job, void * parm, int qty) {
+int i;
+	(*(int *) ctx)++;
+	if (test18_depth++) test18_nested++;
+	for (i = qty - 1; i >= 0; i--) job (parm, i);
+	test18_depth--;
+	return 0;
+}
+
+int test18 (void) {
+struct tagbstring t = bsStatic ("  Some Mixed Case Entry ");
+struct tagbstring f = bsStatic ("e");
+struct tagbstring r = bsStatic ("EE");
+struct bstrList * sl;
+bstring b;
+int calls = 0, i, ret = 0;
+
+	printf ("TEST: Bulk bstrList transformations with an executor.\n");
+
+	sl = bstrListCreate ();
+	bstrListAlloc (sl, 5000);
+	for (i = 0; i < 5000; i++) {
+		sl->entry[i] = bmidstr (&t, 0, i % (t.slen + 1));
+		sl->qty++;
+	}
+
+	ret += BSTR_OK != bsetexecutor (test18_exec, &calls, 4);
+	ret += BSTR_OK != bstrListTrimws (sl);
+	ret += BSTR_OK != bstrListToLower (sl);
+	ret += BSTR_OK != bstrListFindReplace (sl, &f, &r);
+	ret += 3 != calls;
+	ret += BSTR_OK != bsetexecutor (NULL, NULL, 0);
+
+	for (i = 0; i < 5000; i++) {
+		b = bmidstr (&t, 0, i % (t.slen + 1));
+		btrimws (b);
+		btolower (b);
+		bfindreplace (b, &f, &r, 0);
+		ret += 1 != biseq (b, sl->entry[i]);
+		bdestroy (b);
+	}
+	bstrListDestroy (sl);
+
+	/* An entry long enough for bfindreplace to use bexecute itself does not
+	   reenter the executor */
+	sl = bstrListCreate ();
+	bstrListAlloc (sl, 1024);
+	for (i = 0; i < 1024; i++) {
+		sl->entry[i] = bmidstr (&t, 0, i % (t.slen + 1));
+		sl->qty++;
+	}
+	for (i = 0; i < 14; i++) bconcat (sl->entry[1023], sl->entry[1023]);
+	b = bstrcpy (sl->entry[1023]);
+	calls = 0;
+	ret += BSTR_OK != bsetexecutor (test18_exec, &calls, 4);
+	ret += BSTR_OK != bstrListFindReplace (sl, &f, &r);
+	ret += 1 != calls || 0 != test18_nested;
+	ret += BSTR_OK != bfindreplace (b, &f, &r, 0);
+	ret += 1 >= calls;
+	ret += BSTR_OK != bsetexecutor (NULL, NULL, 0);
+	ret += 1 != biseq (b, sl->entry[1023]);
+	bdestroy (b);
+	bstrListDestroy (sl);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+static int test19_distance (const_bstring a, const_bstring b) {
+int d[128], i, j, prev, t, v;
+
+	for (j = 0; j <= b->slen; j++) d[j] = j;
+	for (i = 1; i <= a->slen; i++) {
+		prev = d[0];
+		d[0] = i;
+		for (j = 1; j <= b->slen; j++) {
+			t = d[j];
+			v = prev + (a->data[i-1] != b->data[j-1]);
+			if (d[j] + 1 < v) v = d[j] + 1;
+			if (d[j-1] + 1 < v) v = d[j-1] + 1;
+			d[j] = v;
+			prev = t;
+		}
+	}
+	return d[b->slen];
+}
+
+int test19 (void) {
+struct tagbstring t0 = bsStatic ("kitten");
+struct tagbstring t1 = bsStatic ("sitting");
+struct tagbstring t2 = bsStatic ("");
+struct tagbstring t3 = bsStatic ("the quick brown fox jumps over the lazy dog");
+struct tagbstring t4 = bsStatic ("quikc");
+struct tagbstring t5 = bsStatic ("lazy");
+bstring a, b;
+int i, j, d, ret = 0;
+
+	printf ("TEST: Approximate matching.\n");
+
+	ret += 3 != bLevenshtein (&t0, &t1);
+	ret += 3 != bLevenshtein (&t1, &t0);
+	ret += 6 != bLevenshtein (&t0, &t2);
+	ret += 0 != bLevenshtein (&t2, &t2);
+	ret += 0 != bLevenshtein (&t3, &t3);
+	ret += 3 != bLevenshteinMax (&t0, &t1, 3);
+	ret += 3 != bLevenshteinMax (&t0, &t1, 2);
+	ret += 2 != bLevenshteinMax (&t3, &t0, 1);
+	ret += BSTR_ERR != bLevenshtein (NULL, &t0);
+
+	/* Patterns longer than a machine word take several blocks */
+	a = bfromcstr ("");
+	b = bfromcstr ("");
+	for (i = 0; i < 120; i++) {
+		bconchar (a, (char) ('a' + (i * 7) % 5));
+		bconchar (b, (char) ('a' + (i * 11) % 4));
+	}
+	for (i = 0; i < 120; i += 17) {
+		for (j = 0; j < 120; j += 23) {
+			struct tagbstring x, y;
+			bmid2tbstr (x, a, i, 120);
+			bmid2tbstr (y, b, 0, j);
+			d = test19_distance (&x, &y);
+			ret += d != bLevenshtein (&x, &y);
+			ret += d != bLevenshtein (&y, &x);
+			ret += (d > 10 ? 11 : d) != bLevenshteinMax (&y, &x, 10);
+		}
+	}
+	bdestroy (a);
+	bdestroy (b);
+
+	ret +=  4 != binstrfuzzy (&t3, 0, &t4, 1);
+	ret +=  4 != binstrfuzzy (&t3, 0, &t4, 2);
+	ret += BSTR_ERR != binstrfuzzy (&t3, 0, &t4, 0);
+	ret += 35 != binstrfuzzy (&t3, 0, &t5, 0);
+	ret += 35 != binstrfuzzy (&t3, 10, &t5, 1);
+	ret += 36 != binstrfuzzy (&t3, 36, &t5, 1);
+	ret += BSTR_ERR != binstrfuzzy (&t3, 38, &t5, 1);
+	ret +=  7 != binstrfuzzy (&t3, 7, &t2, 0);
+	ret += BSTR_ERR != binstrfuzzy (&t3, -1, &t5, 1);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test20 (void) {
+struct tagbstring t0 = bsStatic ("host = a\nport = 80\nuser = x\nmode = 1\n");
+struct tagbstring t1 = bsStatic ("host = b\nport = 80\nmode = 1\nlog = on\n");
+struct tagbstring t2 = bsStatic ("ABCABBA");
+struct tagbstring t3 = bsStatic ("CBABAC");
+struct bstrList * sl0, * sl1;
+struct bDiff * d;
+bstring b;
+int i, n, ret = 0;
+
+	printf ("TEST: Edit scripts.\n");
+
+	d = bDiffBytes (&t2, &t3);
+	ret += NULL == d;
+	if (d) {
+		for (n = i = 0; i < d->qty; i++) n += d->edit[i].alen + d->edit[i].blen;
+		ret += 5 != n;
+		b = bstrcpy (&t2);
+		ret += BSTR_OK != bDiffApply (b, d);
+		ret += 1 != biseq (b, &t3);
+		bdestroy (b);
+		bDiffDestroy (d);
+	}
+
+	sl0 = bsplit (&t0, '\n');
+	sl1 = bsplit (&t1, '\n');
+	d = bDiffLines (sl0, sl1);
+	ret += NULL == d;
+	if (d) {
+		ret += 3 != d->qty;
+		ret += 0 != d->edit[0].apos || 1 != d->edit[0].alen || 1 != d->edit[0].blen;
+		ret += 2 != d->edit[1].apos || 1 != d->edit[1].alen || 0 != d->edit[1].blen;
+		ret += 4 != d->edit[2].apos || 0 != d->edit[2].alen || 1 != d->edit[2].blen;
+		ret += 2 != d->data->qty || 1 != biseqcstr (d->data->entry[1], "log = on");
+		b = bstrcpy (&t0);
+		ret += BSTR_ERR != bDiffApply (b, d);
+		bdestroy (b);
+		ret += BSTR_OK != bDiffApplyList (sl0, d);
+		b = bjoinStatic (sl0, "\n");
+		ret += 1 != biseq (b, &t1);
+		bdestroy (b);
+		bDiffDestroy (d);
+	}
+	bstrListDestroy (sl0);
+	bstrListDestroy (sl1);
+
+	d = bDiffBytes (&t2, &t2);
+	ret += NULL == d || 0 != d->qty;
+	bDiffDestroy (d);
+	ret += NULL != bDiffBytes (NULL, &t2);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+struct test21_ctx {
+	bstring cat;
+	int qty, bad;
+	int len[4];
+};
+
+static int test21_cb (void * parm, const unsigned char * data, int len, const unsigned char * digest) {
+struct test21_ctx * c = (struct test21_ctx *) parm;
+unsigned char d[32];
+
+	bSha256 (data, len, d);
+	c->bad += 0 != memcmp (d, digest, 32);
+	c->bad += (len < 1024 || len > 32768) && c->cat->slen + len < 300000;
+	bcatblk (c->cat, data, len);
+	if (c->qty < 4) c->len[c->qty] = len;
+	c->qty++;
+	return 0;
+}
+
+int test21 (void) {
+struct tagbstring t = bsStatic ("abc");
+static const unsigned char dabc[32] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+struct test21_ctx c;
+struct bStream * s;
+unsigned char d[32];
+unsigned long h[64], v, x;
+bstring b;
+int i, j, ret = 0;
+
+	printf ("TEST: Content defined chunking and hashing.\n");
+
+	ret += BSTR_OK != bSha256 (t.data, t.slen, d);
+	ret += 0 != memcmp (d, dabc, 32);
+
+	b = bfromcstralloc (300000, "");
+	for (x = 1, i = 0; i < 300000; i++) {
+		x = (x * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+		bconchar (b, (char) (x >> 16));
+	}
+	c.cat = bfromcstr ("");
+	c.qty = c.bad = 0;
+	s = bsFromBstr (b);
+	i = bsChunk (s, 1024, 4096, 32768, test21_cb, &c);
+	ret += i != c.qty || i < 10;
+	/* Boundaries do not depend on the platform */
+	ret += c.len[0] != 4295 || c.len[1] != 4633 || c.len[2] != 2615 || c.len[3] != 4895;
+	bsclose (s);
+	ret += c.bad;
+	ret += 1 != biseq (c.cat, b);
+	bdestroy (c.cat);
+	ret += BSTR_ERR != bsChunk (NULL, 0, 0, 0, test21_cb, &c);
+
+	ret += 64 != bRollingHash (b, 16, h, 64);
+	for (i = 0; i < 64; i++) {
+		for (v = 0, j = 0; j < 16; j++) v = (v * 0x01000193UL + b->data[i + j]) & 0xFFFFFFFFUL;
+		ret += v != h[i];
+	}
+	ret += 0 != bRollingHash (&t, 4, h, 64);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test22 (void) {
+struct tagbstring t = bsStatic ("123456789");
+struct tagbstring e = bsStatic ("");
+struct tagbstring a = bsStatic ("abc");
+struct bStream * s, * f;
+struct bwriteStream * ws;
+unsigned long c, sc, wc, x;
+bstring b, o;
+int i, ret = 0;
+
+	printf ("TEST: Checksums.\n");
+
+	ret += 0xE3069283UL != bcrc32c (&t);
+	ret += 0 != bcrc32c (&e);
+	ret += 0 != bcrc32c (NULL);
+	ret += 0xEF46DB3751D8E999ULL != bHash64 (&e, 0);
+	ret += 0x44BC2CF5AD770999ULL != bHash64 (&a, 0);
+	ret += bHash64 (&t, 0) == bHash64 (&t, 1);
+
+	b = bfromcstralloc (5000, "");
+	for (x = 1, i = 0; i < 5000; i++) {
+		x = (x * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+		bconchar (b, (char) (x >> 16));
+	}
+	c = bcrc32c (b);
+	for (i = 0; i < b->slen; i += 371) {
+		ret += c != bcrc32cblk (bcrc32cblk (0, b->data, i), b->data + i, b->slen - i);
+	}
+
+	/* Checksum while reading */
+	sc = 0;
+	s = bsFromBstr (b);
+	f = bsCrc32c (s, &sc);
+	o = bfromcstr ("");
+	while (BSTR_ERR != bsreada (o, f, 333)) ;
+	bsclose (f);
+	bsclose (s);
+	ret += 1 != biseq (o, b);
+	ret += c != sc;
+
+	/* Checksum while writing */
+	wc = 0;
+	o->slen = 0;
+	ws = bwsOpen ((bNwrite) tWrite, o);
+	ret += BSTR_OK != bwsCrc32c (ws, &wc);
+	for (i = 0; i < b->slen; i += 700) {
+		bwsWriteBlk (ws, b->data + i, (b->slen - i < 700) ? b->slen - i : 700);
+	}
+	bwsClose (ws);
+	ret += 1 != biseq (o, b);
+	ret += c != wc;
+
+	/* Data buffered before attachment, or written after detachment, is not
+	   counted */
+	wc = 0;
+	o->slen = 0;
+	ws = bwsOpen ((bNwrite) tWrite, o);
+	bwsWriteBlk (ws, "head", 4);
+	ret += BSTR_OK != bwsCrc32c (ws, &wc);
+	ret += 4 != o->slen;
+	bwsWriteBlk (ws, b->data, b->slen);
+	ret += BSTR_OK != bwsCrc32c (ws, NULL);
+	bwsWriteBlk (ws, "tail", 4);
+	bwsClose (ws);
+	ret += 8 + b->slen != o->slen;
+	ret += c != wc;
+
+	bdestroy (o);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test23 (void) {
+struct tagbstring t = bsStatic ("\tHello,\r\n\r\n  World!!\x01\r\n");
+struct tagbstring cr = bsStatic ("\r");
+struct tagbstring lo = bsStatic ("a-z");
+struct tagbstring up = bsStatic ("A-Z");
+struct tagbstring ws = bsStatic ("\t\x01 ");
+struct tagbstring sp = bsStatic (" ");
+struct tagbstring bad = bsStatic ("z-a");
+struct bTrTable tr;
+struct bStream * s, * f;
+bstring b, o;
+int ret = 0;
+
+	printf ("TEST: Byte translation tables.\n");
+
+	ret += BSTR_OK != bTrCompile (&tr, &lo, &up, &cr, NULL);
+	b = bstrcpy (&t);
+	ret += BSTR_OK != bTranslate (b, &tr);
+	ret += 1 != biseqcstr (b, "\tHELLO,\n\n  WORLD!!\x01\n");
+	ret += BSTR_ERR != bTranslate (&t, &tr);
+
+	ret += BSTR_OK != bTrCompile (&tr, &ws, &sp, NULL, &sp);
+	ret += BSTR_OK != bTranslate (b, &tr);
+	ret += 1 != biseqcstr (b, " HELLO,\n\n WORLD!! \n");
+	bdestroy (b);
+
+	ret += BSTR_ERR != bTrCompile (&tr, &bad, &sp, NULL, NULL);
+	ret += BSTR_ERR != bTrCompile (&tr, &lo, NULL, NULL, NULL);
+
+	/* As a stream filter, squeezing continues across reads */
+	ret += BSTR_OK != bTrCompile (&tr, NULL, NULL, &cr, &sp);
+	b = bfromcstr ("a  \r\n   b\r\r\r");
+	bReplicate (b, 500);
+	s = bsFromBstr (b);
+	bsbufflength (s, 7);
+	f = bsTranslate (s, &tr);
+	o = bfromcstr ("");
+	while (BSTR_ERR != bsreada (o, f, 5)) ;
+	bsclose (f);
+	bsclose (s);
+	bTranslate (b, &tr);
+	ret += 1 != biseq (o, b);
+	ret += 2500 != b->slen;
+	bdestroy (o);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+/* A core stream which never ends and never sends a '\n', counting what it
+   has served */
+static size_t test24_read (void * buff, size_t elsize, size_t nelem, void * parm) {
+	memset (buff, 'a', elsize * nelem);
+	*(size_t *) parm += elsize * nelem;
+	return nelem;
+}
+
+int test24 (void) {
+struct tagbstring req = bsStatic ("GET /a/b?c=d HTTP/1.1\r\nHost: example.com\r\n"
+                                  "X-Empty:\r\nAccept: \t*/* \r\nx-two: 1\r\nX-Two:2\r\n\r\nBODY");
+struct tagbstring host = bsStatic ("HOST");
+struct tagbstring two = bsStatic ("X-TWO");
+struct tagbstring none = bsStatic ("Cookie");
+struct tagbstring bad = bsStatic ("GET / HTTP/1.1\r\nNo Colon\r\n\r\n");
+struct tagbstring fold = bsStatic ("GET / HTTP/1.1\nA: b\n c\n\n");
+struct bHttpRequest r;
+struct bStream * s;
+bstring b;
+size_t sz;
+int i, ret = 0;
+
+	printf ("TEST: HTTP request heads.\n");
+
+	/* Fed a byte at a time, the head is only reported once complete */
+	b = bfromcstr ("");
+	ret += BSTR_OK != bHttpInit (&r);
+	for (i = 0; i < req.slen; i++) {
+		bconchar (b, (char) req.data[i]);
+		if (0 != bHttpParse (&r, b)) break;
+	}
+	ret += req.slen - 4 != b->slen;
+	ret += b->slen != bHttpParse (&r, b);
+	ret += 1 != biseqcstr (&r.method, "GET");
+	ret += 1 != biseqcstr (&r.path, "/a/b?c=d");
+	ret += 1 != r.minor || 5 != r.qty;
+	ret += 0 != bHttpFind (&r, &host, 0);
+	ret += 1 != biseqcstr (&r.header[0].value, "example.com");
+	ret += 0 != r.header[1].value.slen;
+	ret += 1 != biseqcstr (&r.header[2].value, "*/*");
+	ret += 3 != (i = bHttpFind (&r, &two, 0));
+	ret += 4 != bHttpFind (&r, &two, i + 1);
+	ret += 1 != biseqcstr (&r.header[4].value, "2");
+	ret += BSTR_ERR != bHttpFind (&r, &none, 0);
+
+	bHttpInit (&r);
+	ret += BSTR_ERR != bHttpParse (&r, &bad);
+	bHttpInit (&r);
+	ret += BSTR_ERR != bHttpParse (&r, &fold);
+
+	/* From a stream, the body is left unread */
+	s = bsFromBstr (&req);
+	bsbufflength (s, 5);
+	ret += req.slen - 4 != bsHttpRead (&r, b, s, 1000);
+	ret += 5 != r.qty;
+	ret += 1 != biseqcstr (&r.header[0].name, "Host");
+	ret += BSTR_OK != bsread (b, s, 100);
+	ret += 1 != biseqcstr (b, "BODY");
+	ret += 0 != bsHttpRead (&r, b, s, 1000);
+	bsclose (s);
+
+	s = bsFromBstr (&req);
+	ret += BSTR_ERR != bsHttpRead (&r, b, s, 20);
+	bsclose (s);
+
+	/* A head whose last line crosses maxLen is rejected, before or after
+	   the rest of it arrives */
+	for (i = 1; i <= 64; i *= 4) {
+		s = bsFromBstr (&req);
+		bsbufflength (s, i);
+		ret += BSTR_ERR != bsHttpRead (&r, b, s, req.slen - 5);
+		bsclose (s);
+		s = bsFromBstr (&req);
+		bsbufflength (s, i);
+		ret += BSTR_ERR != bsHttpRead (&r, b, s, req.slen - 6);
+		bsclose (s);
+		s = bsFromBstr (&req);
+		bsbufflength (s, i);
+		ret += req.slen - 4 != bsHttpRead (&r, b, s, req.slen - 4);
+		ret += BSTR_OK != bsread (b, s, 100);
+		ret += 1 != biseqcstr (b, "BODY");
+		bsclose (s);
+	}
+
+	/* A peer which never sends a '\n' costs no more than maxLen bytes */
+	sz = 0;
+	s = bsopen ((bNread) test24_read, &sz);
+	bsbufflength (s, 4096);
+	ret += BSTR_ERR != bsHttpRead (&r, b, s, 100);
+	ret += sz > 100 || b->slen > 100;
+	bsclose (s);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+struct test25_ctx {
+	bstring log;
+	int headers;
+};
+
+static int test25_headers (void * parm, int part, const struct bHttpHeader * h, int qty) {
+struct test25_ctx * c = (struct test25_ctx *) parm;
+	c->headers += qty;
+	if (0 > bformata (c->log, "[%d:", part)) return BSTR_ERR;
+	return (qty > 0) ? bconcat (c->log, &h[0].value) : 0;
+}
+
+static int test25_data (void * parm, int part, const unsigned char * blk, int len) {
+struct test25_ctx * c = (struct test25_ctx *) parm;
+	(void) part;
+	return bcatblk (c->log, blk, len);
+}
+
+static int test25_end (void * parm, int part) {
+struct test25_ctx * c = (struct test25_ctx *) parm;
+	(void) part;
+	return bconchar (c->log, ']');
+}
+
+int test25 (void) {
+struct tagbstring ct = bsStatic ("multipart/form-data; charset=\"a;b\"; Boundary=\"xyz--\"");
+struct tagbstring body = bsStatic ("preamble\r\n--xyz--\r\n"
+                                   "Content-Type: text/plain\r\n\r\nline 1\r\n--xy\r\nline 2"
+                                   "\r\n--xyz-- \t\r\nContent-Transfer-Encoding: BASE64\r\n\r\n"
+                                   "aGVs\r\nbG8=\r\n--xyz----\r\nepilogue");
+struct tagbstring t;
+struct test25_ctx c;
+struct bMultipartCb cb;
+struct bStream * s;
+bstring b;
+int ret = 0;
+
+	printf ("TEST: MIME multipart bodies.\n");
+
+	ret += BSTR_OK != bMultipartBoundary (&t, &ct);
+	ret += 1 != biseqcstr (&t, "xyz--");
+	ret += BSTR_ERR != bMultipartBoundary (&t, &body);
+
+	c.log = bfromcstr ("");
+	c.headers = 0;
+	cb.headers = test25_headers;
+	cb.data = test25_data;
+	cb.end = test25_end;
+	cb.parm = &c;
+	s = bsFromBstr (&body);
+	bsbufflength (s, 3);
+	ret += 2 != bsMultipart (s, &t, 1, &cb);
+	ret += 1 != biseqcstr (c.log, "[0:text/plainline 1\r\n--xy\r\nline 2][1:BASE64hello]");
+	ret += 2 != c.headers;
+	b = bfromcstr ("");
+	bsread (b, s, 100);
+	ret += 1 != biseqcstr (b, "\r\nepilogue");
+	bsclose (s);
+
+	/* Without decoding, and with the body cut short */
+	c.log->slen = 0;
+	s = bsFromBstr (&body);
+	ret += 2 != bsMultipart (s, &t, 0, &cb);
+	ret += 1 != biseqcstr (c.log, "[0:text/plainline 1\r\n--xy\r\nline 2][1:BASE64aGVs\r\nbG8=]");
+	bsclose (s);
+	bassignblk (b, body.data, body.slen - 20);
+	s = bsFromBstr (b);
+	ret += BSTR_ERR != bsMultipart (s, &t, 1, &cb);
+	bsclose (s);
+
+	bdestroy (b);
+	bdestroy (c.log);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test26 (void) {
+struct tagbstring plain = bsStatic ("caf\xc3\xa9 = 1 \r\nend\t");
+struct tagbstring soft = bsStatic ("a=3Db=\r\nc =  \r\nd=\ne=zz  \r\n");
+struct tagbstring mp = bsStatic ("--b\r\nContent-Transfer-Encoding: Quoted-Printable\r\n\r\n"
+                                 "x=3D=\r\ny\r\n--b--");
+struct tagbstring bd = bsStatic ("b");
+struct tagbstring sb = bsStatic ("=\r\n");
+struct test25_ctx c;
+struct bMultipartCb cb;
+struct bStream * s, * f;
+bstring b, e, d;
+int i, j, ret = 0;
+
+	printf ("TEST: Quoted-printable.\n");
+
+	e = bQpEncode (&plain);
+	ret += 1 != biseqcstr (e, "caf=C3=A9 =3D 1=20\r\nend=09");
+	d = bQpDecode (e);
+	ret += 1 != biseq (d, &plain);
+	bdestroy (d);
+	bdestroy (e);
+
+	d = bQpDecode (&soft);
+	ret += 1 != biseqcstr (d, "a=bc de=zz\r\n");
+	bdestroy (d);
+
+	/* Long lines get soft line breaks, and streams agree with blocks */
+	b = bfromcstr ("");
+	for (i = 0; i < 300; i++) bconchar (b, (char) ((i % 7) ? 'a' + i % 26 : ' '));
+	e = bQpEncode (b);
+	for (i = j = 0; i < e->slen; i++) {
+		if (e->data[i] == '\n') j = i + 1;
+		else ret += e->data[i] != '\r' && i - j >= 76;
+	}
+	ret += 0 > binstr (e, 0, &sb);
+	s = bsFromBstr (b);
+	bsbufflength (s, 7);
+	f = bsQpEncode (s);
+	d = bfromcstr ("");
+	while (BSTR_ERR != bsreada (d, f, 5)) ;
+	bsclose (f);
+	bsclose (s);
+	ret += 1 != biseq (d, e);
+	s = bsFromBstr (e);
+	bsbufflength (s, 3);
+	f = bsQpDecode (s);
+	d->slen = 0;
+	while (BSTR_ERR != bsreada (d, f, 5)) ;
+	bsclose (f);
+	bsclose (s);
+	ret += 1 != biseq (d, b);
+	bdestroy (d);
+	bdestroy (e);
+	bdestroy (b);
+
+	/* Multipart bodies decode quoted-printable parts */
+	c.log = bfromcstr ("");
+	c.headers = 0;
+	cb.headers = test25_headers;
+	cb.data = test25_data;
+	cb.end = test25_end;
+	cb.parm = &c;
+	s = bsFromBstr (&mp);
+	bsbufflength (s, 2);
+	ret += 1 != bsMultipart (s, &bd, 1, &cb);
+	ret += 1 != biseqcstr (c.log, "[0:Quoted-Printablex=y]");
+	bsclose (s);
+	bdestroy (c.log);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test27 (void) {
+struct tagbstring t = bsStatic ("Hello world");
+struct tagbstring bad0 = bsStatic ("ab=");
+struct tagbstring esc = bsStatic ("\x72\x8f=\x40\r\n==");
+bstring b, e, d;
+int i, j, ret = 0;
+
+	printf ("TEST: yEnc lines and in place decoding.\n");
+
+	/* Without line breaks the output is that of bYEncode */
+	e = bYEncodeLines (&t, 0);
+	b = bYEncode (&t);
+	ret += 1 != biseq (e, b);
+	bdestroy (b);
+
+	/* Every byte value, so the word at a time paths see escapes */
+	b = bfromcstr ("");
+	for (i = 0; i < 1000; i++) bconchar (b, (char) (i * 7 + (i >> 8)));
+	bdestroy (e);
+	e = bYEncodeLines (b, 16);
+	for (i = j = 0; i < e->slen; i++) {
+		if (e->data[i] == '\n') j = i + 1;
+		else if (e->data[i] != '\r') {
+			ret += i - j >= 17;
+			ret += (i == j || e->data[i + 1] == '\r') &&
+			       (e->data[i] == ' ' || e->data[i] == '\t');
+			ret += i == j && e->data[i] == '.';
+		}
+	}
+	d = bYDecode (e);
+	ret += 1 != biseq (d, b);
+	ret += BSTR_OK != bYDecodeInPlace (e);
+	ret += 1 != biseq (e, b);
+	ret += '\0' != e->data[e->slen];
+	bdestroy (d);
+	bdestroy (e);
+	bdestroy (b);
+
+	/* Escapes are honoured, CR/LF dropped, and bad input left alone */
+	b = bstrcpy (&esc);
+	ret += BSTR_OK != bYDecodeInPlace (b);
+	ret += 1 != biseqcstr (b, "He\xd6\xd3");
+	bdestroy (b);
+	ret += NULL != bYDecode (&bad0);
+	b = bstrcpy (&bad0);
+	ret += BSTR_ERR != bYDecodeInPlace (b);
+	ret += 1 != biseq (b, &bad0);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test28 (void) {
+struct tagbstring raw = bsStatic ("say \"hi\"\\\n\x01 caf\xc3\xa9");
+struct tagbstring esc = bsStatic ("say \\\"hi\\\"\\\\\\n\\u0001 caf\xc3\xa9");
+struct tagbstring u = bsStatic ("\\u00e9\\/\\ud83d\\ude00\\ud800x");
+struct tagbstring bad = bsStatic ("ok\\q");
+struct tagbstring doc = bsStatic ("{\"a\\\"{\": [1, \"]\"], \"b\":{}}");
+int expect[] = {0, 1, 6, 7, 9, 11, 13, 15, 16, 17, 19, 21, 22, 23, 24, 25};
+int pos[20];
+bstring b;
+int i, n, ret = 0;
+
+	printf ("TEST: JSON strings.\n");
+
+	b = bfromcstr ("\"");
+	ret += BSTR_OK != bJsonEscape (b, &raw);
+	ret += 1 != biseqcstr (b, "\"say \\\"hi\\\"\\\\\\n\\u0001 caf\xc3\xa9");
+	b->slen = 0;
+	ret += BSTR_OK != bJsonUnescape (b, &esc);
+	ret += 1 != biseq (b, &raw);
+
+	b->slen = 0;
+	ret += BSTR_OK != bJsonUnescape (b, &u);
+	ret += 1 != biseqcstr (b, "\xc3\xa9/\xf0\x9f\x98\x80\xef\xbf\xbdx");
+	ret += BSTR_ERR != bJsonUnescape (b, &bad);
+	ret += 1 != biseqcstr (b, "\xc3\xa9/\xf0\x9f\x98\x80\xef\xbf\xbdx");
+
+	/* Escaping onto itself */
+	ret += BSTR_OK != bassign (b, &raw);
+	ret += BSTR_OK != bJsonEscape (b, b);
+	ret += b->slen != raw.slen + esc.slen;
+	ret += 0 != memcmp (b->data + raw.slen, esc.data, esc.slen);
+	bdestroy (b);
+
+	n = bJsonIndex (&doc, NULL, 0, 0);
+	ret += n != (int) (sizeof (expect) / sizeof (expect[0]));
+	ret += n != bJsonIndex (&doc, pos, 20, 0);
+	for (i = 0; i < n && i < 20; i++) ret += pos[i] != expect[i];
+
+	/* The backslash of the escape, but not the quote it escapes */
+	ret += n + 1 != bJsonIndex (&doc, pos, 20, BJSON_ESCAPES);
+	ret += pos[1] != 1 || pos[2] != 3 || pos[3] != 6;
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test29 (void) {
+struct tagbstring ts = bsStatic ("at 2024-02-29t23:59:60.1234567891-05:30 ok");
+struct tagbstring bad0 = bsStatic ("2023-02-29T00:00:00Z");
+struct tagbstring bad1 = bsStatic ("2024-01-01T00:00:00+24:00");
+struct tagbstring bad2 = bsStatic ("2024-01-01T00:0a:00Z");
+struct bTimeCache c;
+struct bTime t;
+bstring b;
+int i, ret = 0;
+
+	printf ("TEST: RFC3339 timestamps.\n");
+
+	memset (&c, 0, sizeof (c));
+	b = bfromcstralloc (128, "");
+	t.sec = 951782400LL;   /* 2000-02-29T00:00:00Z */
+	t.nsec = 5000000;
+	t.offset = 0;
+	ret += BSTR_OK != bRfc3339Cat (b, &t, 3, &c);
+	ret += 1 != biseqcstr (b, "2000-02-29T00:00:00.005Z");
+	t.sec += 86399;
+	t.offset = -90;
+	ret += BSTR_OK != bRfc3339Cat (b, &t, 0, &c);
+	t.offset = 0;
+	ret += BSTR_OK != bRfc3339Cat (b, &t, 1, &c);
+	ret += 1 != biseqcstr (b, "2000-02-29T00:00:00.005Z2000-02-29T22:29:59-01:302000-02-29T23:59:59.0Z");
+	ret += BSTR_ERR != bRfc3339Cat (b, &t, 10, &c);
+	t.sec = -62167219201LL;
+	ret += BSTR_ERR != bRfc3339Cat (b, &t, 0, NULL);
+
+	ret += 36 != bRfc3339Parse (&t, &ts, 3);
+	ret += t.sec != 1709271000LL || t.nsec != 123456789L || t.offset != -330;
+	ret += BSTR_ERR != bRfc3339Parse (&t, &ts, 2);
+	ret += BSTR_ERR != bRfc3339Parse (&t, &bad0, 0);
+	ret += BSTR_ERR != bRfc3339Parse (&t, &bad1, 0);
+	ret += BSTR_ERR != bRfc3339Parse (&t, &bad2, 0);
+
+	/* Round trip */
+	for (i = 0; i < 50; i++) {
+		struct bTime u;
+		t.sec = -62167219200LL + i * 5068681337LL;
+		t.nsec = i * 19999999L;
+		t.offset = (i % 7 - 3) * 97;
+		b->slen = 0;
+		if (BSTR_OK != bRfc3339Cat (b, &t, 9, &c)) continue;
+		ret += b->slen != bRfc3339Parse (&u, b, 0);
+		ret += u.sec != t.sec || u.nsec != t.nsec || u.offset != t.offset;
+	}
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
 int main () {
 int ret = 0;
 
@@ -416,6 +1381,21 @@ int ret = 0;
 	ret += test12 ();
 	ret += test13 ();
 	ret += test14 ();
+	ret += test15 ();
+	ret += test16 ();
+	ret += test17 ();
+	ret += test18 ();
+	ret += test19 ();
+	ret += test20 ();
+	ret += test21 ();
+	ret += test22 ();
+	ret += test23 ();
+	ret += test24 ();
+	ret += test25 ();
+	ret += test26 ();
+	ret += test27 ();
+	ret += test28 ();
+	ret += test29 ();
 
 	printf ("# test failures: %d\n", ret);
 
@@ -0,0 +1,676 @@
+/*
+ * This source file is part of the bstring string library.  This code was
+ * written by Paul Hsieh in 2002-2015, and is covered by the BSD open source
+ * license. Refer to the accompanying documentation for details on usage and
+ * license.
+ */
+
+/*
+ * testuni.c
+ *
+ * This file is the C unit test for the buniutil and utf8util modules of
+ * Bstrlib.
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include "bstrlib.h"
+#include "buniutil.h"
+
+/* A bStream source reading the content of a tagbstring */
+struct tStrSrc {
+	struct tagbstring t;
+	int pos;
+};
+
+static size_t tStrRead (void * buff, size_t elsize, size_t nelem, void * parm) {
+struct tStrSrc * src = (struct tStrSrc *) parm;
+size_t n;
+
+	if (NULL == buff || NULL == parm || 0 == elsize) return 0;
+	n = (size_t) (src->t.slen - src->pos) / elsize;
+	if (n > nelem) n = nelem;
+	memcpy (buff, src->t.data + src->pos, n * elsize);
+	src->pos += (int) (n * elsize);
+	return n;
+}
+
+static struct bStream * tStrOpen (struct tStrSrc * src, const_bstring b) {
+	src->t = *b;
+	src->pos = 0;
+	return bsopen ((bNread) tStrRead, src);
+}
+
+int test0 (void) {
+struct tagbstring up = bsStatic ("\xce\xa3\xce\xa9\xce\xa3 \xe2\x84\xaa\xe1\xba\x9e \xc8\xba ABC");
+struct tagbstring lo = bsStatic ("\xcf\x83\xcf\x89\xcf\x82 k\xc3\x9f \xe2\xb1\xa5 abc");
+struct tagbstring ss = bsStatic ("stra\xc3\x9f" "e");
+struct tagbstring in = bsStatic ("\xce\xb1\xce\xb2 K\xe2\x84\xaaK \xcf\x82\xce\xa3 \xe1\xba\x9e!");
+struct tagbstring k = bsStatic ("kk");
+struct tagbstring sig = bsStatic ("\xcf\x83\xcf\x83");
+struct tagbstring sz = bsStatic ("\xc3\x9f!");
+struct tagbstring nf = bsStatic ("\xcf\x89");
+struct tagbstring bad = bsStatic ("a\xff" "b");
+struct tagbstring bad2 = bsStatic ("\xff" "B");
+struct tagbstring az = bsStatic ("az");
+struct tagbstring e = bsStatic ("");
+struct tagbstring nul = bsStatic ("\0");
+struct tagbstring u8000 = bsStatic ("\xe8\x80\x80");
+bstring b;
+int ret = 0;
+
+	printf ("TEST: Unicode case folding.\n");
+
+	ret += 0x3C3 != buFoldCodePoint (0x3A3);   /* SIGMA */
+	ret += 0x3C3 != buFoldCodePoint (0x3C2);   /* FINAL SIGMA */
+	ret += 'k' != buFoldCodePoint (0x212A);    /* KELVIN SIGN */
+	ret += 0xDF != buFoldCodePoint (0xDF);     /* SHARP S has only a full folding */
+	ret += 0xDF != buFoldCodePoint (0x1E9E);
+	ret += -1 != buFoldCodePoint (-1);
+	ret += 0x110000L != buFoldCodePoint (0x110000L);
+
+	/* Foldings which are shorter (KELVIN SIGN, CAPITAL SHARP S) and longer
+	   (U+023A to U+2C65) than what they replace */
+	b = bstrcpy (&up);
+	ret += BSTR_OK != buFoldCase (b);
+	ret += 1 != biseqcstr (b, "\xcf\x83\xcf\x89\xcf\x83 k\xc3\x9f \xe2\xb1\xa5 abc");
+	ret += '\0' != b->data[b->slen];
+	bdestroy (b);
+	b = bstrcpy (&bad);
+	ret += BSTR_OK != buFoldCase (b);
+	ret += 1 != biseq (b, &bad);
+	bwriteprotect (*b);
+	ret += BSTR_ERR != buFoldCase (b);
+	bwriteallow (*b);
+	bdestroy (b);
+	ret += BSTR_ERR != buFoldCase (NULL);
+
+	ret += 0 != buStricmp (&up, &lo);
+	ret += 0 != buStricmp (&lo, &up);
+	ret += 0 == buStricmp (&ss, &lo);
+	ret += 1 != buStricmp (&nf, &ss);          /* U+03C9 against 's' */
+	ret += 1 != buStricmp (&up, &k);
+	ret += 1 != buStricmp (&bad, &az);         /* Invalid bytes order last */
+	ret += -1 != buStricmp (&az, &bad);
+	ret += -1 != buStricmp (&nul, &u8000);     /* Differ by exactly 0x8000 */
+	ret += 1 != buStricmp (&u8000, &nul);
+	ret += 1 != buStricmp (&k, &e);
+	ret += -1 != buStricmp (&e, &k);
+	ret += SHRT_MIN != buStricmp (NULL, &lo);
+
+	ret += 5 != buInstrCaseless (&in, 0, &k);
+	ret += 6 != buInstrCaseless (&in, 6, &k);
+	ret += 11 != buInstrCaseless (&in, 0, &sig);
+	ret += 16 != buInstrCaseless (&in, 0, &sz);
+	ret += BSTR_ERR != buInstrCaseless (&in, 12, &sig);
+	ret += 7 != buInstrCaseless (&in, 7, &e);
+	ret += 1 != buInstrCaseless (&bad, 0, &bad2);
+	ret += BSTR_ERR != buInstrCaseless (&in, -1, &k);
+	ret += BSTR_ERR != buInstrCaseless (&in, in.slen + 1, &k);
+	ret += BSTR_ERR != buInstrCaseless (&in, 0, NULL);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+/* Cases from NormalizationTest.txt: the source, its NFC and its NFD */
+static const char * test1_cases[][3] = {
+	/* Canonical ordering of combining marks */
+	{"\xe1\xb8\x8a\xcc\xa3", "\xe1\xb8\x8c\xcc\x87", "D\xcc\xa3\xcc\x87"},
+	{"D\xcc\x87\xcc\xa3", "\xe1\xb8\x8c\xcc\x87", "D\xcc\xa3\xcc\x87"},
+	{"a\xcc\x95\xcc\x80\xd6\xae\xcc\x80" "b", "\xc3\xa0\xd6\xae\xcc\x80\xcc\x95" "b",
+	 "a\xd6\xae\xcc\x80\xcc\x80\xcc\x95" "b"},
+	{"\xc3\x85\xcc\xa7x", "\xc3\x85\xcc\xa7x", "A\xcc\xa7\xcc\x8ax"},
+	/* Hangul syllables */
+	{"\xea\xb0\x81", "\xea\xb0\x81", "\xe1\x84\x80\xe1\x85\xa1\xe1\x86\xa8"},
+	{"\xe1\x84\x80\xe1\x85\xa1\xe1\x86\xa8", "\xea\xb0\x81", "\xe1\x84\x80\xe1\x85\xa1\xe1\x86\xa8"},
+	{"\xed\x93\x9b\xe1\x86\xa8", "\xed\x93\x9b\xe1\x86\xa8",
+	 "\xe1\x84\x91\xe1\x85\xb1\xe1\x86\xb6\xe1\x86\xa8"},
+	/* Singletons and a composition exclusion */
+	{"\xe2\x84\xab", "\xc3\x85", "A\xcc\x8a"},
+	{"\xe2\x84\xa6", "\xce\xa9", "\xce\xa9"},
+	{"\xe0\xa5\x98", "\xe0\xa4\x95\xe0\xa4\xbc", "\xe0\xa4\x95\xe0\xa4\xbc"}
+};
+
+int test1 (void) {
+struct tagbstring t;
+struct tagbstring bad = bsStatic ("e\xcc\x81\xff\xcc\x81" "A\xcc\x8a");
+struct tStrSrc src;
+struct bStream * s, * f;
+bstring b, all, r;
+int i, j, form, ret = 0;
+
+	printf ("TEST: Unicode normalization.\n");
+
+	all = bfromcstr ("");
+	for (i = 0; i < (int) (sizeof (test1_cases) / sizeof (test1_cases[0])); i++) {
+		for (form = UTF8_NFC; form <= UTF8_NFD; form++) {
+			btfromcstr (t, test1_cases[i][0]);
+			b = bstrcpy (&t);
+			ret += BSTR_OK != buNormalize (b, form);
+			ret += 1 != biseqcstr (b, test1_cases[i][1 + form]);
+			ret += 1 != buIsNormalized (b, form);
+			ret += (int) (0 == strcmp (test1_cases[i][0], test1_cases[i][1 + form]))
+			       != buIsNormalized (&t, form);
+			/* Each normalization form is stable under the other's
+			   normalization followed by its own */
+			ret += BSTR_OK != buNormalize (b, !form);
+			ret += 1 != biseqcstr (b, test1_cases[i][2 - form]);
+			bdestroy (b);
+		}
+		bcatcstr (all, test1_cases[i][0]);
+		bconchar (all, ' ');
+	}
+
+	/* Invalid bytes are passed through; a mark after one does not combine */
+	b = bstrcpy (&bad);
+	ret += 0 != buIsNormalized (b, UTF8_NFC);
+	ret += BSTR_OK != buNormalize (b, UTF8_NFC);
+	ret += 1 != biseqcstr (b, "\xc3\xa9\xff\xcc\x81\xc3\x85");
+	bdestroy (b);
+	bconcat (all, &bad);
+
+	/* Streams agree with blocks, even when read a byte at a time */
+	for (form = UTF8_NFC; form <= UTF8_NFD; form++) {
+		r = bstrcpy (all);
+		buNormalize (r, form);
+		for (j = 1; j <= 7; j += 6) {
+			s = tStrOpen (&src, all);
+			bsbufflength (s, j);
+			f = buNormalizeStream (s, form);
+			bsbufflength (f, j);
+			b = bfromcstr ("");
+			while (BSTR_ERR != bsreada (b, f, j)) ;
+			bsclose (f);
+			bsclose (s);
+			ret += 1 != biseq (b, r);
+			bdestroy (b);
+		}
+		bdestroy (r);
+	}
+	bdestroy (all);
+
+	ret += BSTR_ERR != buIsNormalized (NULL, UTF8_NFC);
+	ret += BSTR_ERR != buIsNormalized (&bad, 2);
+	ret += 0 <= utf8IsNormalized (bad.data, bad.slen, -1);
+	ret += BSTR_ERR != buNormalize (NULL, UTF8_NFD);
+	ret += NULL != buNormalizeStream (NULL, UTF8_NFC);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test2 (void) {
+struct tagbstring piece = bsStatic ("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\x80\xff" "bc");
+struct tagbstring lead = bsStatic ("\x80\x80x\xc3\xa9");
+struct tagbstring euro = bsStatic ("\xe2\x82\xac\xf0\x9f\x98\x80\x80");
+struct buCpIndex * ix[3];
+int cpo[600], cpp[600];
+bstring b, m;
+int i, j, n, ret = 0;
+
+	printf ("TEST: Code point addressing.\n");
+
+	/* Every byte which is not a continuation byte starts a code point, so
+	   stray continuation bytes (the 0x80 after the emoji) join the code
+	   point before them, and 0xFF is one by itself. */
+	b = bfromcstr ("");
+	for (i = 0; i < 40; i++) bconcat (b, &piece);
+	for (n = i = 0; i < b->slen; i++) {
+		if (i == 0 || (b->data[i] & 0xC0) != 0x80) cpo[n++] = i;
+		cpp[i] = n - 1;
+	}
+	cpo[n] = b->slen;
+	cpp[b->slen] = n;
+
+	ix[0] = NULL;
+	ix[1] = buCpIndexCreate (3);
+	ix[2] = buCpIndexCreate (0);
+	for (j = 0; j < 3; j++) {
+		ret += n != buCpLength (b, ix[j]);
+		/* Lookups beyond the index, then back inside it, across the
+		   sampling interval of ix[1] */
+		for (i = n; i >= 0; i -= 7) ret += cpo[i] != buCpOffset (b, ix[j], i);
+		for (i = 0; i <= n; i++) ret += cpo[i] != buCpOffset (b, ix[j], i);
+		for (i = 0; i <= b->slen; i++) ret += cpp[i] != buCpPosition (b, ix[j], i);
+		ret += BSTR_ERR != buCpOffset (b, ix[j], n + 1);
+		ret += BSTR_ERR != buCpOffset (b, ix[j], -1);
+		ret += BSTR_ERR != buCpPosition (b, ix[j], b->slen + 1);
+
+		m = buMidstr (b, ix[j], 7 * 3 + 2, 2);
+		ret += 1 != biseq (m, &euro);
+		bdestroy (m);
+		m = buMidstr (b, ix[j], n - 1, 10);
+		ret += 1 != biseqcstr (m, "c");
+		bdestroy (m);
+		m = buMidstr (b, ix[j], -5, 6);
+		ret += 1 != biseqcstr (m, "a");
+		bdestroy (m);
+		ret += 7 * 5 + 2 != buInstr (b, ix[j], 7 * 5, &euro);
+		ret += BSTR_ERR != buInstr (b, ix[j], n - 2, &euro);
+	}
+
+	/* An index follows changes to the string */
+	bcatcstr (b, "\xc3\xa9z");
+	ret += n + 2 != buCpLength (b, ix[1]);
+	ret += b->slen - 1 != buCpOffset (b, ix[1], n + 1);
+	b->data[2] = 'X';   /* Same data and length: must be invalidated */
+	ret += BSTR_OK != buCpIndexInvalidate (ix[1], 2);
+	ret += n + 3 != buCpLength (b, ix[1]);
+	ret += 3 != buCpOffset (b, ix[1], 3);
+	ret += 3 != buCpPosition (b, ix[1], 4);
+	bdestroy (b);
+
+	/* Stray continuation bytes at the start belong to the first code point */
+	ret += 3 != buCpLength (&lead, ix[1]);
+	ret += 2 != buCpOffset (&lead, ix[1], 1);
+	ret += 0 != buCpPosition (&lead, ix[1], 1);
+	ret += 2 != buCpPosition (&lead, NULL, 4);
+
+	ret += BSTR_OK != buCpIndexDestroy (ix[1]);
+	ret += BSTR_OK != buCpIndexDestroy (ix[2]);
+	ret += BSTR_ERR != buCpIndexDestroy (NULL);
+	ret += BSTR_ERR != buCpLength (NULL, NULL);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test3 (void) {
+struct tagbstring cjk = bsStatic ("\xe4\xb8\xad\xe6\x96\x87 ab");
+struct tagbstring comb = bsStatic ("e\xcc\x81\xcc\xa3x");
+struct tagbstring zw = bsStatic ("a\xe2\x80\x8b" "b\xef\xbb\xbf");
+struct tagbstring ctl = bsStatic ("a\x07\tb\x7f\xc2\x85");
+struct tagbstring fam = bsStatic ("\xf0\x9f\x91\xa8\xe2\x80\x8d\xf0\x9f\x91\xa9\xe2\x80\x8d\xf0\x9f\x91\xa7!");
+struct tagbstring asc = bsStatic ("abcdefg\x7fhijklmnopq\x01rs");
+struct tagbstring vs = bsStatic ("\xe2\x9d\xa4\xef\xb8\x8f\xf0\x9f\x91\x8d\xf0\x9f\x8f\xbd");
+struct tagbstring bad = bsStatic ("\xff\xe4\xb8");
+struct tagbstring e = bsStatic ("");
+bstring b;
+int ret = 0;
+
+	printf ("TEST: Display width.\n");
+
+	ret += 1 != buCodePointWidth ('a');
+	ret += 0 != buCodePointWidth (0x07);
+	ret += 0 != buCodePointWidth (0x7F);
+	ret += 0 != buCodePointWidth (0x85);
+	ret += 2 != buCodePointWidth (0x4E00);
+	ret += 2 != buCodePointWidth (0xAC00);
+	ret += 2 != buCodePointWidth (0xFF21);
+	ret += 2 != buCodePointWidth (0x1F600);
+	ret += 0 != buCodePointWidth (0x0301);
+	ret += 0 != buCodePointWidth (0x200B);
+	ret += 0 != buCodePointWidth (0xFEFF);
+	ret += 0 != buCodePointWidth (0x1160);
+	ret += 0 != buCodePointWidth (0x11A8);
+	ret += 1 != buCodePointWidth (0x00E9);
+
+	ret += 7 != buDisplayWidth (&cjk);
+	ret += 2 != buDisplayWidth (&comb);
+	ret += 2 != buDisplayWidth (&zw);
+	ret += 2 != buDisplayWidth (&ctl);
+	ret += 3 != buDisplayWidth (&fam);
+	ret += 4 != buDisplayWidth (&vs);
+	ret += 19 != buDisplayWidth (&asc);
+	ret += 0 != buDisplayWidth (&e);
+	ret += BSTR_ERR != buDisplayWidth (NULL);
+
+	/* Padding is counted in columns, not bytes */
+	b = bfromcstr ("  \xe4\xb8\xad\xe6\x96\x87   ab ");
+	ret += BSTR_OK != buJustifyRight (b, 9, ' ');
+	ret += 1 != biseqcstr (b, "  \xe4\xb8\xad\xe6\x96\x87 ab");
+	ret += BSTR_OK != buJustifyRight (b, 4, ' ');
+	ret += 1 != biseq (b, &cjk);
+	ret += BSTR_OK != buJustifyCenter (b, 12, ' ');
+	ret += 1 != biseqcstr (b, "   \xe4\xb8\xad\xe6\x96\x87 ab");
+	ret += BSTR_OK != buJustifyCenter (b, 10, ' ');
+	ret += 1 != biseqcstr (b, "  \xe4\xb8\xad\xe6\x96\x87 ab");
+	bdestroy (b);
+
+	b = bfromcstr ("\xe4\xb8\xad\xe6\x96\x87 e\xcc\x81 \xe5\xad\x97");
+	ret += BSTR_OK != buJustifyMargin (b, 13, ' ');
+	ret += 1 != biseqcstr (b, "\xe4\xb8\xad\xe6\x96\x87   e\xcc\x81   \xe5\xad\x97");
+	ret += 13 != buDisplayWidth (b);
+	ret += BSTR_OK != buJustifyMargin (b, 9, ' ');
+	ret += 1 != biseqcstr (b, "\xe4\xb8\xad\xe6\x96\x87 e\xcc\x81 \xe5\xad\x97");
+	bdestroy (b);
+
+	b = bfromcstr ("a-\xe4\xb8\xad");
+	ret += BSTR_OK != buJustifyRight (b, 6, '-');
+	ret += 1 != biseqcstr (b, "--a-\xe4\xb8\xad");
+	ret += BSTR_ERR != buJustifyRight (b, 0, ' ');
+	ret += BSTR_ERR != buJustifyCenter (b, -1, ' ');
+	ret += BSTR_ERR != buJustifyRight (b, 8, 0x80);
+	ret += BSTR_ERR != buJustifyMargin (b, 8, 0xA0);
+	ret += 1 != biseqcstr (b, "--a-\xe4\xb8\xad");
+	bdestroy (b);
+	ret += BSTR_ERR != buJustifyRight (NULL, 8, ' ');
+	ret += BSTR_ERR != buJustifyCenter (&cjk, 8, ' ');
+	ret += BSTR_ERR != buJustifyMargin (NULL, 8, ' ');
+	/* Invalid and truncated bytes are one column each */
+	ret += 3 != buDisplayWidth (&bad);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test4 (void) {
+struct tagbstring bad = bsStatic ("a\xc0\x80" "b\xed\xa0\x80" "c\xe2\x82");
+struct tagbstring good = bsStatic ("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" "abcdefghij");
+bstring b;
+unsigned char * d;
+int n, ret = 0;
+
+	printf ("TEST: UTF-8 sanitizing.\n");
+
+	/* Overlong forms, surrogates and a truncated sequence at the end are
+	   replaced a byte at a time; a one byte errCh is written in place */
+	b = bstrcpy (&bad);
+	d = b->data;
+	n = -1;
+	ret += BSTR_OK != buSanitize (b, '?', &n);
+	ret += 1 != biseqcstr (b, "a??b???c??");
+	ret += 7 != n;
+	ret += d != b->data;
+	bdestroy (b);
+
+	/* Illegal errCh values become U+FFFD */
+	b = bfromcstr ("x\xf4\x90\x80\x80");
+	ret += BSTR_OK != buSanitize (b, -1, &n);
+	ret += 1 != biseqcstr (b, "x\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd");
+	ret += 4 != n;
+	ret += BSTR_OK != buSanitize (b, 0xD800, &n);
+	ret += 0 != n;
+	bdestroy (b);
+
+	b = bfromcstr ("\xff" "a\xe0\x80\xaf");
+	ret += BSTR_OK != buSanitize (b, 0x1F600, &n);
+	ret += 1 != biseqcstr (b, "\xf0\x9f\x98\x80" "a\xf0\x9f\x98\x80\xf0\x9f\x98\x80\xf0\x9f\x98\x80");
+	ret += 4 != n;
+	bdestroy (b);
+
+	/* Bad bytes after a run of ASCII long enough to be read a word at a
+	   time, with no count requested */
+	b = bfromcstr ("abcdefghijklmnop\x80" "qrstuvwxyz\xc3");
+	ret += BSTR_OK != buSanitize (b, 0xE9, NULL);
+	ret += 1 != biseqcstr (b, "abcdefghijklmnop\xc3\xa9qrstuvwxyz\xc3\xa9");
+	bdestroy (b);
+
+	/* Valid content is left as it is */
+	b = bstrcpy (&good);
+	n = -1;
+	ret += BSTR_OK != buSanitize (b, '?', &n);
+	ret += 1 != biseq (b, &good);
+	ret += 0 != n;
+	btrunc (b, 0);
+	ret += BSTR_OK != buSanitize (b, '?', &n);
+	ret += 0 != b->slen;
+	ret += 0 != n;
+	bdestroy (b);
+
+	n = -1;
+	ret += BSTR_ERR != buSanitize (&bad, '?', &n);
+	ret += 0 != n;
+	ret += BSTR_ERR != buSanitize (NULL, '?', &n);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test5 (void) {
+static const cpUcs4 cp1252[32] = {
+	0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+	0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+struct tagbstring euro = bsStatic ("abcdefgh\xe2\x82\xac");
+struct tagbstring mix = bsStatic ("a\xe2\x82\xac" "b\xc4\x80" "c\xff" "d\xc3\xa9");
+struct tStrSrc src;
+struct bStream * s, * f;
+unsigned char e[4];
+bstring b, lat, u[2];
+int i, j, enc, ret = 0;
+
+	printf ("TEST: Latin-1 and CP1252 conversion.\n");
+
+	lat = bfromcstr ("");
+	for (i = 0; i < 256; i++) bconchar (lat, (char) i);
+
+	/* 0x80 to 0x9F: C1 controls in Latin-1, and in CP1252 its characters,
+	   with the five bytes CP1252 leaves undefined kept as C1 controls */
+	for (enc = BU_LATIN1; enc <= BU_CP1252; enc++) {
+		u[enc] = bfromcstr ("");
+		for (i = 0; i < 256; i++) {
+			cpUcs4 c = (enc == BU_CP1252 && i >= 0x80 && i < 0xA0) ? cp1252[i - 0x80] : i;
+			bcatblk (u[enc], e, utf8EncodeCodePoint (c, e));
+		}
+		b = bfromcstr ("");
+		ret += BSTR_OK != buAppendBlkLatin (b, lat->data, lat->slen, enc);
+		ret += 1 != biseq (b, u[enc]);
+		btrunc (b, 0);
+		ret += BSTR_OK != buGetLatin (b, u[enc], enc, -1);
+		ret += 1 != biseq (b, lat);
+		bdestroy (b);
+	}
+
+	/* Unmapped code points and invalid bytes */
+	b = bfromcstr ("<");
+	ret += BSTR_OK != buGetLatin (b, &mix, BU_LATIN1, '?');
+	ret += 1 != biseqcstr (b, "<a?b?c?d\xe9");
+	btrunc (b, 1);
+	ret += BSTR_OK != buGetLatin (b, &mix, BU_CP1252, '?');
+	ret += 1 != biseqcstr (b, "<a\x80" "b?c?d\xe9");
+	btrunc (b, 1);
+	ret += BSTR_ERR != buGetLatin (b, &mix, BU_CP1252, -1);
+	ret += BSTR_ERR != buGetLatin (b, &euro, BU_LATIN1, 0x100);
+	ret += 1 != biseqcstr (b, "<");
+	ret += BSTR_ERR != buGetLatin (b, &mix, 2, '?');
+	ret += BSTR_ERR != buAppendBlkLatin (b, lat->data, -1, BU_LATIN1);
+	ret += BSTR_ERR != buAppendBlkLatin (b, lat->data, 1, 2);
+	ret += 1 != biseqcstr (b, "<");
+	bdestroy (b);
+
+	/* Streams agree with blocks, even when read a byte at a time */
+	for (enc = BU_LATIN1; enc <= BU_CP1252; enc++) {
+		for (j = 1; j <= 7; j += 6) {
+			s = tStrOpen (&src, lat);
+			bsbufflength (s, j);
+			f = buLatinStream (s, enc);
+			bsbufflength (f, j);
+			b = bfromcstr ("");
+			while (BSTR_ERR != bsreada (b, f, j)) ;
+			bsclose (f);
+			bsclose (s);
+			ret += 1 != biseq (b, u[enc]);
+			bdestroy (b);
+
+			s = tStrOpen (&src, u[enc]);
+			bsbufflength (s, j);
+			f = buGetLatinStream (s, enc, -1);
+			bsbufflength (f, j);
+			b = bfromcstr ("");
+			while (BSTR_ERR != bsreada (b, f, j)) ;
+			bsclose (f);
+			bsclose (s);
+			ret += 1 != biseq (b, lat);
+			bdestroy (b);
+		}
+		bdestroy (u[enc]);
+	}
+	bdestroy (lat);
+
+	/* A stream which cannot convert a code point ends after the output for
+	   everything before it */
+	for (j = 1; j <= 64; j *= 4) {
+		s = tStrOpen (&src, &euro);
+		bsbufflength (s, j);
+		f = buGetLatinStream (s, BU_LATIN1, -1);
+		b = bfromcstr ("");
+		while (BSTR_ERR != bsreada (b, f, j)) ;
+		bsclose (f);
+		bsclose (s);
+		ret += 1 != biseqcstr (b, "abcdefgh");
+		bdestroy (b);
+
+		s = tStrOpen (&src, &mix);
+		bsbufflength (s, j);
+		f = buGetLatinStream (s, BU_CP1252, -1);
+		b = bfromcstr ("");
+		while (BSTR_ERR != bsreada (b, f, j)) ;
+		bsclose (f);
+		bsclose (s);
+		ret += 1 != biseqcstr (b, "a\x80" "b");
+		bdestroy (b);
+	}
+
+	ret += NULL != buLatinStream (NULL, BU_LATIN1);
+	s = tStrOpen (&src, &euro);
+	ret += NULL != buGetLatinStream (s, 2, '?');
+	bsclose (s);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test6 (void) {
+static const char * clusters[] = {
+	"a", "\r\n", "e\xcc\x81\xcc\xa3", "\r", "\r\n", "\n", "\r",
+	/* man ZWJ woman ZWJ girl, and a thumbs up with a skin tone modifier */
+	"\xf0\x9f\x91\xa8\xe2\x80\x8d\xf0\x9f\x91\xa9\xe2\x80\x8d\xf0\x9f\x91\xa7",
+	"\xf0\x9f\x91\x8d\xf0\x9f\x8f\xbd",
+	/* Regional indicators pair up: FR, DE, then a lone U */
+	"\xf0\x9f\x87\xab\xf0\x9f\x87\xb7", "\xf0\x9f\x87\xa9\xf0\x9f\x87\xaa",
+	"\xf0\x9f\x87\xba", "z",
+	/* Hangul L V T jamo, LV syllable + T, and an LVT syllable */
+	"\xe1\x84\x80\xe1\x85\xa1\xe1\x86\xa8", "\xea\xb0\x80\xe1\x86\xa8",
+	"\xed\x95\x9c",
+	/* A mark extends an invalid byte but not a control */
+	"\xff\xcc\x81", "\x07", "\xcc\x81", "x", "\x80", "a", "b"
+};
+struct tagbstring ro = bsStatic ("abc");
+int bnd[128];
+bstring b, c;
+int i, j, n, nc, ret = 0;
+
+	printf ("TEST: Grapheme clusters.\n");
+
+	b = bfromcstr ("");
+	nc = (int) (sizeof (clusters) / sizeof (clusters[0]));
+	for (n = i = 0; i < nc; i++) {
+		bnd[n++] = b->slen;
+		bcatcstr (b, clusters[i]);
+	}
+	bnd[n] = b->slen;
+
+	for (j = 0, i = 0; i < b->slen; i = buGraphemeNext (b, i)) {
+		ret += i != bnd[j];
+		j++;
+	}
+	ret += j != n;
+
+	/* Truncation never splits a cluster, wherever the cut falls */
+	for (i = j = 0; i <= b->slen; i++) {
+		if (bnd[j + 1] <= i) j++;
+		c = bstrcpy (b);
+		ret += BSTR_OK != buTruncateGraphemes (c, i);
+		ret += bnd[j] != c->slen;
+		ret += 0 != bstrncmp (b, c, c->slen);
+		bdestroy (c);
+	}
+	c = bstrcpy (b);
+	ret += BSTR_OK != buTruncateGraphemes (c, b->slen + 10);
+	ret += 1 != biseq (b, c);
+	bdestroy (c);
+
+	ret += BSTR_ERR != buGraphemeNext (b, b->slen);
+	ret += BSTR_ERR != buGraphemeNext (b, -1);
+	ret += BSTR_ERR != buGraphemeNext (NULL, 0);
+	ret += BSTR_ERR != buTruncateGraphemes (b, -1);
+	ret += BSTR_ERR != buTruncateGraphemes (NULL, 1);
+	ret += BSTR_ERR != buTruncateGraphemes (&ro, 1);
+	bdestroy (b);
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int test7 (void) {
+struct tagbstring ro = bsStatic ("&amp;");
+bstring b;
+int ret = 0;
+
+	printf ("TEST: Character reference decoding.\n");
+
+	b = bfromcstr ("&lt;p&gt; &amp;&quot;&apos; caf&eacute; &Eacute;&euro;&hearts;&nbsp;.");
+	ret += BSTR_OK != buEntityDecode (b, '?');
+	ret += 1 != biseqcstr (b, "<p> &\"' caf\xc3\xa9 \xc3\x89\xe2\x82\xac\xe2\x99\xa5\xc2\xa0.");
+	bdestroy (b);
+
+	b = bfromcstr ("&#65;&#233;&#0065;&#x20AC;&#X1f600;&#xe9;&#128512;");
+	ret += BSTR_OK != buEntityDecode (b, '?');
+	ret += 1 != biseqcstr (b, "A\xc3\xa9" "A\xe2\x82\xac\xf0\x9f\x98\x80\xc3\xa9\xf0\x9f\x98\x80");
+	bdestroy (b);
+
+	/* Zero, surrogates and values beyond U+10FFFF become errCh */
+	b = bfromcstr ("&#0;|&#xD800;|&#57343;|&#x110000;|&#99999999999999999999;|&#x0;");
+	ret += BSTR_OK != buEntityDecode (b, '?');
+	ret += 1 != biseqcstr (b, "?|?|?|?|?|?");
+	bdestroy (b);
+	b = bfromcstr ("&#0;&#xdfff;");
+	ret += BSTR_OK != buEntityDecode (b, -1);
+	ret += 1 != biseqcstr (b, "\xef\xbf\xbd\xef\xbf\xbd");
+	bdestroy (b);
+
+	/* A 4 byte errCh replacing a 4 byte reference */
+	b = bfromcstr ("a&#0;b&#x110000;");
+	ret += BSTR_OK != buEntityDecode (b, 0x1F600);
+	ret += 1 != biseqcstr (b, "a\xf0\x9f\x98\x80" "b\xf0\x9f\x98\x80");
+	bdestroy (b);
+
+	/* Unterminated, unknown and malformed references are left alone */
+	b = bfromcstr ("&amp &unknown; &AMP; &#; &#x; &#12a; & ; &&amp;&#65");
+	ret += BSTR_OK != buEntityDecode (b, '?');
+	ret += 1 != biseqcstr (b, "&amp &unknown; &AMP; &#; &#x; &#12a; & ; &&&#65");
+	bdestroy (b);
+	b = bfromcstr ("no references");
+	ret += BSTR_OK != buEntityDecode (b, '?');
+	ret += 1 != biseqcstr (b, "no references");
+	bdestroy (b);
+
+	ret += BSTR_ERR != buEntityDecode (&ro, '?');
+	ret += 1 != biseqcstr (&ro, "&amp;");
+	ret += BSTR_ERR != buEntityDecode (NULL, '?');
+
+	printf ("\t# failures: %d\n", ret);
+
+	return ret;
+}
+
+int main () {
+int ret = 0;
+
+	printf ("Direct case testing of buniutil core functions\n");
+
+	ret += test0 ();
+	ret += test1 ();
+	ret += test2 ();
+	ret += test3 ();
+	ret += test4 ();
+	ret += test5 ();
+	ret += test6 ();
+	ret += test7 ();
+
+	printf ("# test failures: %d\n", ret);
+
+	return 0;
+}
@@ -12,8 +12,12 @@
  * is just an generic module for implementing utf8 utility functions.
  */
 
+#include <string.h>
 #include "utf8util.h"
 
+#define BUNITAB_NORM
+#include "bunitab.h"
+
 #ifndef NULL
 #ifdef __cplusplus
 #define NULL	0
@@ -247,3 +251,390 @@ cpUcs4 utf8IteratorGetCurrCodePoint (struct utf8Iterator* iter, cpUcs4 errCh) {
 	}
 	return v;
 }
+
+/*
+ *  Decode the code point at the start of s, which has len bytes, and set
+ *  *adv to the length of its encoding.  Bytes which do not start a valid
+ *  sequence are decoded one at a time as UTF8_INVALID_BYTE_BASE + byte.
+ *  These values are beyond the range of Unicode, so they can be carried
+ *  along with code points and restored by utf8EncodeCodePoint.
+ */
+cpUcs4 utf8DecodeCodePoint (const unsigned char* s, int len, int* adv) {
+	cpUcs4 v;
+	unsigned int c;
+
+	if (NULL == s || len <= 0) {
+		*adv = 0;
+		return -1;
+	}
+	c = s[0];
+	*adv = 1;
+	if (c < 0x80) return (cpUcs4) c;
+	if (c < 0xC2 || c > 0xF4) return UTF8_INVALID_BYTE_BASE + c;
+	if (c < 0xE0) {
+		if (len < 2 || (s[1] & 0xC0) != 0x80) return UTF8_INVALID_BYTE_BASE + c;
+		*adv = 2;
+		return (cpUcs4) (((c & 0x1F) << 6) | (s[1] & 0x3F));
+	}
+	if (c < 0xF0) {
+		if (len < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) goto ErrMode;
+		v = (cpUcs4) (((c & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F));
+		if (v < 0x800) goto ErrMode;
+		*adv = 3;
+	} else {
+		if (len < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 ||
+		    (s[3] & 0xC0) != 0x80) goto ErrMode;
+		v = (cpUcs4) (((c & 0x07) << 18) | ((s[1] & 0x3F) << 12) |
+		              ((s[2] & 0x3F) << 6) | (s[3] & 0x3F));
+		if (v < 0x10000) goto ErrMode;
+		*adv = 4;
+	}
+	if (!isLegalUnicodeCodePoint (v)) {
+	ErrMode:;
+		*adv = 1;
+		return UTF8_INVALID_BYTE_BASE + c;
+	}
+	return v;
+}
+
+/*
+ *  Write the UTF-8 encoding of v to out, which must have room for 4 bytes,
+ *  and return its length.  Values decoded from invalid bytes by
+ *  utf8DecodeCodePoint are written back as those bytes.
+ */
+int utf8EncodeCodePoint (cpUcs4 v, unsigned char* out) {
+	if (v < 0x80) {
+		out[0] = (unsigned char) v;
+		return 1;
+	}
+	if (v >= UTF8_INVALID_BYTE_BASE) {
+		out[0] = (unsigned char) (v - UTF8_INVALID_BYTE_BASE);
+		return 1;
+	}
+	if (v < 0x800) {
+		out[0] = (unsigned char) ( (v >>  6)         + 0xc0);
+		out[1] = (unsigned char) ((        v & 0x3f) + 0x80);
+		return 2;
+	}
+	if (v < 0x10000) {
+		out[0] = (unsigned char) ( (v >> 12)         + 0xe0);
+		out[1] = (unsigned char) (((v >>  6) & 0x3f) + 0x80);
+		out[2] = (unsigned char) ((        v & 0x3f) + 0x80);
+		return 3;
+	}
+	out[0] = (unsigned char) ( (v >> 18)         + 0xf0);
+	out[1] = (unsigned char) (((v >> 12) & 0x3f) + 0x80);
+	out[2] = (unsigned char) (((v >>  6) & 0x3f) + 0x80);
+	out[3] = (unsigned char) ((        v & 0x3f) + 0x80);
+	return 4;
+}
+
+/*
+ *  Unicode normalization (UAX #15).  Input is decomposed code point by code
+ *  point into a segment buffer which holds everything since the last
+ *  starter (a code point with canonical combining class 0), with the
+ *  non-starters kept in canonical order by insertion.  When the next starter
+ *  arrives the segment is recomposed (for NFC) and written out.  The tables
+ *  in bunitab.h hold the combining classes, quick check properties and the
+ *  single level canonical decompositions; Hangul syllables are decomposed
+ *  and composed arithmetically.
+ */
+
+#define HANGUL_SBASE  (0xAC00L)
+#define HANGUL_LBASE  (0x1100L)
+#define HANGUL_VBASE  (0x1161L)
+#define HANGUL_TBASE  (0x11A7L)
+#define HANGUL_LCOUNT (19)
+#define HANGUL_VCOUNT (21)
+#define HANGUL_TCOUNT (28)
+#define HANGUL_NCOUNT (HANGUL_VCOUNT * HANGUL_TCOUNT)
+#define HANGUL_SCOUNT (HANGUL_LCOUNT * HANGUL_NCOUNT)
+
+static int normProp (cpUcs4 c) {
+	if (c < 0 || c >= BUNORM_LIMIT) return 0;
+	return buNormBlock[(buNormIndex[c >> BUNORM_SHIFT] << BUNORM_SHIFT) +
+	                   (c & ((1 << BUNORM_SHIFT) - 1))];
+}
+
+#define normCcc(c)   (buNormProp[normProp (c)][0])
+#define normFlags(c) (buNormProp[normProp (c)][1])
+
+static int normDecompose (cpUcs4 c, cpUcs4* d) {
+	int lo, hi, m, k;
+
+	if (c >= HANGUL_SBASE && c < HANGUL_SBASE + HANGUL_SCOUNT) {
+		c -= HANGUL_SBASE;
+		d[0] = HANGUL_LBASE + c / HANGUL_NCOUNT;
+		d[1] = HANGUL_VBASE + (c % HANGUL_NCOUNT) / HANGUL_TCOUNT;
+		if (0 == (c %= HANGUL_TCOUNT)) return 2;
+		d[2] = HANGUL_TBASE + c;
+		return 3;
+	}
+	if (normFlags (c) & BUNORM_NFD_NO) {
+		lo = 0;
+		hi = (int) (sizeof (buNormDecompKey) / sizeof (buNormDecompKey[0]));
+		while (lo < hi) {
+			m = (lo + hi) >> 1;
+			if (buNormDecompKey[m] < c) lo = m + 1;
+			else hi = m;
+		}
+		if (buNormDecompKey[lo] == c) {
+			k = normDecompose (buNormDecomp[lo][0], d);
+			if (buNormDecomp[lo][1]) k += normDecompose (buNormDecomp[lo][1], d + k);
+			return k;
+		}
+	}
+	d[0] = c;
+	return 1;
+}
+
+static cpUcs4 normCompose (cpUcs4 a, cpUcs4 b) {
+	int lo, hi, m;
+	const cpUcs4* p;
+
+	if (a >= HANGUL_LBASE && a < HANGUL_LBASE + HANGUL_LCOUNT &&
+	    b >= HANGUL_VBASE && b < HANGUL_VBASE + HANGUL_VCOUNT) {
+		return HANGUL_SBASE + ((a - HANGUL_LBASE) * HANGUL_VCOUNT +
+		                       (b - HANGUL_VBASE)) * HANGUL_TCOUNT;
+	}
+	if (a >= HANGUL_SBASE && a < HANGUL_SBASE + HANGUL_SCOUNT &&
+	    0 == (a - HANGUL_SBASE) % HANGUL_TCOUNT &&
+	    b > HANGUL_TBASE && b < HANGUL_TBASE + HANGUL_TCOUNT) {
+		return a + (b - HANGUL_TBASE);
+	}
+	lo = 0;
+	hi = (int) (sizeof (buNormComp) / sizeof (buNormComp[0]));
+	while (lo < hi) {
+		m = (lo + hi) >> 1;
+		p = buNormDecomp[buNormComp[m]];
+		if (p[0] < a || (p[0] == a && p[1] < b)) lo = m + 1;
+		else hi = m;
+	}
+	if (lo < (int) (sizeof (buNormComp) / sizeof (buNormComp[0]))) {
+		p = buNormDecomp[buNormComp[lo]];
+		if (p[0] == a && p[1] == b) return buNormDecompKey[buNormComp[lo]];
+	}
+	return -1;
+}
+
+/* Canonically compose a segment in place, returning its new length */
+static int normComposeSegment (cpUcs4* s, unsigned char* ccc, int qty) {
+	int i, o, st, last;
+	cpUcs4 c;
+
+	for (st = -1, last = 0, o = i = 0; i < qty; i++) {
+		if (st >= 0 && (o == st + 1 || (last != 0 && last < ccc[i])) &&
+		    (normFlags (s[i]) & BUNORM_NFC_MAYBE) &&
+		    0 <= (c = normCompose (s[st], s[i]))) {
+			s[st] = c;
+			continue;
+		}
+		if (0 == ccc[i]) st = o;
+		last = ccc[i];
+		s[o] = s[i];
+		ccc[o] = ccc[i];
+		o++;
+	}
+	return o;
+}
+
+static int normFlush (struct utf8Normalizer* n) {
+	unsigned char buf[UTF8_NORMALIZER_SEGMENT * 4];
+	int i, l, q;
+
+	if (0 == (q = n->qty)) return 0;
+	if (UTF8_NFC == n->form) q = normComposeSegment (n->seg, n->ccc, q);
+	for (l = i = 0; i < q; i++) l += utf8EncodeCodePoint (n->seg[i], buf + l);
+	n->qty = 0;
+	return (n->out (n->ctx, buf, l) < 0) ? -1 : 0;
+}
+
+/* Would the starter c compose with the segment (Hangul jamo, some vowel
+   signs)? */
+static int normJoins (const struct utf8Normalizer* n, cpUcs4 c) {
+	cpUcs4 s[UTF8_NORMALIZER_SEGMENT];
+	unsigned char ccc[UTF8_NORMALIZER_SEGMENT];
+	int q;
+
+	memcpy (s, n->seg, n->qty * sizeof (cpUcs4));
+	memcpy (ccc, n->ccc, n->qty);
+	q = normComposeSegment (s, ccc, n->qty);
+	return 0 == ccc[q - 1] && 0 <= normCompose (s[q - 1], c);
+}
+
+static int normPush (struct utf8Normalizer* n, cpUcs4 c) {
+	cpUcs4 d[BUNORM_MAX_DECOMP];
+	int i, j, k, cc;
+
+	k = normDecompose (c, d);
+	for (i = 0; i < k; i++) {
+		cc = normCcc (d[i]);
+		if (0 == cc) {
+			if (!(UTF8_NFC == n->form && n->qty > 0 &&
+			      n->qty < UTF8_NORMALIZER_SEGMENT &&
+			      (normFlags (d[i]) & BUNORM_NFC_MAYBE) && normJoins (n, d[i]))) {
+				if (normFlush (n) < 0) return -1;
+			}
+			j = n->qty;
+		} else {
+			/* Overlong runs of non-starters are split (see UAX #15, "Stream
+			   Safe Text Format"); conformant text never has more than 30 */
+			if (n->qty >= UTF8_NORMALIZER_SEGMENT && normFlush (n) < 0) return -1;
+			for (j = n->qty; j > 0 && n->ccc[j-1] > cc; j--) {
+				n->seg[j] = n->seg[j-1];
+				n->ccc[j] = n->ccc[j-1];
+			}
+		}
+		n->seg[j] = d[i];
+		n->ccc[j] = (unsigned char) cc;
+		n->qty++;
+	}
+	return 0;
+}
+
+/* Length of an incomplete but possibly valid sequence at the end of s */
+static int normPartial (const unsigned char* s, int len) {
+	int k;
+	unsigned char c;
+
+	for (k = 1; k <= 3 && k <= len; k++) {
+		c = s[len - k];
+		if ((c & 0xC0) == 0x80) continue;
+		if (c >= 0xC2 && c <= 0xF4 && k < 2 + (c >= 0xE0) + (c >= 0xF0)) return k;
+		return 0;
+	}
+	return 0;
+}
+
+/*
+ *  Start normalizing to the given form (UTF8_NFC or UTF8_NFD).  The output
+ *  is passed to out in pieces as it becomes final; if out returns a negative
+ *  value the normalization is aborted.  Returns 0 or a negative value on
+ *  error.
+ */
+int utf8NormalizerInit (struct utf8Normalizer* n, int form, utf8NormalizerOutput out, void* ctx) {
+	if (NULL == n || NULL == out || (UTF8_NFC != form && UTF8_NFD != form)) return -__LINE__;
+	n->form = form;
+	n->out  = out;
+	n->ctx  = ctx;
+	n->qty  = n->plen = 0;
+	return 0;
+}
+
+/*
+ *  Feed the next len bytes of input to a normalizer.  A sequence may be
+ *  split between successive calls.  Bytes which are not valid UTF-8 are
+ *  passed through unchanged.  Returns 0 or a negative value on error.
+ */
+int utf8NormalizerFeed (struct utf8Normalizer* n, const unsigned char* data, int len) {
+	unsigned char t[8];
+	int i, j, k, tl, end;
+
+	if (NULL == n || NULL == n->out || NULL == data || len < 0) return -__LINE__;
+	i = 0;
+
+	/* Finish off a sequence left incomplete by the previous call */
+	while (n->plen > 0) {
+		for (tl = 0; tl < n->plen; tl++) t[tl] = n->part[tl];
+		for (k = 0; k < 4 - n->plen && k < len - i; k++) t[tl++] = data[i + k];
+		if (normPartial (t, tl) == tl) {
+			for (k = n->plen; k < tl; k++) n->part[k] = t[k];
+			n->plen = tl;
+			return 0;
+		}
+		if (normPush (n, utf8DecodeCodePoint (t, tl, &k)) < 0) return -__LINE__;
+		if (k >= n->plen) {
+			i += k - n->plen;
+			n->plen = 0;
+		} else {
+			for (j = k; j < n->plen; j++) n->part[j - k] = n->part[j];
+			n->plen -= k;
+		}
+	}
+
+	end = len - normPartial (data + i, len - i);
+	while (i < end) {
+		if (data[i] < 0x80) {
+			/* A run of ASCII, except for its last character which may be
+			   followed by combining marks, is already normalized. */
+			for (j = i + 1; j < end && data[j] < 0x80; j++) {}
+			if (j - i > 1) {
+				if (normFlush (n) < 0 || n->out (n->ctx, data + i, j - 1 - i) < 0)
+					return -__LINE__;
+				i = j - 1;
+			}
+		}
+		if (normPush (n, utf8DecodeCodePoint (data + i, end - i, &k)) < 0) return -__LINE__;
+		i += k;
+	}
+
+	for (n->plen = 0; i < len; i++) n->part[n->plen++] = data[i];
+	return 0;
+}
+
+/*
+ *  Flush the remaining output of a normalizer.  An incomplete sequence at
+ *  the end of the input is passed through.  The normalizer may then be fed
+ *  a new input.  Returns 0 or a negative value on error.
+ */
+int utf8NormalizerFinish (struct utf8Normalizer* n) {
+	int i, k;
+
+	if (NULL == n || NULL == n->out) return -__LINE__;
+	for (i = 0; i < n->plen; i++) {
+		if (normPush (n, utf8DecodeCodePoint (n->part + i, 1, &k)) < 0) return -__LINE__;
+	}
+	n->plen = 0;
+	if (normFlush (n) < 0) return -__LINE__;
+	return 0;
+}
+
+struct normCompare {
+	const unsigned char* data;
+	int len;
+};
+
+static int normCompareOut (void* ctx, const unsigned char* data, int len) {
+	struct normCompare* c = (struct normCompare*) ctx;
+	if (len > c->len || 0 != memcmp (c->data, data, len)) return -1;
+	c->data += len;
+	c->len -= len;
+	return 0;
+}
+
+/*
+ *  Determine whether data is in the normalization form (UTF8_NFC or
+ *  UTF8_NFD).  Returns 1 if it is, 0 if it is not, and a negative value if
+ *  the parameters are invalid.  The quick check properties decide almost
+ *  all inputs in a single pass; the few that may or may not be normalized
+ *  are compared against their normalization as it is produced.  No memory
+ *  is allocated.
+ */
+int utf8IsNormalized (const unsigned char* data, int len, int form) {
+	struct utf8Normalizer n;
+	struct normCompare c;
+	int i, k, p, cc, last, maybe, no;
+
+	if (NULL == data || len < 0 || (UTF8_NFC != form && UTF8_NFD != form)) return -__LINE__;
+	no = (UTF8_NFC == form) ? BUNORM_NFC_NO : BUNORM_NFD_NO;
+
+	for (maybe = last = i = 0; i < len; i += k) {
+		if (data[i] < 0x80) {
+			last = 0;
+			k = 1;
+			continue;
+		}
+		p = normProp (utf8DecodeCodePoint (data + i, len - i, &k));
+		cc = buNormProp[p][0];
+		if ((cc != 0 && last > cc) || (buNormProp[p][1] & no)) return 0;
+		if (buNormProp[p][1] & BUNORM_NFC_MAYBE) maybe = 1;
+		last = cc;
+	}
+	if (UTF8_NFD == form || !maybe) return 1;
+
+	c.data = data;
+	c.len = len;
+	utf8NormalizerInit (&n, form, normCompareOut, &c);
+	if (utf8NormalizerFeed (&n, data, len) < 0 || utf8NormalizerFinish (&n) < 0) return 0;
+	return 0 == c.len;
+}
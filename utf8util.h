@@ -55,6 +55,35 @@ extern cpUcs4 utf8IteratorGetNextCodePoint (struct utf8Iterator* iter, cpUcs4 er
 extern cpUcs4 utf8IteratorGetCurrCodePoint (struct utf8Iterator* iter, cpUcs4 errCh);
 extern int utf8ScanBackwardsForCodePoint (unsigned char* msg, int len, int pos, cpUcs4* out);
 
+/* Bytes that do not start a valid sequence decode to UTF8_INVALID_BYTE_BASE + byte */
+#define UTF8_INVALID_BYTE_BASE (0x110000L)
+
+extern cpUcs4 utf8DecodeCodePoint (const unsigned char* s, int len, int* adv);
+extern int utf8EncodeCodePoint (cpUcs4 v, unsigned char* out);
+
+/* Unicode normalization */
+#define UTF8_NFC (0)
+#define UTF8_NFD (1)
+
+#define UTF8_NORMALIZER_SEGMENT (64)
+
+typedef int (* utf8NormalizerOutput) (void* ctx, const unsigned char* data, int len);
+
+struct utf8Normalizer {
+	int                 	form;
+	utf8NormalizerOutput	out;
+	void*               	ctx;
+	int                 	qty, plen;
+	cpUcs4              	seg[UTF8_NORMALIZER_SEGMENT];
+	unsigned char       	ccc[UTF8_NORMALIZER_SEGMENT];
+	unsigned char       	part[4];
+};
+
+extern int utf8IsNormalized (const unsigned char* data, int len, int form);
+extern int utf8NormalizerInit (struct utf8Normalizer* n, int form, utf8NormalizerOutput out, void* ctx);
+extern int utf8NormalizerFeed (struct utf8Normalizer* n, const unsigned char* data, int len);
+extern int utf8NormalizerFinish (struct utf8Normalizer* n);
+
 #ifdef __cplusplus
 }
 #endif